@@ -0,0 +1,834 @@
+/*
+ * SolarBench.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Switch-time benchmark: runs the firmware (host build, see SolarHost.h) over a fixed corpus of
+ * site-years and reports how far switch-on, the two dim steps and switch-off land from where
+ * they should, per month. Results can be stored as a baseline and compared against, so a change
+ * to the algorithm or its constants is judged on the same numbers every time.
+ *   gcc -O2 -I. -o SolarBench SolarBench.c SolarHost.c SolarTrace.c -lm
+ *   ./SolarBench -b SolarBench.baseline
+ * SolarBench.baseline holds the numbers of the configuration as committed. A change that is meant
+ * to move them commits a new one (-w SolarBench.baseline) along with it.
+ *
+ * Usage:
+ *   SolarBench [options] [extra.sltr ...]
+ *
+ * Options:
+ *   -b file        Compare against a baseline, exit code 1 on a regression
+ *   -w file        Write the results as a new baseline
+ *   -T minutes     Regression tolerance on the p95 errors (default 2)
+ *   -x             Leave out the built-in corpus, only run the trace files given
+ *   -g directory   Write the built-in corpus as trace files (site name.sltr), for the other tools
+ *   -o HH:MM       Fixed switch-off target in stead of the seasonal one below
+ *   -D             Apply EU summer time to the extra traces as well (the corpus knows its sites)
+ *   -W days        Warm-up days after power-up that are not counted (default 2)
+ *   -j processes   Sites run in parallel (default: number of processors)
+ *
+ * The built-in corpus is six site-years (2025, one minute samples) generated from a sun position
+ * model and a seeded weather model: cloud cover that changes from day to day and within the day,
+ * sensor noise and the odd car headlight at night. It is deterministic, every run of every build
+ * sees exactly the same readings. Extra traces (recorded logs, see SolarTraceConvert.c) are run
+ * along with it, their site location comes from the trace header.
+ *
+ * What is measured, per night (noon to noon, in the month of the evening), in minutes:
+ *   switch-on    from sunset (sun centre at -0.833 degrees)
+ *   dim 1/2      from sunset plus AFTERGLOW_LIMITATION_THRESHOLD1/2 minutes, the intended step time
+ *   switch-off   start of the fade-out, from the target clock time. Unless set with -o, the target
+ *                follows the header of SolarCounter-Tiny10.c: 23:15 at the winter solstice to
+ *                00:22 at the summer solstice (the middle of 23:00-23:30 and 24:00-00:45), local
+ *                clock time.
+ * The p50 is the signed error (bias), p95 and max are of the absolute error. Nights without a
+ * switch-on are missed, nights with more than one are duplicates (the pre-dawn light doesn't count
+ * as a switch-on). Lamp-hours is the time the boost was enabled, over the whole corpus.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <avr/io.h>
+
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarCounter.h"
+#include "SolarHost.h"
+#include "SolarTrace.h"
+
+#define		MONTHS					12
+#define		SUNSET_ELEVATION		-0.833	// Degrees, refraction and the radius of the sun
+#define		CORPUS_START			1735689600	// 2025-01-01 00:00 UTC
+#define		CORPUS_DAYS				366		// A year, plus the last night of it
+#define		CORPUS_INTERVAL_S		60
+
+enum { EVENT_ON, EVENT_DIM1, EVENT_DIM2, EVENT_OFF, EVENTS };
+
+static const char	*EventNames[EVENTS] = { "switch-on", "dim-1", "dim-2", "switch-off" };
+static const char	*MonthNames[MONTHS + 1] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+												"Jul", "Aug", "Sep", "Oct", "Nov", "Dec", "all" };
+
+typedef struct
+{
+	const char	*Name;
+	double		Latitude;
+	double		Longitude;
+	int16_t		UtcOffsetMin;		// Standard time
+	bool		SummerTime;			// EU rules
+} BenchSite;
+
+// Spread over latitude and over the position in the time zone:
+static const BenchSite	Corpus[] =
+{
+	{ "Nuenen",		51.4727,	  5.5519,	 60,	true },
+	{ "Edinburgh",	55.9533,	 -3.1883,	  0,	true },
+	{ "Warsaw",		52.2297,	 21.0122,	 60,	true },
+	{ "Munich",		48.1372,	 11.5755,	 60,	true },
+	{ "Madrid",		40.4168,	 -3.7038,	 60,	true },
+	{ "Athens",		37.9838,	 23.7275,	120,	true },
+};
+#define		CORPUS_SITES		(sizeof(Corpus) / sizeof(Corpus[0]))
+
+typedef struct
+{
+	uint8_t		Month;
+	uint8_t		Ons;				// Times the boost was switched on
+	bool		Counted;			// Has a sunset, after the warm-up, and the trace covers all of it
+	float		Error[EVENTS];		// Minutes, NAN if it didn't happen
+} BenchNight;
+
+// One per site, in memory shared with the process that runs it:
+typedef struct
+{
+	int			Status;				// 0 when the run finished
+	uint32_t	Nights;
+	double		LampHours;
+	BenchNight	Night[];
+} BenchResult;
+
+typedef struct
+{
+	const SolarTraceHeader	*Header;
+	bool					SummerTime;
+	BenchResult				*Result;
+	int64_t					FirstDay;		// Local day number of the first noon-to-noon night
+	double					*Sunset;		// Unix time per night, NAN for none
+	double					*TargetOff;		// Unix time per night
+	SolarHostState			Previous;
+	uint64_t				LastMs;
+	uint64_t				LitMs;
+} BenchRun;
+
+typedef struct
+{
+	bool		Fixed;				// -o given
+	int32_t		OffMinute;			// Minutes from midnight, negative for the evening before
+	bool		SummerTime;			// -D
+	uint32_t	WarmUpDays;
+} BenchOptions;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Sun and clock
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Elevation of the sun centre in degrees, low precision formulas of the Astronomical Almanac (0.01 degrees):
+static double SunElevation(double Latitude, double Longitude, double UnixTime)
+{
+	double	Days = UnixTime / 86400.0 - 10957.5;	// Since J2000.0
+	double	Anomaly = (357.528 + 0.9856003 * Days) * M_PI / 180.0;
+	double	Ecliptic = (280.460 + 0.9856474 * Days + 1.915 * sin(Anomaly) + 0.020 * sin(2.0 * Anomaly)) * M_PI / 180.0;
+	double	Obliquity = (23.439 - 0.0000004 * Days) * M_PI / 180.0;
+	double	Ascension = atan2(cos(Obliquity) * sin(Ecliptic), cos(Ecliptic));
+	double	Declination = asin(sin(Obliquity) * sin(Ecliptic));
+	double	Sidereal = fmod(280.46061837 + 360.98564736629 * Days, 360.0) * M_PI / 180.0;
+	double	HourAngle = Sidereal + Longitude * M_PI / 180.0 - Ascension;
+	double	Phi = Latitude * M_PI / 180.0;
+	
+	return asin(sin(Phi) * sin(Declination) + cos(Phi) * cos(Declination) * cos(HourAngle)) * 180.0 / M_PI;
+}
+
+// First time after From (unix) the sun goes below the sunset elevation, within a day. NAN if it doesn't.
+static double FindSunset(double Latitude, double Longitude, double From)
+{
+	double	Before = From;
+	double	After;
+	
+	if(SunElevation(Latitude, Longitude, Before) < SUNSET_ELEVATION)
+		return NAN; // Already down at noon: polar night
+	for(After = From + 60.0; After < From + 86400.0; After += 60.0)
+	{
+		if(SunElevation(Latitude, Longitude, After) < SUNSET_ELEVATION)
+		{
+			for(int Step = 0; Step < 12; Step++) // Bisect to well under a second
+			{
+				double	Middle = (Before + After) / 2.0;
+				if(SunElevation(Latitude, Longitude, Middle) < SUNSET_ELEVATION)
+					After = Middle;
+				else
+					Before = Middle;
+			}
+			return After;
+		}
+		Before = After;
+	}
+	return NAN;
+}
+
+// Last Sunday of a month (March or October), 01:00 UTC:
+static int64_t EuChangeOver(int Year, int Month)
+{
+	struct tm	Clock = { .tm_year = Year - 1900, .tm_mon = Month, .tm_mday = 31, .tm_hour = 1 };
+	int64_t		Time = (int64_t)timegm(&Clock);
+	
+	gmtime_r(&(time_t){ (time_t)Time }, &Clock);
+	return Time - (int64_t)Clock.tm_wday * 86400;
+}
+
+// Site clock time for a unix time, as seconds since the epoch:
+static int64_t LocalTime(const SolarTraceHeader *Header, bool SummerTime, int64_t Time)
+{
+	int64_t	Local = Time + Header->UtcOffsetMin * 60;
+	
+	if(SummerTime)
+	{
+		struct tm	Clock;
+		gmtime_r(&(time_t){ (time_t)Time }, &Clock);
+		if( (Time >= EuChangeOver(Clock.tm_year + 1900, 2)) && (Time < EuChangeOver(Clock.tm_year + 1900, 9)) )
+			Local += 3600;
+	}
+	return Local;
+}
+
+static int64_t FloorDiv(int64_t Value, int64_t Divisor)
+{
+	return (Value >= 0) ? Value / Divisor : -((-Value + Divisor - 1) / Divisor);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Built-in corpus
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static uint64_t SplitMix(uint64_t *State)
+{
+	uint64_t	Value = (*State += 0x9E3779B97F4A7C15ull);
+	
+	Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+	return Value ^ (Value >> 31);
+}
+
+static double Uniform(uint64_t *State)
+{
+	return (SplitMix(State) >> 11) / 9007199254740992.0;
+}
+
+/*
+  Sensor reading for a sun elevation: a logistic step from night to day, centred just above the
+  horizon. The panel saturates the input well before that in daylight, even under heavy cloud, but
+  clouds move the point where it crosses DARK_THRESHOLD: about -2 degrees under a clear sky, about
+  +1 degree under the darkest overcast, so on a dark day the lights come on earlier, as they do
+  in the field.
+*/
+static uint8_t SensorReading(double Elevation, double Light)
+{
+	double	Value = 2.5 * 255.0 * Light / (1.0 + exp(-(Elevation - 0.5)));
+	
+	return (Value >= 255.0) ? 255 : (Value <= 0.0) ? 0 : (uint8_t)Value;
+}
+
+static uint8_t *GenerateSite(uint32_t Index, SolarTraceHeader *Header)
+{
+	const BenchSite	*Site = &Corpus[Index];
+	uint64_t		Count = (uint64_t)CORPUS_DAYS * 86400 / CORPUS_INTERVAL_S;
+	uint8_t			*Samples = malloc((size_t)Count);
+	uint64_t		Random = 0x5EED0000ull + Index;
+	double			Cloud = 1.0;
+	double			Passing = 1.0;		// Clouds passing within the day, changes every 10 minutes
+	
+	if(Samples == NULL)
+		return NULL;
+	
+	memset(Header, 0, sizeof(*Header));
+	Header->SampleIntervalS = CORPUS_INTERVAL_S;
+	Header->SupplyVoltageMv = (uint32_t)SUPPLY_VOLTAGE_MV;
+	Header->LatitudeE6 = (int32_t)lround(Site->Latitude * 1e6);
+	Header->LongitudeE6 = (int32_t)lround(Site->Longitude * 1e6);
+	Header->UtcOffsetMin = Site->UtcOffsetMin;
+	Header->SiteId = (uint16_t)(Index + 1);
+	Header->StartTime = CORPUS_START - Site->UtcOffsetMin * 60; // Local midnight
+	Header->SampleCount = Count;
+	strncpy(Header->SiteName, Site->Name, sizeof(Header->SiteName) - 1);
+	
+	for(uint64_t Sample = 0; Sample < Count; Sample++)
+	{
+		double	Time = (double)Header->StartTime + (double)(Sample * CORPUS_INTERVAL_S);
+		double	Elevation = SunElevation(Site->Latitude, Site->Longitude, Time);
+		double	Light;
+		
+		if( (Sample % (86400 / CORPUS_INTERVAL_S)) == 0 )
+		{ // New day: clear, broken or overcast, with some memory of yesterday
+			double	Weather = Uniform(&Random);
+			if(Weather < 0.35)
+				Cloud = Cloud * 0.5 + 0.5 * (0.85 + 0.15 * Uniform(&Random));
+			else if(Weather < 0.70)
+				Cloud = 0.45 + 0.35 * Uniform(&Random);
+			else
+				Cloud = 0.20 + 0.20 * Uniform(&Random);
+		}
+		if( (Sample % (600 / CORPUS_INTERVAL_S)) == 0 )
+			Passing = 1.0 - (1.0 - Cloud) * 0.6 * Uniform(&Random);
+		
+		Light = Cloud * Passing * (0.97 + 0.06 * Uniform(&Random));
+		if(Light > 1.0)
+			Light = 1.0;
+		Samples[Sample] = SensorReading(Elevation, Light);
+		
+		// Now and then a car passes the sensor at night:
+		if( (Elevation < -6.0) && (Uniform(&Random) < 1.0 / 3000.0) )
+			Samples[Sample] = (uint8_t)(60 + 80 * Uniform(&Random));
+	}
+	return Samples;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Running a site
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static int64_t NightOf(const BenchRun *Run, uint64_t TimeMs)
+{
+	int64_t	Local = LocalTime(Run->Header, Run->SummerTime, Run->Header->StartTime + (int64_t)(TimeMs / 1000));
+	
+	return FloorDiv(Local - 12 * 3600, 86400) - Run->FirstDay;
+}
+
+static void SetError(BenchNight *Night, int Event, double Error)
+{
+	if(isnan(Night->Error[Event]))
+		Night->Error[Event] = (float)Error;
+}
+
+static void OnSample(void *Context, uint64_t TimeMs, uint8_t Sample)
+{
+	BenchRun		*Run = Context;
+	SolarHostState	State;
+	int64_t			Night = NightOf(Run, TimeMs);
+	double			Time = (double)Run->Header->StartTime + TimeMs / 1000.0;
+	BenchNight		*Record;
+	
+	(void)Sample;
+	SolarHost_GetState(&State);
+	if(Run->Previous.Boost)
+		Run->LitMs += TimeMs - Run->LastMs;
+	Run->LastMs = TimeMs;
+	
+	if( (Night >= 0) && ((uint64_t)Night < Run->Result->Nights) )
+	{
+		Record = &Run->Result->Night[Night];
+		
+		if(State.Boost && !Run->Previous.Boost && ((State.OperationalFlags & FLAG_MORNING_LIGHT) == 0))
+		{
+			Record->Ons++;
+			SetError(Record, EVENT_ON, (Time - Run->Sunset[Night]) / 60.0);
+		}
+		if( ((State.OperationalFlags & (FLAG_LIGHTISON | FLAG_SLOWTURNOFF)) == FLAG_LIGHTISON) && (State.Duty != Run->Previous.Duty) )
+		{
+			if(State.Duty == AFTERGLOW_LIMITATION_PWM1_INTERNAL)
+				SetError(Record, EVENT_DIM1, (Time - Run->Sunset[Night]) / 60.0 - AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL);
+			else if(State.Duty == AFTERGLOW_LIMITATION_PWM2_INTERNAL)
+				SetError(Record, EVENT_DIM2, (Time - Run->Sunset[Night]) / 60.0 - AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL);
+		}
+		if( (State.OperationalFlags & ~Run->Previous.OperationalFlags & FLAG_SLOWTURNOFF) != 0 )
+			SetError(Record, EVENT_OFF, (Time - Run->TargetOff[Night]) / 60.0);
+	}
+	Run->Previous = State;
+}
+
+// Switch-off target for the night starting on the local day Day, minutes from the midnight after it:
+static double TargetMinute(const BenchOptions *Options, int64_t Day)
+{
+	struct tm	Clock;
+	
+	if(Options->Fixed)
+		return Options->OffMinute;
+	gmtime_r(&(time_t){ (time_t)(Day * 86400) }, &Clock);
+	return -45.0 + 67.5 * (1.0 - cos(2.0 * M_PI * (Clock.tm_yday - 354) / 365.25)) / 2.0;
+}
+
+static void RunSite(const SolarTrace *Trace, bool SummerTime, const BenchOptions *Options, BenchResult *Result)
+{
+	const SolarTraceHeader	*Header = Trace->Header;
+	BenchRun				Run;
+	double					Latitude = Header->LatitudeE6 / 1e6;
+	double					Longitude = Header->LongitudeE6 / 1e6;
+	int64_t					End = Header->StartTime + (int64_t)(Header->SampleCount * Header->SampleIntervalS);
+	
+	memset(&Run, 0, sizeof(Run));
+	Run.Header = Header;
+	Run.SummerTime = SummerTime;
+	Run.Result = Result;
+	Run.FirstDay = FloorDiv(LocalTime(Header, SummerTime, Header->StartTime) - 12 * 3600, 86400);
+	Run.Sunset = calloc(Result->Nights, sizeof(double));
+	Run.TargetOff = calloc(Result->Nights, sizeof(double));
+	
+	for(uint32_t Night = 0; Night < Result->Nights; Night++)
+	{
+		int64_t		Day = Run.FirstDay + Night;
+		int64_t		Noon = Day * 86400 + 12 * 3600;		// Local
+		int64_t		Approximate = Noon - Header->UtcOffsetMin * 60;
+		int64_t		Offset = LocalTime(Header, SummerTime, Approximate) - Approximate;	// With summer time, that day
+		struct tm	Clock;
+		
+		Run.Sunset[Night] = FindSunset(Latitude, Longitude, (double)(Noon - Offset));
+		Run.TargetOff[Night] = (double)(Noon + 12 * 3600 - Offset) + TargetMinute(Options, Day) * 60.0;
+		
+		gmtime_r(&(time_t){ (time_t)(Day * 86400) }, &Clock);
+		Result->Night[Night].Month = (uint8_t)Clock.tm_mon;
+		Result->Night[Night].Counted = !isnan(Run.Sunset[Night]) && (Night >= Options->WarmUpDays) && (Noon + 86400 - Offset <= End);
+		for(int Event = 0; Event < EVENTS; Event++)
+			Result->Night[Night].Error[Event] = NAN;
+	}
+	
+	SolarHost_ReplayEvents(Trace, OnSample, &Run, NULL);
+	Result->LampHours = Run.LitMs / 3600000.0;
+	free(Run.Sunset);
+	free(Run.TargetOff);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Statistics and the baseline
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef struct
+{
+	uint32_t	Count;
+	double		Median;				// Signed
+	double		P95;				// Absolute
+	double		Max;				// Absolute
+} BenchStat;
+
+typedef struct
+{
+	BenchStat	Stat[EVENTS][MONTHS + 1];	// The last "month" is the whole year
+	uint32_t	Nights;
+	uint32_t	Missed;
+	uint32_t	Duplicate;
+	double		LampHours;
+} BenchSummary;
+
+static int CompareFloat(const void *First, const void *Second)
+{
+	float	A = *(const float *)First;
+	float	B = *(const float *)Second;
+	
+	return (A > B) - (A < B);
+}
+
+static double Percentile(const float *Sorted, uint32_t Count, double Fraction)
+{
+	uint32_t	Rank = (uint32_t)ceil(Count * Fraction);
+	
+	return Sorted[(Rank == 0) ? 0 : Rank - 1];
+}
+
+static void Summarise(BenchResult **Results, uint32_t Sites, BenchSummary *Summary)
+{
+	uint32_t	Total = 0;
+	float		*Signed;
+	float		*Absolute;
+	
+	memset(Summary, 0, sizeof(*Summary));
+	for(uint32_t Site = 0; Site < Sites; Site++)
+		Total += Results[Site]->Nights;
+	Signed = malloc((Total + 1) * sizeof(float));
+	Absolute = malloc((Total + 1) * sizeof(float));
+	
+	for(uint32_t Site = 0; Site < Sites; Site++)
+	{
+		Summary->LampHours += Results[Site]->LampHours;
+		for(uint32_t Night = 0; Night < Results[Site]->Nights; Night++)
+		{
+			const BenchNight	*Record = &Results[Site]->Night[Night];
+			if(!Record->Counted)
+				continue;
+			Summary->Nights++;
+			if(Record->Ons == 0)
+				Summary->Missed++;
+			else if(Record->Ons > 1)
+				Summary->Duplicate++;
+		}
+	}
+	
+	for(int Event = 0; Event < EVENTS; Event++)
+	{
+		for(uint32_t Month = 0; Month <= MONTHS; Month++)
+		{
+			BenchStat	*Stat = &Summary->Stat[Event][Month];
+			uint32_t	Count = 0;
+			
+			for(uint32_t Site = 0; Site < Sites; Site++)
+			{
+				for(uint32_t Night = 0; Night < Results[Site]->Nights; Night++)
+				{
+					const BenchNight	*Record = &Results[Site]->Night[Night];
+					if( !Record->Counted || isnan(Record->Error[Event]) || ((Month < MONTHS) && (Record->Month != Month)) )
+						continue;
+					Signed[Count] = Record->Error[Event];
+					Absolute[Count] = fabsf(Record->Error[Event]);
+					Count++;
+				}
+			}
+			Stat->Count = Count;
+			if(Count == 0)
+				continue;
+			qsort(Signed, Count, sizeof(float), CompareFloat);
+			qsort(Absolute, Count, sizeof(float), CompareFloat);
+			Stat->Median = Percentile(Signed, Count, 0.50);
+			Stat->P95 = Percentile(Absolute, Count, 0.95);
+			Stat->Max = Absolute[Count - 1];
+		}
+	}
+	free(Signed);
+	free(Absolute);
+}
+
+/*
+  Baseline file, plain text so a diff of it in a commit shows what changed:
+    event month count p50 p95 max
+    nights counted missed duplicate
+    lamp-hours value
+*/
+static bool WriteBaseline(const char *Path, const BenchSummary *Summary, const char *Corpus)
+{
+	FILE	*File = fopen(Path, "w");
+	
+	if(File == NULL)
+		return false;
+	fprintf(File, "# SolarBench baseline: %s\n", Corpus);
+	fprintf(File, "# event month count p50 p95 max (minutes)\n");
+	for(int Event = 0; Event < EVENTS; Event++)
+	{
+		for(uint32_t Month = 0; Month <= MONTHS; Month++)
+		{
+			const BenchStat	*Stat = &Summary->Stat[Event][Month];
+			if(Stat->Count != 0)
+				fprintf(File, "%s %s %u %.1f %.1f %.1f\n", EventNames[Event], MonthNames[Month],
+						Stat->Count, Stat->Median, Stat->P95, Stat->Max);
+		}
+	}
+	fprintf(File, "nights %u %u %u\n", Summary->Nights, Summary->Missed, Summary->Duplicate);
+	fprintf(File, "lamp-hours %.1f\n", Summary->LampHours);
+	return fclose(File) == 0;
+}
+
+static int Lookup(const char **Names, int Count, const char *Name)
+{
+	for(int Index = 0; Index < Count; Index++)
+		if(strcmp(Names[Index], Name) == 0)
+			return Index;
+	return -1;
+}
+
+static bool ReadBaseline(const char *Path, BenchSummary *Summary)
+{
+	FILE	*File = fopen(Path, "r");
+	char	Line[256];
+	
+	if(File == NULL)
+		return false;
+	memset(Summary, 0, sizeof(*Summary));
+	while(fgets(Line, sizeof(Line), File) != NULL)
+	{
+		char		Event[32];
+		char		Month[8];
+		BenchStat	Stat;
+		
+		if(Line[0] == '#')
+			continue;
+		if(sscanf(Line, "%31s %7s %u %lf %lf %lf", Event, Month, &Stat.Count, &Stat.Median, &Stat.P95, &Stat.Max) == 6)
+		{
+			int	EventIndex = Lookup(EventNames, EVENTS, Event);
+			int	MonthIndex = Lookup(MonthNames, MONTHS + 1, Month);
+			if( (EventIndex >= 0) && (MonthIndex >= 0) )
+				Summary->Stat[EventIndex][MonthIndex] = Stat;
+		}
+		else if(sscanf(Line, "nights %u %u %u", &Summary->Nights, &Summary->Missed, &Summary->Duplicate) == 3)
+			;
+		else
+			sscanf(Line, "lamp-hours %lf", &Summary->LampHours);
+	}
+	fclose(File);
+	return true;
+}
+
+// Prints the results, with the baseline next to them if there is one. Returns the number of regressions.
+static uint32_t Report(const BenchSummary *Summary, const BenchSummary *Baseline, double Tolerance)
+{
+	uint32_t	Regressions = 0;
+	
+	printf("Event       Month  nights     p50     p95     max%s\n", (Baseline != NULL) ? "   base p95  change" : "");
+	for(int Event = 0; Event < EVENTS; Event++)
+	{
+		for(uint32_t Month = 0; Month <= MONTHS; Month++)
+		{
+			const BenchStat	*Stat = &Summary->Stat[Event][Month];
+			
+			if(Stat->Count == 0)
+				continue;
+			printf("%-11s %-5s %7u %+7.1f %7.1f %7.1f", EventNames[Event], MonthNames[Month], Stat->Count, Stat->Median, Stat->P95, Stat->Max);
+			if( (Baseline != NULL) && (Baseline->Stat[Event][Month].Count != 0) )
+			{
+				double	Change = Stat->P95 - Baseline->Stat[Event][Month].P95;
+				bool	Worse = Change > Tolerance;
+				printf("   %8.1f %+7.1f%s", Baseline->Stat[Event][Month].P95, Change, Worse ? "  REGRESSION" : "");
+				Regressions += Worse;
+			}
+			printf("\n");
+		}
+	}
+	
+	printf("\n%u nights, %u missed, %u duplicate, %.1f lamp-hours", Summary->Nights, Summary->Missed, Summary->Duplicate, Summary->LampHours);
+	if(Baseline != NULL)
+	{
+		printf(" (baseline: %u missed, %u duplicate, %.1f lamp-hours)", Baseline->Missed, Baseline->Duplicate, Baseline->LampHours);
+		if( (Summary->Missed > Baseline->Missed) || (Summary->Duplicate > Baseline->Duplicate) )
+		{
+			printf("  REGRESSION");
+			Regressions++;
+		}
+	}
+	printf("\n");
+	return Regressions;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Main
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: SolarBench [-b baseline] [-w baseline] [-T minutes] [-x] [-g directory] [-o HH:MM] [-D] [-W days] [-j processes] [extra.sltr ...]\n");
+}
+
+// Runs one site in a child process, the result goes into shared memory:
+static pid_t StartSite(uint32_t Site, char **Paths, const BenchOptions *Options, const char *Directory, BenchResult *Result)
+{
+	pid_t	Child = fork();
+	
+	if(Child != 0)
+		return Child;
+	
+	if(Site < CORPUS_SITES)
+	{
+		SolarTraceHeader	Header;
+		SolarTrace			Trace = { .Header = &Header };
+		uint8_t				*Samples = GenerateSite(Site, &Header);
+		
+		if(Samples == NULL)
+			_exit(1);
+		if(Directory != NULL)
+		{
+			char	Path[4096];
+			snprintf(Path, sizeof(Path), "%s/%s.sltr", Directory, Corpus[Site].Name);
+			if(SolarTrace_Write(Path, &Header, SOLAR_TRACE_ENC_DELTA | SOLAR_TRACE_ENC_RLE, Samples, Header.SampleCount) != SOLAR_TRACE_OK)
+				fprintf(stderr, "%s: %s\n", Path, strerror(errno));
+		}
+		// Run it raw from memory, SolarTrace_Write() filled in the rest of the header if it was called:
+		Header.Encoding = SOLAR_TRACE_ENC_RAW;
+		Header.PayloadSize = Header.SampleCount;
+		Trace.Payload = Samples;
+		RunSite(&Trace, Corpus[Site].SummerTime, Options, Result);
+	}
+	else
+	{
+		SolarTrace	Trace;
+		int			Error = SolarTrace_Open(&Trace, Paths[Site - CORPUS_SITES]);
+		
+		if(Error != SOLAR_TRACE_OK)
+		{
+			fprintf(stderr, "%s: %s\n", Paths[Site - CORPUS_SITES], SolarTrace_ErrorString(Error));
+			_exit(1);
+		}
+		RunSite(&Trace, Options->SummerTime, Options, Result);
+	}
+	Result->Status = 0;
+	_exit(0);
+}
+
+// Nights to keep room for: every local day the trace touches, plus one
+static uint32_t NightsOf(uint32_t Site, char **Paths)
+{
+	SolarTrace	Trace;
+	uint32_t	Nights;
+	
+	if(Site < CORPUS_SITES)
+		return CORPUS_DAYS + 1;
+	if(SolarTrace_Open(&Trace, Paths[Site - CORPUS_SITES]) != SOLAR_TRACE_OK)
+		return 0; // The child reports the error
+	Nights = (uint32_t)(Trace.Header->SampleCount * Trace.Header->SampleIntervalS / 86400) + 3;
+	SolarTrace_Close(&Trace);
+	return Nights;
+}
+
+int main(int argc, char **argv)
+{
+	BenchOptions	Options = { .WarmUpDays = 2 };
+	BenchSummary	Summary;
+	BenchSummary	Baseline;
+	const char		*BaselinePath = NULL;
+	const char		*WritePath = NULL;
+	const char		*Directory = NULL;
+	double			Tolerance = 2.0;
+	bool			UseCorpus = true;
+	uint32_t		Parallel = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	uint32_t		Sites;
+	uint32_t		First;
+	uint32_t		Failed = 0;
+	BenchResult		**Results;
+	size_t			*Sizes;
+	pid_t			*Children;
+	char			Description[128];
+	int				Option;
+	
+	while( (Option = getopt(argc, argv, "b:w:T:xg:o:DW:j:")) != -1 )
+	{
+		unsigned	Hours;
+		unsigned	Minutes;
+		
+		switch(Option)
+		{
+			case 'b':	BaselinePath = optarg; break;
+			case 'w':	WritePath = optarg; break;
+			case 'T':	Tolerance = strtod(optarg, NULL); break;
+			case 'x':	UseCorpus = false; break;
+			case 'g':	Directory = optarg; break;
+			case 'D':	Options.SummerTime = true; break;
+			case 'W':	Options.WarmUpDays = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'j':	Parallel = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'o':
+				if( (sscanf(optarg, "%u:%u", &Hours, &Minutes) != 2) || (Hours > 23) || (Minutes > 59) )
+				{
+					Usage();
+					return 2;
+				}
+				Options.Fixed = true;
+				Options.OffMinute = (int32_t)(Hours * 60 + Minutes);
+				if(Hours >= 12)
+					Options.OffMinute -= 24 * 60; // Evening, before the midnight the target counts from
+				break;
+			default:
+				Usage();
+				return 2;
+		}
+	}
+	First = UseCorpus ? 0 : CORPUS_SITES;
+	Sites = CORPUS_SITES + (uint32_t)(argc - optind);
+	if(First == Sites)
+	{
+		Usage();
+		return 2;
+	}
+	if(Parallel == 0)
+		Parallel = 1;
+	
+	Results = calloc(Sites, sizeof(BenchResult *));
+	Sizes = calloc(Sites, sizeof(size_t));
+	Children = calloc(Sites, sizeof(pid_t));
+	for(uint32_t Site = First; Site < Sites; Site++)
+	{
+		uint32_t	Nights = NightsOf(Site, argv + optind);
+		
+		Sizes[Site] = sizeof(BenchResult) + Nights * sizeof(BenchNight);
+		Results[Site] = mmap(NULL, Sizes[Site], PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if(Results[Site] == MAP_FAILED)
+		{
+			perror("mmap");
+			return 1;
+		}
+		Results[Site]->Status = -1;
+		Results[Site]->Nights = Nights;
+	}
+	
+	// Keep Parallel children running, reap in order:
+	fflush(NULL);
+	for(uint32_t Next = First, Done = First; Done < Sites; Done++)
+	{
+		int	Status;
+		
+		while( (Next < Sites) && (Next - Done < Parallel) )
+		{
+			Children[Next] = StartSite(Next, argv + optind, &Options, Directory, Results[Next]);
+			Next++;
+		}
+		waitpid(Children[Done], &Status, 0);
+		if( !WIFEXITED(Status) || (WEXITSTATUS(Status) != 0) || (Results[Done]->Status != 0) )
+			Failed++;
+	}
+	if(Failed != 0)
+	{
+		fprintf(stderr, "%u site(s) failed\n", Failed);
+		return 1;
+	}
+	
+	Summarise(Results + First, Sites - First, &Summary);
+	snprintf(Description, sizeof(Description), "%s%u extra trace(s)", UseCorpus ? "built-in corpus of 6 site-years, " : "", (unsigned)(Sites - CORPUS_SITES));
+	printf("%s\n\n", Description);
+	
+	if(BaselinePath != NULL)
+	{
+		if(!ReadBaseline(BaselinePath, &Baseline))
+		{
+			fprintf(stderr, "%s: %s\n", BaselinePath, strerror(errno));
+			return 1;
+		}
+		Failed = Report(&Summary, &Baseline, Tolerance);
+	}
+	else
+		Report(&Summary, NULL, Tolerance);
+	
+	if( (WritePath != NULL) && !WriteBaseline(WritePath, &Summary, Description) )
+	{
+		fprintf(stderr, "%s: %s\n", WritePath, strerror(errno));
+		return 1;
+	}
+	return (Failed != 0) ? 1 : 0;
+}
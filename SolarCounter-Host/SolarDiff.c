@@ -0,0 +1,649 @@
+/*
+ * SolarDiff.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * EXPERIMENTAL: this tool has never been linked against simavr or run against a firmware ELF,
+ *       the ATtiny10 one included, so a clean run proves nothing yet. It defaults to the attiny85
+ *       core (-m): by default it checks an ATtiny85 build, not the part the firmware ships on.
+ *
+ * Differential test: runs the firmware ELF, as built for the chip, in simavr and the host build
+ * of the same source (SolarHost.h) side by side over trace files, and reports the first WDT
+ * interrupt at which the two disagree, with the interrupts leading up to it:
+ *   gcc -O2 -I. -o SolarDiff SolarDiff.c SolarHost.c SolarTrace.c $(pkg-config --cflags --libs simavr) -lelf
+ *
+ * The ELF has to be built for the part it runs on in simavr, see SolarTarget.h:
+ *   avr-gcc -mmcu=attiny85 -Os -o SolarCounter-tiny85.elf SolarCounter-Tiny10.c
+ *
+ * Usage:
+ *   SolarDiff [options] -e SolarCounter-Tiny10.elf site.sltr [...]
+ *
+ * Options:
+ *   -e file        Firmware ELF, with symbols (the Debug or Release output of the .cproj)
+ *   -m mcu         simavr core to run it on, one of the parts in Mcus[] below (default attiny85)
+ *   -w symbol      WDT interrupt routine (default: WDT_vect of the part, __vector_12 on the ATtiny25/45/85)
+ *   -l file        Read trace file names from a file, one per line ("-" for stdin)
+ *   -j jobs        Simulator processes to run at once (default: number of CPUs)
+ *   -c lines       Interrupts of context to print before a divergence (default 8)
+ *   -q             Only print traces that diverge or fail
+ *
+ * Every trace runs in its own process, both because the host build keeps the firmware state in
+ * globals and because simavr is not meant to have lots of cores in one process. The exit code
+ * is 0 when all traces match, 1 when any diverged and 2 when any could not be run.
+ *
+ * The two are paired by WDT interrupt, not by simulated time: the N-th interrupt of the chip gets
+ * the same sensor reading as the N-th interrupt of the host build. What is tested is the logic,
+ * whether the WDT period matches the datasheet is up to simavr. Before every interrupt both the
+ * globals (found through the ELF symbol table) and the output compare register of PORTB_LEDPWM_PIN
+ * and PORTB_ENABLEBOOST_PIN are compared. The sensor reading is fed in as a voltage on the ADMUX
+ * channel, in the middle of the ADC step that should read back as the trace sample. The chip's
+ * registers are read at the data space addresses of the part picked with -m, from Mcus[].
+ *
+ * NOTE: Stock simavr has no core for the reduced (TPI) AVRs like the ATtiny10, it does have the
+ *       ATtiny13A and ATtiny25/45/85. The host build is always the ATtiny10 build, so options that
+ *       work out differently on the 8 pin parts (USE_EEPROM_HISTORY, they have an EEPROM) show up
+ *       as a divergence. The attiny10 entry in Mcus[] is for a simavr with a locally added core.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_adc.h>
+
+#include "SolarHost.h"
+#include "SolarTrace.h"
+
+// Pin masks, as the firmware is configured (PORTBn are the same on every part):
+#include <avr/io.h>
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+
+#define		DIFF_CONTEXT_MAX		64
+#define		DIFF_CLOCK_HZ			8000000		// Internal oscillator, the firmware prescales it itself
+#define		DIFF_WDT_TIMEOUT_S		20			// Longer than the longest WDT period, with margin
+
+// Globals of the firmware that are compared, in SolarHostState order:
+enum
+{
+	SYM_TICKS = 0,
+	SYM_DAYSTREAK,
+	SYM_NIGHTSTREAK,
+	SYM_WDT_COUNTDOWN,
+	SYM_OPERATIONALFLAGS,
+	SYM_TICKSLIMITPWM1,
+	SYM_TICKSLIMITPWM2,
+	SYM_WDT_VECTOR,
+	SYM_COUNT
+};
+
+static const char	*SymbolNames[SYM_COUNT] =
+{
+	"Ticks", "DayStreak", "NightStreak", "WDT_CountDown", "OperationalFlags",
+	"TicksLimitPWM1", "TicksLimitPWM2", NULL // WDT vector: from the part, or -w
+};
+
+/*
+  What is read from the chip, as data space addresses: the 8 pin parts have their I/O space
+  above the 32 registers, the reduced core parts at the bottom of data space.
+*/
+typedef struct
+{
+	const char		*Name;				// simavr core name
+	const char		*WdtVector;
+	uint16_t		PortB;
+	uint16_t		Admux;
+	uint16_t		Ocr0A;				// Low byte on the ATtiny10
+	uint16_t		Ocr0B;
+} DiffMcu;
+
+static const DiffMcu	Mcus[] =
+{
+	{ "attiny85",	"__vector_12",	0x38, 0x27, 0x49, 0x48 },
+	{ "attiny45",	"__vector_12",	0x38, 0x27, 0x49, 0x48 },
+	{ "attiny25",	"__vector_12",	0x38, 0x27, 0x49, 0x48 },
+	{ "attiny13a",	"__vector_8",	0x38, 0x27, 0x56, 0x49 },
+	{ "attiny13",	"__vector_8",	0x38, 0x27, 0x56, 0x49 },
+	{ "attiny10",	"__vector_8",	0x02, 0x1B, 0x26, 0x24 },
+};
+
+typedef struct
+{
+	const DiffMcu	*Mcu;
+	elf_firmware_t	Firmware;
+	uint32_t		Symbols[SYM_COUNT];
+	unsigned		Context;
+	bool			Quiet;
+} DiffSetup;
+
+typedef struct
+{
+	uint64_t		Interrupt;
+	uint64_t		TimeMs;
+	uint8_t			Input;
+	SolarHostState	Native;
+	SolarHostState	Chip;
+} DiffRow;
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  ELF symbols
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+  Looks up the address of every name in Names in the symbol table of a 32 bit ELF file. Values
+  of names that are not found are left alone. Returns the number of names not found, or -1 if
+  the file could not be read.
+*/
+static int ElfSymbols(const char *Path, const char *const *Names, uint32_t *Values, size_t Count)
+{
+	int			File = open(Path, O_RDONLY);
+	struct stat	Status;
+	uint8_t		*Map;
+	Elf32_Ehdr	*Header;
+	Elf32_Shdr	*Sections;
+	uint32_t	Found = 0;
+	
+	if(File < 0)
+		return -1;
+	if( (fstat(File, &Status) != 0) || (Status.st_size < (off_t)sizeof(Elf32_Ehdr)) )
+	{
+		close(File);
+		return -1;
+	}
+	Map = mmap(NULL, Status.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close(File);
+	if(Map == MAP_FAILED)
+		return -1;
+	
+	Header = (Elf32_Ehdr *)Map;
+	if( (memcmp(Header->e_ident, ELFMAG, SELFMAG) != 0) || (Header->e_ident[EI_CLASS] != ELFCLASS32) ||
+		(Header->e_shoff + (uint64_t)Header->e_shnum * sizeof(Elf32_Shdr) > (uint64_t)Status.st_size) )
+	{
+		munmap(Map, Status.st_size);
+		return -1;
+	}
+	Sections = (Elf32_Shdr *)(Map + Header->e_shoff);
+	
+	for(unsigned Section = 0; Section < Header->e_shnum; Section++)
+	{
+		Elf32_Sym	*Symbols;
+		const char	*Strings;
+		uint32_t	SymbolCount;
+		
+		if( (Sections[Section].sh_type != SHT_SYMTAB) || (Sections[Section].sh_link >= Header->e_shnum) )
+			continue;
+		
+		Symbols = (Elf32_Sym *)(Map + Sections[Section].sh_offset);
+		SymbolCount = Sections[Section].sh_size / sizeof(Elf32_Sym);
+		Strings = (const char *)(Map + Sections[Sections[Section].sh_link].sh_offset);
+		
+		for(uint32_t Symbol = 0; Symbol < SymbolCount; Symbol++)
+		{
+			for(size_t Name = 0; Name < Count; Name++)
+			{
+				if( !(Found & (1u << Name)) && (strcmp(Strings + Symbols[Symbol].st_name, Names[Name]) == 0) )
+				{
+					Values[Name] = Symbols[Symbol].st_value;
+					Found |= 1u << Name;
+				}
+			}
+		}
+	}
+	munmap(Map, Status.st_size);
+	return (int)Count - __builtin_popcount(Found);
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Simulated chip
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Symbol values of data are in the 0x800000 section of avr-ld, simavr indexes data space:
+static inline uint8_t ChipData(const DiffSetup *Setup, avr_t *Avr, unsigned Symbol, unsigned Offset)
+{
+	return Avr->data[(Setup->Symbols[Symbol] & 0xFFFF) + Offset];
+}
+
+static inline uint8_t ChipRegister(avr_t *Avr, uint16_t Address)
+{
+	return Avr->data[Address];
+}
+
+static void ChipState(const DiffSetup *Setup, avr_t *Avr, SolarHostState *State)
+{
+	State->Ticks = ChipData(Setup, Avr, SYM_TICKS, 0) | (ChipData(Setup, Avr, SYM_TICKS, 1) << 8);
+	State->DayStreak = ChipData(Setup, Avr, SYM_DAYSTREAK, 0);
+	State->NightStreak = ChipData(Setup, Avr, SYM_NIGHTSTREAK, 0);
+	State->WDT_CountDown = ChipData(Setup, Avr, SYM_WDT_COUNTDOWN, 0);
+	State->OperationalFlags = ChipData(Setup, Avr, SYM_OPERATIONALFLAGS, 0);
+	State->TicksLimitPWM1 = ChipData(Setup, Avr, SYM_TICKSLIMITPWM1, 0) | (ChipData(Setup, Avr, SYM_TICKSLIMITPWM1, 1) << 8);
+	State->TicksLimitPWM2 = ChipData(Setup, Avr, SYM_TICKSLIMITPWM2, 0) | (ChipData(Setup, Avr, SYM_TICKSLIMITPWM2, 1) << 8);
+	State->Duty = ChipRegister(Avr, (PORTB_LEDPWM_PIN == (1<<PORTB0)) ? Setup->Mcu->Ocr0A : Setup->Mcu->Ocr0B);
+	State->Boost = (ChipRegister(Avr, Setup->Mcu->PortB) & PORTB_ENABLEBOOST_PIN) != 0;
+}
+
+// Sets the sensor voltage so the 8 bit conversion lands in the middle of the Input step:
+static void ChipInput(const DiffSetup *Setup, avr_t *Avr, uint8_t Input, uint32_t SupplyMv)
+{
+	uint8_t		Channel = ChipRegister(Avr, Setup->Mcu->Admux) & 0x03; // MUX1..0 on every part
+	uint32_t	Millivolts = ((2 * (uint32_t)Input + 1) * SupplyMv) / 512;
+	
+	avr_raise_irq(avr_io_getirq(Avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + Channel), Millivolts);
+}
+
+// Runs the chip until it enters the WDT interrupt routine, false if it never does:
+static bool ChipRunToWdt(const DiffSetup *Setup, avr_t *Avr)
+{
+	avr_cycle_count_t	Limit = Avr->cycle + (avr_cycle_count_t)Avr->frequency * DIFF_WDT_TIMEOUT_S;
+	
+	do
+	{
+		int	State = avr_run(Avr);
+		
+		if( (State == cpu_Done) || (State == cpu_Crashed) || (Avr->cycle > Limit) )
+			return false;
+	} while(Avr->pc != Setup->Symbols[SYM_WDT_VECTOR]);
+	return true;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Comparison
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static unsigned StateDifference(const SolarHostState *A, const SolarHostState *B)
+{
+	return	((A->Ticks != B->Ticks) << SYM_TICKS) |
+			((A->DayStreak != B->DayStreak) << SYM_DAYSTREAK) |
+			((A->NightStreak != B->NightStreak) << SYM_NIGHTSTREAK) |
+			((A->WDT_CountDown != B->WDT_CountDown) << SYM_WDT_COUNTDOWN) |
+			((A->OperationalFlags != B->OperationalFlags) << SYM_OPERATIONALFLAGS) |
+			((A->TicksLimitPWM1 != B->TicksLimitPWM1) << SYM_TICKSLIMITPWM1) |
+			((A->TicksLimitPWM2 != B->TicksLimitPWM2) << SYM_TICKSLIMITPWM2) |
+			((A->Duty != B->Duty) << SYM_COUNT) |
+			((A->Boost != B->Boost) << (SYM_COUNT + 1));
+}
+
+static void PrintState(FILE *Out, const SolarHostState *State)
+{
+	fprintf(Out, "%5u %3u %3u %3u 0x%02X %5u %5u %3u %u", State->Ticks, State->DayStreak, State->NightStreak,
+			State->WDT_CountDown, State->OperationalFlags, State->TicksLimitPWM1, State->TicksLimitPWM2,
+			State->Duty, State->Boost);
+}
+
+static void PrintRow(FILE *Out, const DiffRow *Row, bool Mark)
+{
+	uint64_t	Seconds = Row->TimeMs / 1000;
+	
+	fprintf(Out, "%c %9llu %4llud%02llu:%02llu:%02llu %3u | ", Mark ? '!' : ' ', (unsigned long long)Row->Interrupt,
+			(unsigned long long)(Seconds / 86400), (unsigned long long)(Seconds / 3600 % 24),
+			(unsigned long long)(Seconds / 60 % 60), (unsigned long long)(Seconds % 60), Row->Input);
+	PrintState(Out, &Row->Native);
+	fputs(" | ", Out);
+	PrintState(Out, &Row->Chip);
+	fputc('\n', Out);
+}
+
+static void PrintDivergence(FILE *Out, const DiffRow *Rows, uint64_t Count, unsigned Context, unsigned Difference)
+{
+	static const char	*FieldNames[SYM_COUNT + 2] =
+	{
+		"Ticks", "DayStreak", "NightStreak", "WDT_CountDown", "OperationalFlags",
+		"TicksLimitPWM1", "TicksLimitPWM2", NULL, "OCR0OUT_REGISTER_LOW", "PORTB_ENABLEBOOST_PIN"
+	};
+	uint64_t	First = (Count > Context + 1) ? Count - Context - 1 : 0;
+	
+	fputs("  differs in:", Out);
+	for(unsigned Field = 0; Field < SYM_COUNT + 2; Field++)
+	{
+		if(Difference & (1u << Field))
+			fprintf(Out, " %s", FieldNames[Field]);
+	}
+	fputs("\n    interrupt       time  in | host: Ticks  DS  NS  CD flag  Lim1  Lim2 PWM B | chip: (same)\n", Out);
+	for(uint64_t Row = First; Row < Count; Row++)
+		PrintRow(Out, &Rows[Row % (DIFF_CONTEXT_MAX + 1)], Row == Count - 1);
+}
+
+/*
+  Runs one trace through both, returns 0 when they match all the way, 1 when they diverged and
+  2 when the trace or the simulation could not be run.
+*/
+static int DiffTrace(const DiffSetup *Setup, const char *Path, FILE *Out)
+{
+	SolarTrace			Trace;
+	SolarTraceCursor	Cursor;
+	DiffRow				Rows[DIFF_CONTEXT_MAX + 1];
+	avr_t				*Avr;
+	uint64_t			IntervalMs;
+	uint64_t			EndMs;
+	uint64_t			TimeMs = 0;
+	uint64_t			Count = 0;
+	uint32_t			SupplyMv;
+	int					Result = SolarTrace_Open(&Trace, Path);
+	
+	if(Result == SOLAR_TRACE_OK)
+		Result = SolarTrace_Verify(&Trace);
+	if(Result != SOLAR_TRACE_OK)
+	{
+		fprintf(Out, "%s: %s\n", Path, SolarTrace_ErrorString(Result));
+		return 2;
+	}
+	IntervalMs = (uint64_t)Trace.Header->SampleIntervalS * 1000;
+	EndMs = Trace.Header->SampleCount * IntervalMs;
+	SupplyMv = Trace.Header->SupplyVoltageMv;
+	if(EndMs == 0)
+	{
+		fprintf(Out, "%s: empty trace\n", Path);
+		SolarTrace_Close(&Trace);
+		return 2;
+	}
+	
+	Avr = avr_make_mcu_by_name(Setup->Mcu->Name);
+	if(Avr == NULL)
+	{
+		fprintf(Out, "%s: simavr has no core named %s\n", Path, Setup->Mcu->Name);
+		SolarTrace_Close(&Trace);
+		return 2;
+	}
+	avr_init(Avr);
+	Avr->log = LOG_ERROR;
+	Avr->frequency = DIFF_CLOCK_HZ;
+	Avr->vcc = Avr->avcc = Avr->aref = SupplyMv;
+	avr_load_firmware(Avr, (elf_firmware_t *)&Setup->Firmware);
+	
+	// Power-up: the host build runs its initialisation, the chip runs to its first WDT interrupt:
+	SolarTrace_Begin(&Trace, &Cursor);
+	Rows[0].Interrupt = 0;
+	Rows[0].TimeMs = 0;
+	Rows[0].Input = SolarTrace_SampleAt(&Cursor, 0);
+	SolarHost_Reset(Rows[0].Input);
+	ChipInput(Setup, Avr, Rows[0].Input, SupplyMv);
+	
+	Result = 0;
+	while(1)
+	{
+		DiffRow		*Row = &Rows[Count % (DIFF_CONTEXT_MAX + 1)];
+		unsigned	Difference;
+		
+		if(!ChipRunToWdt(Setup, Avr))
+		{
+			fprintf(Out, "%s: chip did not reach the WDT interrupt after interrupt %llu (pc 0x%04X)\n", Path,
+					(unsigned long long)Count, (unsigned)Avr->pc);
+			Result = 2;
+			break;
+		}
+		SolarHost_GetState(&Row->Native);
+		ChipState(Setup, Avr, &Row->Chip);
+		Count++;
+		
+		Difference = StateDifference(&Row->Native, &Row->Chip);
+		if(Difference != 0)
+		{
+			fprintf(Out, "%s: diverged after %llu interrupts\n", Path, (unsigned long long)Count);
+			PrintDivergence(Out, Rows, Count, Setup->Context, Difference);
+			Result = 1;
+			break;
+		}
+		
+		// The next interrupt, both get the same reading:
+		TimeMs += SolarHost_WdtPeriodMs();
+		if(TimeMs >= EndMs)
+			break;
+		
+		Row = &Rows[Count % (DIFF_CONTEXT_MAX + 1)];
+		Row->Interrupt = Count;
+		Row->TimeMs = TimeMs;
+		Row->Input = SolarTrace_SampleAt(&Cursor, TimeMs / IntervalMs);
+		SolarHost_Tick(Row->Input);
+		ChipInput(Setup, Avr, Row->Input, SupplyMv);
+	}
+	
+	if( (Result == 0) && !Setup->Quiet )
+		fprintf(Out, "%s: match over %llu interrupts\n", Path, (unsigned long long)Count);
+	
+	avr_terminate(Avr);
+	SolarTrace_Close(&Trace);
+	return Result;
+}
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Process pool
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef struct
+{
+	unsigned long long	Match;
+	unsigned long long	Diverged;
+	unsigned long long	Failed;
+} DiffTally;
+
+static void CountExit(DiffTally *Tally, int Status)
+{
+	if(WIFEXITED(Status) && (WEXITSTATUS(Status) == 0))
+		Tally->Match++;
+	else if(WIFEXITED(Status) && (WEXITSTATUS(Status) == 1))
+		Tally->Diverged++;
+	else
+		Tally->Failed++;
+}
+
+/*
+  Forks a worker for one trace. The report is collected in memory and written out in one go, so
+  the reports of workers finishing at the same time don't get mixed up.
+*/
+static pid_t StartWorker(const DiffSetup *Setup, const char *Path)
+{
+	pid_t	Worker;
+	
+	fflush(stdout);
+	Worker = fork();
+	if(Worker == 0)
+	{
+		char	*Report = NULL;
+		size_t	Length = 0;
+		FILE	*Out = open_memstream(&Report, &Length);
+		int		Result = (Out != NULL) ? DiffTrace(Setup, Path, Out) : 2;
+		
+		if(Out != NULL)
+		{
+			fclose(Out);
+			if(write(STDOUT_FILENO, Report, Length) != (ssize_t)Length)
+				Result = 2;
+		}
+		_exit(Result);
+	}
+	return Worker;
+}
+
+// Next trace name from the command line or the list file, NULL when done:
+static const char *NextTrace(char **Arguments, int *Index, int Count, FILE *List, char **Line, size_t *LineSize)
+{
+	if(*Index < Count)
+		return Arguments[(*Index)++];
+	
+	while( (List != NULL) && (getline(Line, LineSize, List) > 0) )
+	{
+		(*Line)[strcspn(*Line, "\r\n")] = '\0';
+		if((*Line)[0] != '\0')
+			return *Line;
+	}
+	return NULL;
+}
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: SolarDiff [-m mcu] [-w symbol] [-l list] [-j jobs] [-c lines] [-q] -e firmware.elf site.sltr [...]\n");
+}
+
+int main(int argc, char **argv)
+{
+	DiffSetup	Setup;
+	DiffTally	Tally = { 0, 0, 0 };
+	const char	*Elf = NULL;
+	const char	*McuName = "attiny85";
+	const char	*ListPath = NULL;
+	FILE		*List = NULL;
+	char		*Line = NULL;
+	size_t		LineSize = 0;
+	long		Jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	long		Running = 0;
+	int			Option;
+	int			Missing;
+	
+	memset(&Setup, 0, sizeof(Setup));
+	Setup.Context = 8;
+	
+	while( (Option = getopt(argc, argv, "e:m:w:l:j:c:q")) != -1 )
+	{
+		switch(Option)
+		{
+			case 'e':	Elf = optarg;								break;
+			case 'm':	McuName = optarg;							break;
+			case 'w':	SymbolNames[SYM_WDT_VECTOR] = optarg;		break;
+			case 'l':	ListPath = optarg;							break;
+			case 'j':	Jobs = strtol(optarg, NULL, 0);				break;
+			case 'c':	Setup.Context = strtoul(optarg, NULL, 0);	break;
+			case 'q':	Setup.Quiet = true;							break;
+			default:
+				Usage();
+				return 2;
+		}
+	}
+	if( (Elf == NULL) || ((optind >= argc) && (ListPath == NULL)) )
+	{
+		Usage();
+		return 2;
+	}
+	if(Jobs < 1)
+		Jobs = 1;
+	if(Setup.Context > DIFF_CONTEXT_MAX)
+		Setup.Context = DIFF_CONTEXT_MAX;
+	
+	for(size_t Mcu = 0; Mcu < sizeof(Mcus) / sizeof(Mcus[0]); Mcu++)
+	{
+		if(strcmp(McuName, Mcus[Mcu].Name) == 0)
+			Setup.Mcu = &Mcus[Mcu];
+	}
+	if(Setup.Mcu == NULL)
+	{
+		fprintf(stderr, "No register map for %s, pick one of:", McuName);
+		for(size_t Mcu = 0; Mcu < sizeof(Mcus) / sizeof(Mcus[0]); Mcu++)
+			fprintf(stderr, " %s", Mcus[Mcu].Name);
+		fputc('\n', stderr);
+		return 2;
+	}
+	if(SymbolNames[SYM_WDT_VECTOR] == NULL)
+		SymbolNames[SYM_WDT_VECTOR] = Setup.Mcu->WdtVector;
+	
+	Missing = ElfSymbols(Elf, SymbolNames, Setup.Symbols, SYM_COUNT);
+	if(Missing != 0)
+	{
+		if(Missing < 0)
+			fprintf(stderr, "%s: not a readable 32 bit ELF file\n", Elf);
+		for(unsigned Symbol = 0; (Missing > 0) && (Symbol < SYM_COUNT); Symbol++)
+		{
+			if(Setup.Symbols[Symbol] == 0)
+				fprintf(stderr, "%s: no symbol %s\n", Elf, SymbolNames[Symbol]);
+		}
+		return 2;
+	}
+	if(elf_read_firmware(Elf, &Setup.Firmware) != 0)
+	{
+		fprintf(stderr, "%s: simavr could not load it\n", Elf);
+		return 2;
+	}
+	if( (Setup.Firmware.mmcu[0] != '\0') && (strcmp(Setup.Firmware.mmcu, Setup.Mcu->Name) != 0) )
+	{
+		fprintf(stderr, "%s: built for %s, not %s (see -m)\n", Elf, Setup.Firmware.mmcu, Setup.Mcu->Name);
+		return 2;
+	}
+	
+	if(ListPath != NULL)
+	{
+		List = (strcmp(ListPath, "-") == 0) ? stdin : fopen(ListPath, "r");
+		if(List == NULL)
+		{
+			perror(ListPath);
+			return 2;
+		}
+	}
+	
+	while(1)
+	{
+		const char	*Path = NextTrace(argv, &optind, argc, List, &Line, &LineSize);
+		int			Status;
+		
+		if( (Path == NULL) || (Running == Jobs) )
+		{ // Wait for a worker to finish, before starting a new one or at the end:
+			if(Running == 0)
+				break;
+			if(wait(&Status) > 0)
+			{
+				CountExit(&Tally, Status);
+				Running--;
+			}
+			else if(errno != EINTR)
+				Running = 0;
+		}
+		if(Path == NULL)
+			continue;
+		
+		if(StartWorker(&Setup, Path) < 0)
+		{
+			perror("fork");
+			Tally.Failed++;
+		}
+		else
+			Running++;
+	}
+	
+	if( (List != NULL) && (List != stdin) )
+		fclose(List);
+	free(Line);
+	
+	printf("%llu traces: %llu match, %llu diverged, %llu failed\n", Tally.Match + Tally.Diverged + Tally.Failed,
+		   Tally.Match, Tally.Diverged, Tally.Failed);
+	return (Tally.Failed != 0) ? 2 : (Tally.Diverged != 0);
+}
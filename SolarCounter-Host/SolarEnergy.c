@@ -0,0 +1,332 @@
+/*
+ * SolarEnergy.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Energy budget model, see SolarEnergy.h.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <avr/io.h>
+
+// Same order as the firmware includes them, SolarCounter.h alone does not pull in the configuration:
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarCounter.h"
+#include "SolarEnergy.h"
+
+#define		SECONDS_PER_DAY			86400
+#define		US_PER_HOUR				3600000000.0
+
+// Part of the PWM period the LEDs are on at an OCR value: fast PWM is high for OCR + 1 of TOP + 1
+// counts, phase correct for 2 * OCR of 2 * TOP:
+#ifdef		PWM_PHASE_CORRECT_ENABLED
+#define		PWM_ON_FRACTION(Duty)	((Duty) / (double)PWM_TOP)
+#else
+#define		PWM_ON_FRACTION(Duty)	(((Duty) + 1.0) / (PWM_TOP + 1.0))
+#endif
+
+typedef struct
+{
+	uint64_t	TimeUs;				// Integrated up to here
+	double		StoredWh;			// Energy in the battery, including what is out of reach in the cold
+	uint16_t	Duty;				// Controller output since TimeUs
+	bool		Boost;
+	bool		Fading;
+	bool		Short;				// The battery ran empty this night
+} EnergyLane;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Defaults
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SolarEnergy_DefaultModel(SolarEnergyModel *Model)
+{
+	Model->PanelW = 6.0f;
+	Model->HarvestEfficiency = 0.95f;	// "harvesting efficiency of up to 95%"
+	Model->LedW = 3.0f;					// "compared to 3W of lights", SolarConfig.h
+	Model->BoostIdleW = 0.03f;
+	Model->BoostLossPerW = 0.02f;		// 92% at 3W, 90% around 300mW
+	Model->QuiescentW = 0.0002f;		// Sensor divider and charger leakage, the controller itself is a few uA
+	Model->BatteryWh = 80.0f;
+	Model->InitialCharge = 1.0f;
+}
+
+// The Netherlands: about 3 degrees in January, 18 in July:
+void SolarEnergy_DefaultClimate(SolarEnergyClimate *Climate, const SolarTraceHeader *Header)
+{
+	Climate->FullScaleWm2 = 1000.0f;
+	Climate->MeanC = 10.5f;
+	Climate->AmplitudeC = 7.5f;
+	Climate->ColdestDay = (Header->LatitudeE6 < 0) ? 20 + 182 : 20;
+	Climate->ChargeMinimumC = 0.0f;
+}
+
+/*
+  Usable part of the LiPo capacity at a temperature, typical of the discharge curves in cell
+  datasheets at moderate (C/5) load; linear in between, flat outside.
+*/
+static float CapacityAt(float Celsius)
+{
+	static const float	Table[][2] =
+	{
+		{ -20.0f, 0.60f }, { -10.0f, 0.75f }, { 0.0f, 0.87f }, { 10.0f, 0.95f }, { 25.0f, 1.00f }
+	};
+	const uint32_t		Count = sizeof(Table) / sizeof(Table[0]);
+	
+	if(Celsius <= Table[0][0])
+		return Table[0][1];
+	for(uint32_t Point = 1; Point < Count; Point++)
+	{
+		if(Celsius < Table[Point][0])
+			return Table[Point - 1][1] + (Table[Point][1] - Table[Point - 1][1]) *
+				   (Celsius - Table[Point - 1][0]) / (Table[Point][0] - Table[Point - 1][0]);
+	}
+	return Table[Count - 1][1];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Site
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool SolarEnergy_InitSite(SolarEnergySite *Site, const SolarTraceHeader *Header, const uint8_t *Samples,
+						  const SolarEnergyClimate *Climate)
+{
+	float	Scale = Climate->FullScaleWm2 / (255.0f * 1000.0f);
+	double	Sum = 0;
+	
+	memset(Site, 0, sizeof(*Site));
+	Site->SampleCount = Header->SampleCount;
+	Site->IntervalUs = (uint64_t)Header->SampleIntervalS * 1000000;
+	Site->StartTime = Header->StartTime;
+	Site->Days = (uint32_t)((Header->SampleCount * Header->SampleIntervalS) / SECONDS_PER_DAY) + 1;
+	
+	Site->SunSeconds = malloc((Site->SampleCount + 1) * sizeof(double));
+	Site->Sun = malloc((Site->SampleCount + 1) * sizeof(float));
+	Site->Capacity = malloc(Site->Days * sizeof(float));
+	Site->Charging = malloc(Site->Days);
+	if( (Site->SunSeconds == NULL) || (Site->Sun == NULL) || (Site->Capacity == NULL) || (Site->Charging == NULL) )
+	{
+		SolarEnergy_FreeSite(Site);
+		return false;
+	}
+	
+	for(uint64_t Sample = 0; Sample < Site->SampleCount; Sample++)
+	{
+		Site->SunSeconds[Sample] = Sum;
+		Site->Sun[Sample] = Samples[Sample] * Scale;
+		Sum += (double)Site->Sun[Sample] * Header->SampleIntervalS;
+	}
+	Site->SunSeconds[Site->SampleCount] = Sum;
+	Site->Sun[Site->SampleCount] = 0;
+	
+	for(uint32_t Day = 0; Day < Site->Days; Day++)
+	{
+		time_t		Time = (time_t)(Header->StartTime + Header->UtcOffsetMin * 60 + (int64_t)Day * SECONDS_PER_DAY);
+		struct tm	Clock;
+		float		Celsius;
+		
+		gmtime_r(&Time, &Clock);
+		Celsius = Climate->MeanC - Climate->AmplitudeC * cosf(2.0f * (float)M_PI * (Clock.tm_yday - Climate->ColdestDay) / 365.25f);
+		Site->Capacity[Day] = CapacityAt(Celsius);
+		Site->Charging[Day] = Celsius >= Climate->ChargeMinimumC;
+	}
+	return true;
+}
+
+void SolarEnergy_FreeSite(SolarEnergySite *Site)
+{
+	free(Site->SunSeconds);
+	free(Site->Sun);
+	free(Site->Capacity);
+	free(Site->Charging);
+	memset(Site, 0, sizeof(*Site));
+}
+
+// Seconds at full rated panel output from the start of the trace up to TimeUs:
+static inline double SunAt(const SolarEnergySite *Site, uint64_t TimeUs)
+{
+	uint64_t	Sample = TimeUs / Site->IntervalUs;
+	
+	if(Sample >= Site->SampleCount)
+		return Site->SunSeconds[Site->SampleCount];
+	return Site->SunSeconds[Sample] + (TimeUs - Sample * Site->IntervalUs) * 1e-6 * Site->Sun[Sample];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Running
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Takes one unit from Lane->TimeUs to TimeUs, with the output held at Duty (an average, when fading):
+static void Integrate(const SolarEnergySite *Site, const SolarEnergyModel *Model, EnergyLane *Lane,
+					  SolarEnergyResult *Result, uint64_t TimeUs, double Duty)
+{
+	uint32_t	Day = (uint32_t)(Lane->TimeUs / (SECONDS_PER_DAY * 1000000ull));
+	double		Hours = (TimeUs - Lane->TimeUs) / US_PER_HOUR;
+	double		Led = Lane->Boost ? Model->LedW * PWM_ON_FRACTION(Duty) : 0;
+	double		Load = Model->QuiescentW + (Lane->Boost ? Led + Model->BoostIdleW + Model->BoostLossPerW * Led * Led : 0);
+	double		Harvest = Model->PanelW * Model->HarvestEfficiency * (SunAt(Site, TimeUs) - SunAt(Site, Lane->TimeUs)) / 3600.0;
+	double		Floor;
+	double		Need = Load * Hours;
+	double		Available;
+	
+	if(Day >= Site->Days)
+		Day = Site->Days - 1;
+	Floor = Model->BatteryWh * (1.0 - Site->Capacity[Day]);
+	
+	// Charge first, anything the battery can't (or mustn't) take is spilled:
+	if(!Site->Charging[Day])
+	{
+		Result->SpilledWh += Harvest;
+		Harvest = 0;
+	}
+	else if(Lane->StoredWh + Harvest > Model->BatteryWh)
+	{
+		Result->SpilledWh += Lane->StoredWh + Harvest - Model->BatteryWh;
+		Harvest = Model->BatteryWh - Lane->StoredWh;
+	}
+	Lane->StoredWh += Harvest;
+	Result->HarvestWh += Harvest;
+	
+	// Then the load, as far as the battery goes:
+	Result->DemandWh += Need;
+	Available = Lane->StoredWh - Floor;
+	if(Need <= Available)
+	{
+		Lane->StoredWh -= Need;
+		if(Lane->Boost)
+		{
+			Result->LampHours += Hours;
+			Result->LampWh += Led * Hours;
+		}
+	}
+	else
+	{
+		double	Part = (Available > 0) ? Available / Need : 0;
+		
+		if(Available > 0)
+			Lane->StoredWh = Floor;
+		if(Lane->Boost)
+		{
+			Result->LampHours += Part * Hours;
+			Result->LampWh += Part * Led * Hours;
+			Result->ShortfallHours += (1.0 - Part) * Hours;
+			if(!Lane->Short)
+				Result->DarkNights++;
+			Lane->Short = true;
+		}
+	}
+	
+	// Cold can put the floor above what is stored, that is just empty:
+	Available = (Lane->StoredWh > Floor) ? Lane->StoredWh - Floor : 0;
+	if(Available < Result->MinimumWh)
+	{
+		Result->MinimumWh = Available;
+		Result->MinimumTime = Site->StartTime + (int64_t)(TimeUs / 1000000);
+	}
+	Lane->TimeUs = TimeUs;
+}
+
+static void TakeState(const SolarFleetBlock *Block, uint32_t Lane, EnergyLane *Energy, SolarEnergyResult *Result)
+{
+	bool	Boost = !SolarFleet_LaneIsDay(Block, Lane);
+	
+	if(Boost && !Energy->Boost)
+	{ // Lamp switched on, a new night:
+		Result->Nights++;
+		Energy->Short = false;
+	}
+	Energy->Boost = Boost;
+	Energy->Duty = Block->Duty[Lane];
+	Energy->Fading = (Block->Flags[Lane] & FLAG_SLOWTURNOFF) != 0;
+}
+
+void SolarEnergy_RunBlock(const SolarEnergySite *Site, SolarFleetBlock *Block, const SolarEnergyModel *Models,
+						  uint32_t Count, SolarEnergyResult *Results)
+{
+	EnergyLane	Lanes[SOLAR_FLEET_LANES];
+	uint64_t	EndUs = Site->SampleCount * Site->IntervalUs;
+	float		Coldest = 1.0f;
+	bool		Running;
+	
+	if(Count > SOLAR_FLEET_LANES)
+		Count = SOLAR_FLEET_LANES;
+	
+	for(uint32_t Lane = 0; Lane < Count; Lane++)
+	{
+		memset(&Lanes[Lane], 0, sizeof(Lanes[Lane]));
+		memset(&Results[Lane], 0, sizeof(Results[Lane]));
+		Lanes[Lane].TimeUs = Block->TimeUs[Lane];
+		Lanes[Lane].StoredWh = Models[Lane].BatteryWh * Models[Lane].InitialCharge;
+		Results[Lane].MinimumWh = Models[Lane].BatteryWh;
+		Results[Lane].MinimumTime = Site->StartTime;
+		TakeState(Block, Lane, &Lanes[Lane], &Results[Lane]);
+	}
+	
+	do
+	{
+		Running = SolarFleet_StepBlock(Block);
+		
+		for(uint32_t Lane = 0; Lane < Count; Lane++)
+		{
+			uint64_t	TimeUs = Block->Active[Lane] ? Block->TimeUs[Lane] : EndUs;
+			double		Duty = Lanes[Lane].Duty;
+			
+			if(TimeUs <= Lanes[Lane].TimeUs)
+				continue;
+			
+			if(Lanes[Lane].Fading)
+			{ // A step skipped along the fade: the duty went down by a step every WDT interrupt
+				uint64_t	Periods = (TimeUs - Lanes[Lane].TimeUs) / Block->NightPeriodUs[Lane];
+				
+				Duty -= (Periods > 0) ? (Periods - 1) * OCR0_DECREASE_STEPSIZE / 2.0 : 0;
+				if(Duty < 0)
+					Duty = 0;
+			}
+			Integrate(Site, &Models[Lane], &Lanes[Lane], &Results[Lane], TimeUs, Duty);
+			TakeState(Block, Lane, &Lanes[Lane], &Results[Lane]);
+		}
+	} while(Running);
+	
+	for(uint32_t Day = 0; Day < Site->Days; Day++)
+		if(Site->Capacity[Day] < Coldest)
+			Coldest = Site->Capacity[Day];
+	
+	for(uint32_t Lane = 0; Lane < Count; Lane++)
+	{
+		double	DailyWh = Results[Lane].DemandWh * SECONDS_PER_DAY * 1e6 / (double)EndUs;
+		
+		Results[Lane].AutonomyDays = (DailyWh > 0) ? Models[Lane].BatteryWh * Coldest / DailyWh : 0;
+	}
+}
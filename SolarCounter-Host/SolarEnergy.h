@@ -0,0 +1,129 @@
+/*
+ * SolarEnergy.h
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Energy budget of a complete lamp: the controller decisions from the fleet model (SolarFleet.h)
+ * drive an LED load through the boost converter, a solar panel charges the battery, and the
+ * battery state of charge is followed over the whole trace.
+ *
+ * The parts, as described in the header of SolarCounter-Tiny10.c:
+ *   -- Panel, 4W to 10W. Output follows irradiance linearly, the irradiance is taken from the
+ *      sensor trace (the SFH325FA current is linear in light until the ADC runs out of range,
+ *      FullScaleWm2 tells what a full scale reading corresponds to).
+ *   -- Charger, HarvestEfficiency from panel to battery. A LiPo must not be charged below
+ *      freezing, so harvest is refused on days colder than ChargeMinimumC.
+ *   -- Battery, 80Wh+ 3.7V LiPo. Its usable capacity drops with temperature; the part that is
+ *      out of reach when cold is taken off the bottom (the cell hits its cut-off voltage sooner),
+ *      it is not lost. The temperature follows a yearly sine per day, see SolarEnergyClimate.
+ *   -- Boost converter: losses of BoostIdleW plus BoostLossPerW times the LED power squared,
+ *      only while PORTB_ENABLEBOOST_PIN is high.
+ *   -- LEDs, LedW at 100% duty, the PWM on OCR0OUT_REGISTER_LOW gives (Duty+1)/256 at the default
+ *      8 bit fast PWM (see PWM_FREQUENCY_HZ). SolarPwm.c models what the frequency costs.
+ *
+ * Every unit is integrated over the time between two of its fleet steps with the controller
+ * state that held during it, and a fade-out that was skipped in one step is taken at its
+ * average duty. The panel side is a prefix sum over the trace, so any interval costs the same.
+ * When the battery runs empty the lamp goes out but the controller keeps running (it hangs on
+ * the battery protection, not on the boost), so the rest of the night is counted as shortfall.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#ifndef __SOLAR_ENERGY_H__
+#define __SOLAR_ENERGY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "SolarFleet.h"
+#include "SolarTrace.h"
+
+typedef struct
+{
+	float		PanelW;				// Panel rating at 1000 W/m2
+	float		HarvestEfficiency;	// Panel to battery
+	float		LedW;				// LED power at 100% duty
+	float		BoostIdleW;			// Boost converter losses with the boost enabled, independent of load
+	float		BoostLossPerW;		// Boost converter losses growing with the LED power squared, in 1/W
+	float		QuiescentW;			// Controller, sensor and charger, always
+	float		BatteryWh;			// Battery capacity at 25 degrees
+	float		InitialCharge;		// State of charge at the start of the trace, 0 to 1
+} SolarEnergyModel;
+
+typedef struct
+{
+	float		FullScaleWm2;		// Irradiance that gives a full scale sensor reading
+	float		MeanC;				// Yearly mean temperature
+	float		AmplitudeC;			// Half the difference between the warmest and the coldest day
+	uint16_t	ColdestDay;			// Day of the year (0 is the 1st of January) with the lowest temperature
+	float		ChargeMinimumC;		// No charging below this temperature
+} SolarEnergyClimate;
+
+/*
+  Everything about one trace the energy model needs, built once per trace and shared (read-only)
+  by any number of runs over it.
+*/
+typedef struct
+{
+	double		*SunSeconds;		// Seconds at full rated panel output up to the start of sample n, SampleCount + 1 of them
+	float		*Sun;				// Panel output relative to its rating, per sample
+	float		*Capacity;			// Usable part of the battery capacity, per day of the trace
+	uint8_t		*Charging;			// Warm enough to charge, per day of the trace
+	uint32_t	Days;
+	uint64_t	SampleCount;
+	uint64_t	IntervalUs;
+	int64_t		StartTime;
+} SolarEnergySite;
+
+typedef struct
+{
+	double		MinimumWh;			// Lowest usable energy in the battery over the trace
+	int64_t		MinimumTime;		// Unix time of that moment
+	double		LampHours;			// Time the lamp was on
+	double		LampWh;				// Energy delivered into the LEDs
+	double		ShortfallHours;		// Time the controller had the lamp on, but the battery was empty
+	uint32_t	Nights;				// Times the lamp was switched on
+	uint32_t	DarkNights;			// Of those, the ones the battery ran empty
+	double		HarvestWh;			// Taken into the battery
+	double		SpilledWh;			// Harvest turned away by a full battery (or by the cold)
+	double		DemandWh;			// What all loads together asked of the battery
+	double		AutonomyDays;		// Days a full battery runs the average daily demand, at the coldest day's capacity
+} SolarEnergyResult;
+
+void		SolarEnergy_DefaultModel(SolarEnergyModel *Model);
+void		SolarEnergy_DefaultClimate(SolarEnergyClimate *Climate, const SolarTraceHeader *Header);
+
+bool		SolarEnergy_InitSite(SolarEnergySite *Site, const SolarTraceHeader *Header, const uint8_t *Samples,
+								 const SolarEnergyClimate *Climate); // False if out of memory
+void		SolarEnergy_FreeSite(SolarEnergySite *Site);
+
+/*
+  Runs a block set up with SolarFleet_InitBlock() (on the same samples as the site) to the end of
+  the trace, lane n with Models[n]. Only the first Count lanes get a result.
+*/
+void		SolarEnergy_RunBlock(const SolarEnergySite *Site, SolarFleetBlock *Block, const SolarEnergyModel *Models,
+								 uint32_t Count, SolarEnergyResult *Results);
+
+#endif // __SOLAR_ENERGY_H__
@@ -0,0 +1,414 @@
+/*
+ * SolarEnergyRun.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Runs the energy budget model (SolarEnergy.h) for a list of configurations over one trace and
+ * prints one CSV line per configuration:
+ *   gcc -O2 -march=native -pthread -I. -o SolarEnergyRun SolarEnergyRun.c SolarEnergy.c SolarFleet.c SolarHost.c SolarTrace.c -lm
+ *
+ * Usage:
+ *   SolarEnergyRun [options] site.sltr
+ *
+ * Options:
+ *   -c file        Configurations, CSV with a header line naming the columns (see below); without
+ *                  it a single configuration is run, with the defaults and the options below
+ *   -p watts       Panel rating (default 6)
+ *   -l watts       LED power at 100% duty (default 3)
+ *   -b Wh          Battery capacity at 25 degrees (default 80)
+ *   -s percent     State of charge at the start of the trace (default 100)
+ *   -F W/m2        Irradiance of a full scale sensor reading (default 1000)
+ *   -T celsius     Yearly mean temperature (default 10.5)
+ *   -A celsius     Yearly temperature amplitude (default 7.5)
+ *   -C celsius     No charging below this temperature (default 0)
+ *   -j threads     Worker threads (default: number of processors)
+ *
+ * Configuration columns, any left out take the default (SolarConfig.h for the controller):
+ *   Name, TickConstant, MinimumDayBeforeNight, MinimumAfterglow, MaximumAfterglow,
+ *   LimitationThreshold1, LimitationThreshold2, LimitationPwm1, LimitationPwm2, DarkThreshold,
+ *   LightThreshold, PanelW, HarvestEfficiency, LedW, BoostIdleW, BoostLossPerW, QuiescentW,
+ *   BatteryWh, InitialCharge
+ * MinimumDayBeforeNight is in samples (like MINIMUM_DAY_BEFORE_NIGHT_INTERNAL), the thresholds
+ * in ADC counts and InitialCharge from 0 to 1.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SolarEnergy.h"
+#include "SolarFleet.h"
+#include "SolarTrace.h"
+
+#define		CONFIG_NAME_LENGTH		32
+#define		CONFIG_COLUMNS_MAX		32
+
+typedef struct
+{
+	char				Name[CONFIG_NAME_LENGTH];
+	SolarFleetUnit		Unit;
+	SolarEnergyModel	Model;
+} EnergyConfig;
+
+typedef struct
+{
+	const SolarEnergySite	*Site;
+	const uint8_t			*Samples;
+	uint64_t				SampleCount;
+	uint32_t				IntervalS;
+	const EnergyConfig		*Configs;
+	SolarEnergyResult		*Results;
+	uint32_t				Count;
+	atomic_uint				NextBlock;
+	pthread_mutex_t			Lock;			// SolarFleet_InitBlock() runs the firmware, one at a time
+} EnergyRun;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Configurations
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+enum { COLUMN_UNIT_U16, COLUMN_UNIT_U8, COLUMN_MODEL_FLOAT };
+
+typedef struct
+{
+	const char	*Name;
+	uint8_t		Type;
+	size_t		Offset;
+} EnergyColumn;
+
+static const EnergyColumn	Columns[] =
+{
+	{ "TickConstant",			COLUMN_UNIT_U16,	offsetof(SolarFleetUnit, TickConstant) },
+	{ "MinimumDayBeforeNight",	COLUMN_UNIT_U16,	offsetof(SolarFleetUnit, MinimumDayBeforeNight) },
+	{ "MinimumAfterglow",		COLUMN_UNIT_U16,	offsetof(SolarFleetUnit, MinimumAfterglow) },
+	{ "MaximumAfterglow",		COLUMN_UNIT_U16,	offsetof(SolarFleetUnit, MaximumAfterglow) },
+	{ "LimitationThreshold1",	COLUMN_UNIT_U16,	offsetof(SolarFleetUnit, LimitationThreshold1) },
+	{ "LimitationThreshold2",	COLUMN_UNIT_U16,	offsetof(SolarFleetUnit, LimitationThreshold2) },
+	{ "LimitationPwm1",			COLUMN_UNIT_U8,		offsetof(SolarFleetUnit, LimitationPwm1) },
+	{ "LimitationPwm2",			COLUMN_UNIT_U8,		offsetof(SolarFleetUnit, LimitationPwm2) },
+	{ "DarkThreshold",			COLUMN_UNIT_U8,		offsetof(SolarFleetUnit, DarkThreshold) },
+	{ "LightThreshold",			COLUMN_UNIT_U8,		offsetof(SolarFleetUnit, LightThreshold) },
+	{ "PanelW",					COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, PanelW) },
+	{ "HarvestEfficiency",		COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, HarvestEfficiency) },
+	{ "LedW",					COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, LedW) },
+	{ "BoostIdleW",				COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, BoostIdleW) },
+	{ "BoostLossPerW",			COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, BoostLossPerW) },
+	{ "QuiescentW",				COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, QuiescentW) },
+	{ "BatteryWh",				COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, BatteryWh) },
+	{ "InitialCharge",			COLUMN_MODEL_FLOAT,	offsetof(SolarEnergyModel, InitialCharge) },
+};
+
+#define		COLUMN_COUNT		(sizeof(Columns) / sizeof(Columns[0]))
+#define		COLUMN_NAME			-1
+#define		COLUMN_IGNORED		-2
+
+static void SetColumn(EnergyConfig *Config, int Column, const char *Text)
+{
+	uint8_t	*Field;
+	
+	if(Column == COLUMN_NAME)
+	{
+		snprintf(Config->Name, sizeof(Config->Name), "%s", Text);
+		return;
+	}
+	if(Column < 0)
+		return;
+	
+	if(Columns[Column].Type == COLUMN_MODEL_FLOAT)
+	{
+		Field = (uint8_t *)&Config->Model + Columns[Column].Offset;
+		*(float *)Field = strtof(Text, NULL);
+	}
+	else
+	{
+		Field = (uint8_t *)&Config->Unit + Columns[Column].Offset;
+		if(Columns[Column].Type == COLUMN_UNIT_U16)
+			*(uint16_t *)Field = (uint16_t)strtoul(Text, NULL, 0);
+		else
+			*Field = (uint8_t)strtoul(Text, NULL, 0);
+	}
+}
+
+/*
+  Reads the configuration CSV, every row starting from Defaults. Returns the number of rows
+  read, 0 on an error (which has been reported).
+*/
+static uint32_t ReadConfigs(const char *Path, const EnergyConfig *Defaults, EnergyConfig **Configs)
+{
+	FILE		*File = fopen(Path, "r");
+	char		Line[1024];
+	int			Map[CONFIG_COLUMNS_MAX];
+	uint32_t	MapCount = 0;
+	uint32_t	Count = 0;
+	uint32_t	Size = 0;
+	
+	*Configs = NULL;
+	if(File == NULL)
+	{
+		perror(Path);
+		return 0;
+	}
+	
+	while(fgets(Line, sizeof(Line), File) != NULL)
+	{
+		EnergyConfig	*Config;
+		uint32_t		Column = 0;
+		
+		Line[strcspn(Line, "\r\n")] = '\0';
+		if( (Line[0] == '\0') || (Line[0] == '#') )
+			continue;
+		
+		if(MapCount == 0)
+		{ // Header line:
+			for(char *Name = strtok(Line, ","); (Name != NULL) && (MapCount < CONFIG_COLUMNS_MAX); Name = strtok(NULL, ","))
+			{
+				Map[MapCount] = COLUMN_IGNORED;
+				if(strcmp(Name, "Name") == 0)
+					Map[MapCount] = COLUMN_NAME;
+				for(uint32_t Known = 0; Known < COLUMN_COUNT; Known++)
+					if(strcmp(Name, Columns[Known].Name) == 0)
+						Map[MapCount] = (int)Known;
+				if(Map[MapCount] == COLUMN_IGNORED)
+					fprintf(stderr, "%s: unknown column %s, ignored\n", Path, Name);
+				MapCount++;
+			}
+			continue;
+		}
+		
+		if(Count == Size)
+		{
+			Size = (Size == 0) ? 64 : Size * 2;
+			*Configs = realloc(*Configs, Size * sizeof(EnergyConfig));
+		}
+		Config = &(*Configs)[Count];
+		*Config = *Defaults;
+		snprintf(Config->Name, sizeof(Config->Name), "%u", Count + 1);
+		
+		for(char *Field = strtok(Line, ","); (Field != NULL) && (Column < MapCount); Field = strtok(NULL, ","), Column++)
+			SetColumn(Config, Map[Column], Field);
+		
+		// Like SolarCounter.h does, 1 is the lower threshold:
+		if(Config->Unit.LimitationThreshold1 > Config->Unit.LimitationThreshold2)
+		{
+			uint16_t	Threshold = Config->Unit.LimitationThreshold1;
+			uint8_t		Pwm = Config->Unit.LimitationPwm1;
+			
+			Config->Unit.LimitationThreshold1 = Config->Unit.LimitationThreshold2;
+			Config->Unit.LimitationThreshold2 = Threshold;
+			Config->Unit.LimitationPwm1 = Config->Unit.LimitationPwm2;
+			Config->Unit.LimitationPwm2 = Pwm;
+		}
+		Count++;
+	}
+	fclose(File);
+	
+	if(Count == 0)
+		fprintf(stderr, "%s: no configurations\n", Path);
+	return Count;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Running
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static void *Worker(void *Context)
+{
+	EnergyRun			*Run = Context;
+	SolarFleetBlock		*Block = aligned_alloc(64, ((sizeof(SolarFleetBlock) + 63) / 64) * 64);
+	uint32_t			Blocks = (Run->Count + SOLAR_FLEET_LANES - 1) / SOLAR_FLEET_LANES;
+	uint32_t			Index;
+	
+	while( (Index = atomic_fetch_add(&Run->NextBlock, 1)) < Blocks )
+	{
+		SolarFleetUnit		Units[SOLAR_FLEET_LANES];
+		SolarEnergyModel	Models[SOLAR_FLEET_LANES];
+		uint32_t			First = Index * SOLAR_FLEET_LANES;
+		uint32_t			Count = (Run->Count - First < SOLAR_FLEET_LANES) ? Run->Count - First : SOLAR_FLEET_LANES;
+		
+		for(uint32_t Lane = 0; Lane < Count; Lane++)
+		{
+			Units[Lane] = Run->Configs[First + Lane].Unit;
+			Models[Lane] = Run->Configs[First + Lane].Model;
+		}
+		
+		pthread_mutex_lock(&Run->Lock);
+		SolarFleet_InitBlock(Block, Units, Count, Run->Samples, Run->SampleCount, Run->IntervalS);
+		pthread_mutex_unlock(&Run->Lock);
+		
+		SolarEnergy_RunBlock(Run->Site, Block, Models, Count, &Run->Results[First]);
+	}
+	free(Block);
+	return NULL;
+}
+
+static void Report(const EnergyConfig *Configs, const SolarEnergyResult *Results, uint32_t Count)
+{
+	printf("config,panel W,LED W,battery Wh,minimum %%,minimum at,lamp hours,LED Wh,shortfall hours,nights,dark nights,spilled Wh,autonomy days\n");
+	for(uint32_t Index = 0; Index < Count; Index++)
+	{
+		const SolarEnergyResult	*Result = &Results[Index];
+		time_t					Time = (time_t)Result->MinimumTime;
+		char					Clock[24];
+		
+		strftime(Clock, sizeof(Clock), "%Y-%m-%d %H:%M", gmtime(&Time));
+		printf("%s,%.1f,%.2f,%.1f,%.1f,%s,%.1f,%.1f,%.1f,%u,%u,%.1f,%.1f\n", Configs[Index].Name,
+			   Configs[Index].Model.PanelW, Configs[Index].Model.LedW, Configs[Index].Model.BatteryWh,
+			   100.0 * Result->MinimumWh / Configs[Index].Model.BatteryWh, Clock, Result->LampHours,
+			   Result->LampWh, Result->ShortfallHours, Result->Nights, Result->DarkNights, Result->SpilledWh,
+			   Result->AutonomyDays);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	EnergyRun			Run;
+	EnergyConfig		Defaults;
+	EnergyConfig		*Configs = NULL;
+	SolarEnergyClimate	Climate;
+	SolarEnergySite		Site;
+	SolarTrace			Trace;
+	SolarTraceCursor	Cursor;
+	uint8_t				*Samples;
+	const char			*ConfigPath = NULL;
+	uint32_t			Count = 1;
+	uint32_t			Threads = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	pthread_t			*Workers;
+	float				Climates[4] = { -1000.0f, -1000.0f, -1000.0f, -1000.0f }; // -F -T -A -C, when given
+	int					Option;
+	int					Result;
+	
+	SolarFleet_DefaultUnit(&Defaults.Unit);
+	SolarEnergy_DefaultModel(&Defaults.Model);
+	snprintf(Defaults.Name, sizeof(Defaults.Name), "default");
+	
+	while( (Option = getopt(argc, argv, "c:p:l:b:s:F:T:A:C:j:")) != -1 )
+	{
+		switch(Option)
+		{
+			case 'c':	ConfigPath = optarg;										break;
+			case 'p':	Defaults.Model.PanelW = strtof(optarg, NULL);				break;
+			case 'l':	Defaults.Model.LedW = strtof(optarg, NULL);					break;
+			case 'b':	Defaults.Model.BatteryWh = strtof(optarg, NULL);			break;
+			case 's':	Defaults.Model.InitialCharge = strtof(optarg, NULL) / 100;	break;
+			case 'F':	Climates[0] = strtof(optarg, NULL);							break;
+			case 'T':	Climates[1] = strtof(optarg, NULL);							break;
+			case 'A':	Climates[2] = strtof(optarg, NULL);							break;
+			case 'C':	Climates[3] = strtof(optarg, NULL);							break;
+			case 'j':	Threads = (uint32_t)strtoul(optarg, NULL, 10);				break;
+			default:
+				optind = argc;
+				break;
+		}
+	}
+	if(optind != argc - 1)
+	{
+		fprintf(stderr, "Usage: SolarEnergyRun [-c configs.csv] [-p W] [-l W] [-b Wh] [-s %%] [-F W/m2] [-T C] [-A C] [-C C] [-j threads] site.sltr\n");
+		return 2;
+	}
+	if(Threads == 0)
+		Threads = 1;
+	
+	Result = SolarTrace_Open(&Trace, argv[optind]);
+	if(Result != SOLAR_TRACE_OK)
+	{
+		fprintf(stderr, "%s: %s\n", argv[optind], SolarTrace_ErrorString(Result));
+		return 1;
+	}
+	if(Trace.Header->SampleCount == 0)
+	{
+		fprintf(stderr, "%s: no samples\n", argv[optind]);
+		return 1;
+	}
+	
+	if(ConfigPath != NULL)
+	{
+		Count = ReadConfigs(ConfigPath, &Defaults, &Configs);
+		if(Count == 0)
+			return 1;
+	}
+	else
+	{
+		Configs = malloc(sizeof(EnergyConfig));
+		Configs[0] = Defaults;
+	}
+	
+	SolarEnergy_DefaultClimate(&Climate, Trace.Header);
+	if(Climates[0] > -1000.0f)
+		Climate.FullScaleWm2 = Climates[0];
+	if(Climates[1] > -1000.0f)
+		Climate.MeanC = Climates[1];
+	if(Climates[2] > -1000.0f)
+		Climate.AmplitudeC = Climates[2];
+	if(Climates[3] > -1000.0f)
+		Climate.ChargeMinimumC = Climates[3];
+	
+	Samples = malloc((size_t)Trace.Header->SampleCount);
+	SolarTrace_Begin(&Trace, &Cursor);
+	SolarTrace_Read(&Cursor, Samples, (size_t)Trace.Header->SampleCount);
+	if(!SolarEnergy_InitSite(&Site, Trace.Header, Samples, &Climate))
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	
+	memset(&Run, 0, sizeof(Run));
+	Run.Site = &Site;
+	Run.Samples = Samples;
+	Run.SampleCount = Trace.Header->SampleCount;
+	Run.IntervalS = Trace.Header->SampleIntervalS;
+	Run.Configs = Configs;
+	Run.Results = calloc(Count, sizeof(SolarEnergyResult));
+	Run.Count = Count;
+	atomic_init(&Run.NextBlock, 0);
+	pthread_mutex_init(&Run.Lock, NULL);
+	
+	Workers = calloc(Threads, sizeof(pthread_t));
+	for(uint32_t Thread = 0; Thread < Threads; Thread++)
+		pthread_create(&Workers[Thread], NULL, Worker, &Run);
+	for(uint32_t Thread = 0; Thread < Threads; Thread++)
+		pthread_join(Workers[Thread], NULL);
+	
+	Report(Configs, Run.Results, Count);
+	
+	free(Workers);
+	free(Run.Results);
+	free(Configs);
+	free(Samples);
+	SolarEnergy_FreeSite(&Site);
+	SolarTrace_Close(&Trace);
+	return 0;
+}
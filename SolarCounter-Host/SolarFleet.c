@@ -0,0 +1,485 @@
+/*
+ * SolarFleet.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Lockstep fleet model, see SolarFleet.h. The two ISRs are written out below as mask
+ * arithmetic: every "if" of the firmware becomes a lane mask (all ones where the condition
+ * holds) and every assignment becomes a select on that mask. Keep the order of operations the
+ * same as in SolarCounter-Tiny10.c, that is what makes it match bit for bit.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <string.h>
+#include <avr/io.h>
+
+// Same order as the firmware includes them, SolarCounter.h alone does not pull in the configuration:
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarCounter.h"
+#include "SolarFleet.h"
+
+_Static_assert(FLAG_RUNNING_DAY == 0x10, "Update SolarFleet_LaneIsDay()");
+#ifdef		FADE_ENGINE_ENABLED
+#error "The fleet model follows the WDT stepped fade-out, check against the host build with USE_FADE_ENGINE off"
+#endif
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+#error "The fleet model counts the night down from the day ticks, check against the host build with USE_MIDNIGHT_ESTIMATOR off"
+#endif
+
+#define		WDT_BASE_PERIOD_US		16000 // 2k cycles of the 128kHz WDT oscillator
+
+typedef int16_t SolarLaneMask __attribute__((vector_size(SOLAR_FLEET_LANES * sizeof(int16_t))));
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Lane helpers
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Comparisons give 0 or -1 per lane, as signed; this makes them usable as a bit mask:
+#define		MASK(Comparison)		((SolarLanes)(Comparison))
+
+static inline SolarLanes Select(SolarLanes Mask, SolarLanes IfSet, SolarLanes IfClear)
+{
+	return (IfSet & Mask) | (IfClear & ~Mask);
+}
+
+static inline bool Any(SolarLanes Mask)
+{
+	uint64_t	Words[sizeof(SolarLanes) / sizeof(uint64_t)];
+	uint64_t	Result = 0;
+	
+	memcpy(Words, &Mask, sizeof(Words));
+	for(uint32_t Index = 0; Index < sizeof(Words) / sizeof(Words[0]); Index++)
+		Result |= Words[Index];
+	return Result != 0;
+}
+
+static inline SolarLanes Broadcast(uint16_t Value)
+{
+	SolarLanes	Lanes;
+	
+	for(uint32_t Lane = 0; Lane < SOLAR_FLEET_LANES; Lane++)
+		Lanes[Lane] = Value;
+	return Lanes;
+}
+
+static uint32_t WdtPeriodUs(uint8_t WdtControl)
+{
+	uint8_t	Prescaler = ((WdtControl >> 2) & 0x08) | (WdtControl & 0x07);
+	
+	return (uint32_t)WDT_BASE_PERIOD_US << Prescaler;
+}
+
+static uint32_t ScaledPeriodUs(uint8_t WdtControl, uint32_t ScaleQ16)
+{
+	return (uint32_t)(((uint64_t)WdtPeriodUs(WdtControl) * ScaleQ16) >> 16);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Units
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SolarFleet_DefaultUnit(SolarFleetUnit *Unit)
+{
+	memset(Unit, 0, sizeof(*Unit));
+	Unit->WdtScaleQ16 = 65536;
+	Unit->GainQ8 = 256;
+	Unit->TickConstant = TICK_CONSTANT;
+	Unit->MinimumDayBeforeNight = MINIMUM_DAY_BEFORE_NIGHT_INTERNAL;
+	Unit->MinimumAfterglow = MINIMUM_AFTERGLOW_MINUTES;
+	Unit->MaximumAfterglow = MAXIMUM_AFTERGLOW_MINUTES;
+	Unit->LimitationThreshold1 = AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL;
+	Unit->LimitationThreshold2 = AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL;
+	Unit->LimitationPwm1 = AFTERGLOW_LIMITATION_PWM1_INTERNAL;
+	Unit->LimitationPwm2 = AFTERGLOW_LIMITATION_PWM2_INTERNAL;
+	Unit->DarkThreshold = DARK_THRESHOLD;
+	Unit->LightThreshold = LIGHT_THRESHOLD;
+}
+
+uint8_t SolarFleet_MapInput(const SolarFleetUnit *Unit, uint8_t Sample)
+{
+	int32_t	Value = (((int32_t)Sample * Unit->GainQ8) >> 8) + Unit->Offset;
+	
+	if(Value < 0)
+		return 0;
+	if(Value > 255)
+		return 255;
+	return (uint8_t)Value;
+}
+
+static uint8_t MapLaneInput(const SolarFleetBlock *Block, uint32_t Lane, uint8_t Sample)
+{
+	int32_t	Value = (((int32_t)Sample * Block->GainQ8[Lane]) >> 8) + Block->Offset[Lane];
+	
+	if(Value < 0)
+		return 0;
+	if(Value > 255)
+		return 255;
+	return (uint8_t)Value;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Block set-up
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SolarFleet_InitBlock(SolarFleetBlock *Block, const SolarFleetUnit *Units, uint32_t Count,
+						  const uint8_t *Samples, uint64_t SampleCount, uint32_t IntervalS)
+{
+	memset(Block, 0, sizeof(*Block));
+	Block->Samples = Samples;
+	Block->IntervalUs = (uint64_t)IntervalS * 1000000;
+	Block->EndUs = SampleCount * Block->IntervalUs;
+	
+	for(uint32_t Lane = 0; Lane < SOLAR_FLEET_LANES; Lane++)
+	{
+		SolarFleetUnit	Unit;
+		SolarHostState	State;
+		
+		if(Lane < Count)
+			Unit = Units[Lane];
+		else
+			SolarFleet_DefaultUnit(&Unit); // Unused lanes run along inactive, give them sane values
+		
+		Block->TickConstant[Lane] = Unit.TickConstant;
+		Block->MinimumDayBeforeNight[Lane] = Unit.MinimumDayBeforeNight;
+		Block->MinimumAfterglow[Lane] = Unit.MinimumAfterglow;
+		Block->MaximumAfterglow[Lane] = Unit.MaximumAfterglow;
+		Block->Threshold1[Lane] = Unit.LimitationThreshold1;
+		Block->Threshold2[Lane] = Unit.LimitationThreshold2;
+		Block->Pwm1[Lane] = Unit.LimitationPwm1;
+		Block->Pwm2[Lane] = Unit.LimitationPwm2;
+		Block->DarkThreshold[Lane] = Unit.DarkThreshold;
+		Block->LightThreshold[Lane] = Unit.LightThreshold;
+		Block->DayPeriodUs[Lane] = ScaledPeriodUs(WDTCR_VALUE_DAY, Unit.WdtScaleQ16);
+		Block->NightPeriodUs[Lane] = ScaledPeriodUs(WDTCR_VALUE_NIGHT, Unit.WdtScaleQ16);
+		Block->GainQ8[Lane] = Unit.GainQ8;
+		Block->Offset[Lane] = Unit.Offset;
+		
+		if( (Lane >= Count) || (SampleCount == 0) )
+			continue;
+		
+		SolarHost_Reset(SolarFleet_MapInput(&Unit, Samples[0]));
+		SolarHost_GetState(&State);
+#ifdef		COLD_START_ENABLED
+		// The cold start seeds Ticks of a day against MINIMUM_DAY_BEFORE_NIGHT, move it to this unit's:
+		if(State.Ticks < COLD_START_GATE_OPEN)
+			State.Ticks = (State.Ticks + Unit.MinimumDayBeforeNight >= MINIMUM_DAY_BEFORE_NIGHT_INTERNAL)
+				? State.Ticks + Unit.MinimumDayBeforeNight - MINIMUM_DAY_BEFORE_NIGHT_INTERNAL : 0;
+#endif
+		Block->Ticks[Lane] = State.Ticks;
+		Block->DayStreak[Lane] = State.DayStreak;
+		Block->NightStreak[Lane] = State.NightStreak;
+		Block->CountDown[Lane] = State.WDT_CountDown;
+		Block->Flags[Lane] = State.OperationalFlags;
+		Block->LimitPWM1[Lane] = State.TicksLimitPWM1;
+		Block->LimitPWM2[Lane] = State.TicksLimitPWM2;
+		Block->Duty[Lane] = State.Duty;
+		Block->Active[Lane] = 0xFFFF;
+	}
+}
+
+void SolarFleet_GetLane(const SolarFleetBlock *Block, uint32_t Lane, SolarHostState *State)
+{
+	State->Ticks = Block->Ticks[Lane];
+	State->DayStreak = (uint8_t)Block->DayStreak[Lane];
+	State->NightStreak = (uint8_t)Block->NightStreak[Lane];
+	State->WDT_CountDown = (uint8_t)Block->CountDown[Lane];
+	State->OperationalFlags = (uint8_t)Block->Flags[Lane];
+	State->TicksLimitPWM1 = Block->LimitPWM1[Lane];
+	State->TicksLimitPWM2 = Block->LimitPWM2[Lane];
+	State->Duty = (uint8_t)Block->Duty[Lane];
+	State->Boost = !SolarFleet_LaneIsDay(Block, Lane);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  The ISRs, on lanes
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// SwitchToDayMode() for the lanes in Mask:
+static inline void DayMode(SolarFleetBlock *Block, SolarLanes Mask)
+{
+	Block->Duty = Select(Mask, Broadcast(INITIAL_OCR0L_INTERNAL), Block->Duty);
+	Block->Flags &= ~(Mask & (FLAG_SLOWTURNOFF | FLAG_LIGHTISON | FLAG_PWM_OPERATONAL));
+	Block->Flags |= Mask & FLAG_RUNNING_DAY;
+}
+
+// SwitchToNightMode() for the lanes in Mask:
+static inline void NightMode(SolarFleetBlock *Block, SolarLanes Mask)
+{
+	Block->Duty = Select(Mask, Broadcast(MAXIMUM_OCR0L_INTERNAL), Block->Duty);
+	Block->Flags &= ~(Mask & (FLAG_SLOWTURNOFF | FLAG_RUNNING_DAY));
+	Block->Flags |= Mask & FLAG_LIGHTISON;
+}
+
+// ISR(WDT_vect) for the lanes in Active, returns the lanes that start a conversion:
+static inline SolarLanes WdtInterrupt(SolarFleetBlock *Block, SolarLanes Active)
+{
+	SolarLanes	Fading = Active & MASK((Block->Flags & FLAG_SLOWTURNOFF) != 0);
+	SolarLanes	Sample;
+	
+	if(Any(Fading))
+	{
+		SolarLanes	Done = Fading & MASK(Block->Duty <= OCR0_DECREASE_STEPSIZE);
+		SolarLanes	Step = Fading & ~Done;
+		
+		DayMode(Block, Done);
+		Block->Ticks &= ~Done;
+		Block->Duty -= Step & OCR0_DECREASE_STEPSIZE;
+	}
+	
+	Block->CountDown = (Block->CountDown - (Active & 1)) & 0xFF;
+	Sample = Active & MASK(Block->CountDown == 0);
+	Block->CountDown = Select(Sample & MASK((Block->Flags & FLAG_RUNNING_DAY) != 0),
+							  Broadcast(TICKS_BEFORE_SAMPLE_DAY), Block->CountDown);
+	Block->CountDown = Select(Sample & MASK((Block->Flags & FLAG_RUNNING_DAY) == 0),
+							  Broadcast(TICKS_BEFORE_SAMPLE_NIGHT), Block->CountDown);
+	return Sample;
+}
+
+// ISR(ADC_vect) for the lanes in Sample:
+static inline void AdcInterrupt(SolarFleetBlock *Block, SolarLanes Sample, SolarLanes Input)
+{
+	SolarLanes	Light = Sample & MASK(Input > Block->LightThreshold);
+	SolarLanes	Dark = Sample & ~Light & MASK(Input < Block->DarkThreshold);
+	SolarLanes	LightOff;
+	SolarLanes	LightOn;
+	SolarLanes	Mask;
+	
+	// When day:
+	if(Any(Light))
+	{
+		Block->Ticks += Light & 1;
+		Block->NightStreak &= ~Light;
+		Block->DayStreak += Light & 1;
+		Mask = Light & MASK(Block->DayStreak >= MINIMUM_DAY_STREAK);
+		DayMode(Block, Mask);
+		Block->Flags |= Mask & FLAG_LASTMODE_WAS_DAY;
+		Block->DayStreak &= ~Mask;
+	}
+	
+	if(!Any(Dark))
+		return;
+	
+	// When night, with the light off:
+	LightOff = Dark & MASK((Block->Flags & FLAG_LIGHTISON) == 0);
+	LightOn = Dark & ~LightOff;
+	
+	Mask = LightOff & MASK((Block->Flags & FLAG_LASTMODE_WAS_DAY) != 0);
+	if(Any(Mask))
+	{
+		SolarLanes	Trigger;
+		SolarLanes	Capped;
+		SolarLanes	Calculated;
+		SolarLanes	Night;
+#ifdef		COLD_START_ENABLED
+		SolarLanes	FirstDay;
+		SolarLanes	Seed;
+#endif
+		
+		Block->NightStreak = (Block->NightStreak + (Mask & 1)) & 0xFF;
+#ifdef		COLD_START_ENABLED
+		Trigger = Mask & MASK(Block->NightStreak >= MINIMUM_NIGHT_STREAK) & MASK(Block->Ticks >= Block->MinimumDayBeforeNight);
+		FirstDay = Trigger & MASK((Block->Flags & FLAG_FIRST_DAY) != 0);
+		Block->Flags &= ~(FirstDay & FLAG_FIRST_DAY);
+		Seed = Select(MASK(Block->MinimumDayBeforeNight >= COLD_START_GUARD_TICKS), Block->MinimumDayBeforeNight - COLD_START_GUARD_TICKS,
+					  Broadcast(0));
+		Seed = Select(MASK(Block->Ticks >= COLD_START_GATE_OPEN), Broadcast(COLD_START_GATE_OPEN), Seed);
+		Block->Ticks -= FirstDay & Seed;
+		Block->Ticks = Select(FirstDay & MASK(Block->Ticks < COLD_START_DAY_TICKS), Broadcast(COLD_START_DAY_TICKS), Block->Ticks);
+#else
+		Trigger = Mask & MASK(Block->NightStreak >= MINIMUM_NIGHT_STREAK) & MASK(Block->Ticks >= Block->MinimumDayBeforeNight);
+#endif
+		Capped = Trigger & MASK(Block->Ticks >= Block->TickConstant);
+		Calculated = Trigger & ~Capped;
+		
+		Night = Block->TickConstant - Block->Ticks;
+		Night = Select(MASK(Night < Block->MinimumAfterglow), Block->MinimumAfterglow,
+					   Select(MASK(Night > Block->MaximumAfterglow), Block->MaximumAfterglow, Night));
+		
+		Block->Ticks = Select(Capped, Block->MinimumAfterglow, Select(Calculated, Night, Block->Ticks));
+		Block->LimitPWM1 = Select(Calculated, Select(MASK(Night > Block->Threshold1), Night - Block->Threshold1, Broadcast(0)),
+								  Block->LimitPWM1);
+		Block->LimitPWM2 = Select(Calculated, Select(MASK(Night > Block->Threshold2), Night - Block->Threshold2, Broadcast(0)),
+								  Block->LimitPWM2);
+		
+		NightMode(Block, Trigger);
+		Block->Flags &= ~(Trigger & FLAG_LASTMODE_WAS_DAY);
+		Block->NightStreak &= ~Trigger;
+	}
+	
+	// When night, with the light on:
+	if(Any(LightOn))
+	{
+		SolarLanes	Stage1;
+		SolarLanes	Stage2;
+		
+		Block->Ticks -= LightOn & 1;
+		
+		Mask = LightOn & MASK(Block->DayStreak != 0);
+		Block->NightStreak = (Block->NightStreak + (Mask & 1)) & 0xFF;
+		Mask &= MASK(Block->NightStreak >= MINIMUM_NIGHT_TO_RESET_DAY);
+		Block->NightStreak &= ~Mask;
+		Block->DayStreak &= ~Mask;
+		
+		Stage2 = LightOn & MASK(Block->Ticks < Block->LimitPWM2);
+		Stage1 = LightOn & ~Stage2 & MASK(Block->Ticks < Block->LimitPWM1);
+		Block->Flags |= (Stage1 | Stage2) & FLAG_PWM_OPERATONAL;
+		Block->Duty = Select(Stage2, Block->Pwm2, Select(Stage1, Block->Pwm1, Block->Duty));
+		
+		Mask = LightOn & MASK(Block->Ticks == 0);
+		Block->Flags &= ~(Mask & FLAG_LIGHTISON);
+		Block->Flags |= Mask & (FLAG_SLOWTURNOFF | FLAG_PWM_OPERATONAL);
+	}
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Stepping
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static inline uint32_t LanePeriodUs(const SolarFleetBlock *Block, uint32_t Lane)
+{
+	return SolarFleet_LaneIsDay(Block, Lane) ? Block->DayPeriodUs[Lane] : Block->NightPeriodUs[Lane];
+}
+
+bool SolarFleet_StepBlock(SolarFleetBlock *Block)
+{
+	SolarLanes	Input = Broadcast(0);
+	SolarLanes	Sample;
+	uint16_t	Skip = 0xFFFF;
+	
+	Block->Sampled = Broadcast(0);
+	if(!Any(Block->Active))
+		return false;
+	
+	/*
+	  Interrupts that only count down WDT_CountDown can be skipped in one go, up to the one
+	  where the first unit samples. A unit that is fading out only takes the duty down a step
+	  on those, which is skipped along, up to the interrupt where it ends the fade.
+	*/
+	for(uint32_t Lane = 0; Lane < SOLAR_FLEET_LANES; Lane++)
+	{
+		if(!Block->Active[Lane])
+			continue;
+		if(Block->CountDown[Lane] < Skip + 1u)
+			Skip = (Block->CountDown[Lane] == 0) ? 0 : Block->CountDown[Lane] - 1;
+		if(Block->Flags[Lane] & FLAG_SLOWTURNOFF)
+		{
+			uint16_t	Steps = (Block->Duty[Lane] > OCR0_DECREASE_STEPSIZE) ? (Block->Duty[Lane] - 1) / OCR0_DECREASE_STEPSIZE : 0;
+			if(Steps < Skip)
+				Skip = Steps;
+		}
+	}
+	
+	for(uint32_t Lane = 0; Lane < SOLAR_FLEET_LANES; Lane++)
+	{
+		uint64_t	Period;
+		uint64_t	Fit;
+		
+		if(!Block->Active[Lane])
+			continue;
+		
+		Period = LanePeriodUs(Block, Lane);
+		if(Block->TimeUs[Lane] + (Skip + 1) * Period >= Block->EndUs)
+		{ // The trace ends within the skipped interrupts, or on the next one:
+			Fit = (Block->TimeUs[Lane] + Period < Block->EndUs) ? (Block->EndUs - 1 - Block->TimeUs[Lane]) / Period : 0;
+			Block->TimeUs[Lane] += Fit * Period;
+			Block->Active[Lane] = 0;
+		}
+		else
+		{ // Skipped ones plus the one coming up:
+			Fit = Skip;
+			Block->TimeUs[Lane] += (Skip + 1) * Period;
+		}
+		
+		Block->CountDown[Lane] -= (uint16_t)Fit;
+		if(Block->Flags[Lane] & FLAG_SLOWTURNOFF)
+			Block->Duty[Lane] -= (uint16_t)(Fit * OCR0_DECREASE_STEPSIZE);
+		if(Fit != 0)
+			Block->Flags[Lane] |= FLAG_SET_SLEEP;
+	}
+	
+	// The interrupt itself, for the units that still have a trace:
+	Sample = WdtInterrupt(Block, Block->Active);
+	if(Any(Sample))
+	{
+		for(uint32_t Lane = 0; Lane < SOLAR_FLEET_LANES; Lane++)
+			if(Sample[Lane])
+				Input[Lane] = MapLaneInput(Block, Lane, Block->Samples[Block->TimeUs[Lane] / Block->IntervalUs]);
+		AdcInterrupt(Block, Sample, Input);
+	}
+	Block->Flags |= Block->Active & FLAG_SET_SLEEP;
+	Block->Sampled = Sample;
+	return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Checking against the firmware
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+uint32_t SolarFleet_HashState(uint32_t Hash, const SolarHostState *State)
+{
+	const uint8_t	Bytes[] = { (uint8_t)State->Ticks, (uint8_t)(State->Ticks >> 8), State->DayStreak, State->NightStreak,
+								State->WDT_CountDown, State->OperationalFlags, (uint8_t)State->TicksLimitPWM1,
+								(uint8_t)(State->TicksLimitPWM1 >> 8), (uint8_t)State->TicksLimitPWM2,
+								(uint8_t)(State->TicksLimitPWM2 >> 8), State->Duty, State->Boost };
+	
+	for(uint32_t Index = 0; Index < sizeof(Bytes); Index++)
+		Hash = (Hash ^ Bytes[Index]) * 16777619u; // FNV-1a
+	return Hash;
+}
+
+void SolarFleet_Reference(const SolarFleetUnit *Unit, const uint8_t *Samples, uint64_t SampleCount,
+						  uint32_t IntervalS, uint32_t *Hash, SolarHostState *State)
+{
+	uint64_t	IntervalUs = (uint64_t)IntervalS * 1000000;
+	uint64_t	EndUs = SampleCount * IntervalUs;
+	uint64_t	TimeUs = 0;
+	
+	SolarHost_Reset(SolarFleet_MapInput(Unit, Samples[0]));
+	while(1)
+	{
+		TimeUs += ScaledPeriodUs(WDTCSR, Unit->WdtScaleQ16);
+		if(TimeUs >= EndUs)
+			break;
+		
+		if(SolarHost_Tick(SolarFleet_MapInput(Unit, Samples[TimeUs / IntervalUs])))
+		{
+			SolarHost_GetState(State);
+			*Hash = SolarFleet_HashState(*Hash, State);
+		}
+	}
+	SolarHost_GetState(State);
+}
@@ -0,0 +1,152 @@
+/*
+ * SolarFleet.h
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Lockstep fleet model of the controller, for Monte Carlo runs over many simulated units.
+ *
+ * The controller state (Ticks, DayStreak, NightStreak, WDT_CountDown, OperationalFlags and
+ * TicksLimitPWM1/2, plus the PWM duty) is kept as structure-of-arrays: every variable is a
+ * vector holding SOLAR_FLEET_LANES units. The ISR logic is rewritten branch-free on those
+ * vectors using GCC vector extensions, which compile to AVX2 with -mavx2 (or -march=native)
+ * and to whatever the target has otherwise.
+ *
+ * Every unit can differ in:
+ *   -- WDT period (drift of the WDT oscillator, the 14-versus-15-tick problem in SolarConfig.h)
+ *   -- Sensor gain and offset (the offset doubles as threshold tolerance: shifting the input up
+ *      by one count is the same as shifting both thresholds down by one)
+ *   -- The algorithm constants from SolarConfig.h (for parameter sweeps)
+ *
+ * The model follows the firmware bit for bit. SolarFleet_Reference() runs one unit through the
+ * real firmware (SolarHost.h) with the same drift and sensor mapping, so the two can be compared;
+ * SolarFleetRun -V does that. Optional firmware features the model does not follow are refused
+ * at compile time, see the checks at the top of SolarFleet.c.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#ifndef __SOLAR_FLEET_H__
+#define __SOLAR_FLEET_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "SolarHost.h"
+
+#define		SOLAR_FLEET_LANES		16 // 16 bit lanes: 16 fill one AVX2 register
+
+typedef uint16_t SolarLanes __attribute__((vector_size(SOLAR_FLEET_LANES * sizeof(uint16_t))));
+
+typedef struct
+{
+	// Per unit variation:
+	uint32_t	WdtScaleQ16;			// Actual WDT period relative to nominal, 65536 is nominal
+	uint16_t	GainQ8;					// Sensor gain, 256 is nominal
+	int16_t		Offset;					// Added to the (gain corrected) ADC reading, in counts
+	
+	// Algorithm constants, SolarFleet_DefaultUnit() fills these in from SolarConfig.h:
+	uint16_t	TickConstant;
+	uint16_t	MinimumDayBeforeNight;	// In samples, like MINIMUM_DAY_BEFORE_NIGHT_INTERNAL
+	uint16_t	MinimumAfterglow;
+	uint16_t	MaximumAfterglow;
+	uint16_t	LimitationThreshold1;	// Ordered like the _INTERNAL values: 1 is the lower one
+	uint16_t	LimitationThreshold2;
+	uint8_t		LimitationPwm1;
+	uint8_t		LimitationPwm2;
+	uint8_t		DarkThreshold;
+	uint8_t		LightThreshold;
+} SolarFleetUnit;
+
+typedef struct
+{
+	// Controller state, 8 bit variables live in 16 bit lanes as well:
+	SolarLanes	Ticks;
+	SolarLanes	DayStreak;
+	SolarLanes	NightStreak;
+	SolarLanes	CountDown;				// WDT_CountDown
+	SolarLanes	Flags;					// OperationalFlags
+	SolarLanes	LimitPWM1;				// TicksLimitPWM1
+	SolarLanes	LimitPWM2;				// TicksLimitPWM2
+	SolarLanes	Duty;					// OCR0OUT_REGISTER_LOW
+	
+	SolarLanes	Active;					// All ones while the unit has trace left
+	SolarLanes	Sampled;				// All ones if the unit took a sample in the last step
+	
+	// Per unit constants (SolarFleetUnit):
+	SolarLanes	TickConstant;
+	SolarLanes	MinimumDayBeforeNight;
+	SolarLanes	MinimumAfterglow;
+	SolarLanes	MaximumAfterglow;
+	SolarLanes	Threshold1;
+	SolarLanes	Threshold2;
+	SolarLanes	Pwm1;
+	SolarLanes	Pwm2;
+	SolarLanes	DarkThreshold;
+	SolarLanes	LightThreshold;
+	
+	// Per unit time keeping and sensor mapping, only touched lane by lane:
+	uint64_t	TimeUs[SOLAR_FLEET_LANES];
+	uint32_t	DayPeriodUs[SOLAR_FLEET_LANES];
+	uint32_t	NightPeriodUs[SOLAR_FLEET_LANES];
+	uint16_t	GainQ8[SOLAR_FLEET_LANES];
+	int16_t		Offset[SOLAR_FLEET_LANES];
+	
+	// The trace all units in the block are looking at:
+	const uint8_t	*Samples;
+	uint64_t		IntervalUs;
+	uint64_t		EndUs;
+} SolarFleetBlock;
+
+void		SolarFleet_DefaultUnit(SolarFleetUnit *Unit);
+uint8_t		SolarFleet_MapInput(const SolarFleetUnit *Unit, uint8_t Sample);
+
+/*
+  Powers up Count (at most SOLAR_FLEET_LANES) units on a decoded trace. The start-up state is
+  taken from the firmware itself, through SolarHost, so this is not thread safe. The rest is.
+*/
+void		SolarFleet_InitBlock(SolarFleetBlock *Block, const SolarFleetUnit *Units, uint32_t Count,
+								 const uint8_t *Samples, uint64_t SampleCount, uint32_t IntervalS);
+
+/*
+  Advances every unit in the block to its next sample and through it. While a unit is fading
+  out, the step ends at the interrupt that finishes the fade instead, if that comes first; the
+  duty steps before it are taken in one go. Returns false once all units reached the end.
+*/
+bool		SolarFleet_StepBlock(SolarFleetBlock *Block);
+
+static inline bool SolarFleet_LaneIsDay(const SolarFleetBlock *Block, uint32_t Lane)
+{
+	return (Block->Flags[Lane] & 0x10) != 0; // FLAG_RUNNING_DAY, checked against SolarCounter.h in SolarFleet.c
+}
+
+/*
+  Runs one unit through the real firmware in the same way, for checking the model. Hash is
+  updated after every sample with SolarFleet_HashState(), final state in State.
+*/
+void		SolarFleet_Reference(const SolarFleetUnit *Unit, const uint8_t *Samples, uint64_t SampleCount,
+								 uint32_t IntervalS, uint32_t *Hash, SolarHostState *State);
+uint32_t	SolarFleet_HashState(uint32_t Hash, const SolarHostState *State);
+void		SolarFleet_GetLane(const SolarFleetBlock *Block, uint32_t Lane, SolarHostState *State);
+
+#endif // __SOLAR_FLEET_H__
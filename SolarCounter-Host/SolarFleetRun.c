@@ -0,0 +1,385 @@
+/*
+ * SolarFleetRun.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Monte Carlo fleet run: a population of units with spread on WDT period, sensor gain and
+ * threshold, all running over one trace file in the lockstep model (SolarFleet.h). Prints the
+ * distribution of switch-on and switch-off clock times over the fleet, per month.
+ *   gcc -O2 -march=native -pthread -I. -o SolarFleetRun SolarFleetRun.c SolarFleet.c SolarHost.c SolarTrace.c -lm
+ *
+ * Usage:
+ *   SolarFleetRun [options] site.sltr
+ *
+ * Options:
+ *   -n units       Fleet size (default 10000)
+ *   -d percent     Standard deviation of the WDT period (default 5, the datasheet allows a lot more)
+ *   -g percent     Standard deviation of the sensor gain (default 10)
+ *   -t counts      Standard deviation of the threshold, in ADC counts (default 1)
+ *   -S seed        Random seed (default 1); unit n always gets the same spread for the same seed
+ *   -j threads     Worker threads (default: number of processors)
+ *   -V units       Also run the first units through the firmware and check they match (default 0)
+ *
+ * The exit code is non-zero if any checked unit does not match. Clock times are site clock
+ * time (UtcOffsetMin in the trace header); nights are counted in the month of the evening.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SolarFleet.h"
+#include "SolarTrace.h"
+
+#define		MINUTES_PER_DAY		1440
+#define		MONTHS				12
+
+enum { EVENT_ON, EVENT_OFF, EVENTS };
+
+typedef struct
+{
+	// Minute of the day, counted from noon so the evening and the night don't wrap:
+	uint32_t	Histogram[MONTHS][EVENTS][MINUTES_PER_DAY];
+} FleetResult;
+
+typedef struct
+{
+	SolarFleetBlock			*Blocks;
+	uint32_t				BlockCount;
+	atomic_uint				NextBlock;
+	const SolarTraceHeader	*Header;
+	uint8_t					*MonthOfDay;	// Month of every night in the trace, by day index
+	uint64_t				Days;
+	uint32_t				*Hashes;		// Per unit, for -V
+	uint32_t				VerifyUnits;
+	FleetResult				Result;
+	pthread_mutex_t			Lock;
+} FleetRun;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Random spread, reproducible per unit
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static uint64_t SplitMix(uint64_t *State)
+{
+	uint64_t	Value = (*State += 0x9E3779B97F4A7C15ull);
+	
+	Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+	return Value ^ (Value >> 31);
+}
+
+static double Gaussian(uint64_t *State)
+{
+	double	First = ((SplitMix(State) >> 11) + 0.5) / 9007199254740992.0;
+	double	Second = (SplitMix(State) >> 11) / 9007199254740992.0;
+	
+	return sqrt(-2.0 * log(First)) * cos(2.0 * M_PI * Second);
+}
+
+static void MakeUnit(SolarFleetUnit *Unit, uint64_t Seed, uint32_t Index, double Drift, double Gain, double Threshold)
+{
+	uint64_t	State = Seed * 0x100000001B3ull + Index;
+	double		Value;
+	
+	SolarFleet_DefaultUnit(Unit);
+	
+	Value = 65536.0 * (1.0 + Drift * Gaussian(&State));
+	Unit->WdtScaleQ16 = (Value < 32768.0) ? 32768 : (uint32_t)Value;
+	Value = 256.0 * (1.0 + Gain * Gaussian(&State));
+	Unit->GainQ8 = (Value < 0.0) ? 0 : (Value > 1023.0) ? 1023 : (uint16_t)Value;
+	Value = Threshold * Gaussian(&State);
+	Unit->Offset = (int16_t)lround(Value);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Running
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static void Record(FleetRun *Run, FleetResult *Result, uint64_t TimeUs, int Event)
+{
+	int64_t		Local = Run->Header->StartTime + Run->Header->UtcOffsetMin * 60 + (int64_t)(TimeUs / 1000000);
+	int64_t		FromNoon = Local - 12 * 3600;
+	int64_t		FirstDay = (Run->Header->StartTime + Run->Header->UtcOffsetMin * 60 - 12 * 3600) / 86400;
+	uint64_t	Day = (uint64_t)(FromNoon / 86400 - FirstDay);
+	uint32_t	Minute = (uint32_t)((FromNoon % 86400) / 60);
+	
+	if(Day < Run->Days)
+		Result->Histogram[Run->MonthOfDay[Day]][Event][Minute]++;
+}
+
+static void *Worker(void *Argument)
+{
+	FleetRun	*Run = Argument;
+	FleetResult	*Result = calloc(1, sizeof(FleetResult));
+	uint32_t	Index;
+	
+	while( (Index = atomic_fetch_add(&Run->NextBlock, 1)) < Run->BlockCount )
+	{
+		SolarFleetBlock	*Block = &Run->Blocks[Index];
+		bool			WasDay[SOLAR_FLEET_LANES];
+		uint32_t		FirstUnit = Index * SOLAR_FLEET_LANES;
+		
+		for(uint32_t Lane = 0; Lane < SOLAR_FLEET_LANES; Lane++)
+			WasDay[Lane] = SolarFleet_LaneIsDay(Block, Lane);
+		
+		while(SolarFleet_StepBlock(Block))
+		{
+			for(uint32_t Lane = 0; Lane < SOLAR_FLEET_LANES; Lane++)
+			{
+				bool	IsDay = SolarFleet_LaneIsDay(Block, Lane);
+				
+				if( Block->Sampled[Lane] && (FirstUnit + Lane < Run->VerifyUnits) )
+				{
+					SolarHostState	State;
+					SolarFleet_GetLane(Block, Lane, &State);
+					Run->Hashes[FirstUnit + Lane] = SolarFleet_HashState(Run->Hashes[FirstUnit + Lane], &State);
+				}
+				if(IsDay == WasDay[Lane])
+					continue;
+				Record(Run, Result, Block->TimeUs[Lane], IsDay ? EVENT_OFF : EVENT_ON);
+				WasDay[Lane] = IsDay;
+			}
+		}
+	}
+	
+	pthread_mutex_lock(&Run->Lock);
+	for(uint32_t Month = 0; Month < MONTHS; Month++)
+		for(uint32_t Event = 0; Event < EVENTS; Event++)
+			for(uint32_t Minute = 0; Minute < MINUTES_PER_DAY; Minute++)
+				Run->Result.Histogram[Month][Event][Minute] += Result->Histogram[Month][Event][Minute];
+	pthread_mutex_unlock(&Run->Lock);
+	free(Result);
+	return NULL;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Reporting
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static uint64_t Total(const uint32_t *Histogram)
+{
+	uint64_t	Count = 0;
+	
+	for(uint32_t Minute = 0; Minute < MINUTES_PER_DAY; Minute++)
+		Count += Histogram[Minute];
+	return Count;
+}
+
+static void PrintPercentile(const uint32_t *Histogram, uint64_t Count, double Fraction)
+{
+	uint64_t	Target = (uint64_t)ceil(Count * Fraction);
+	uint64_t	Sum = 0;
+	uint32_t	Minute;
+	
+	if(Count == 0)
+	{
+		printf("   --:--");
+		return;
+	}
+	if(Target == 0)
+		Target = 1;
+	for(Minute = 0; Minute < MINUTES_PER_DAY; Minute++)
+	{
+		Sum += Histogram[Minute];
+		if(Sum >= Target)
+			break;
+	}
+	Minute = (Minute + 12 * 60) % MINUTES_PER_DAY;
+	printf("   %02u:%02u", Minute / 60, Minute % 60);
+}
+
+static void Report(const FleetResult *Result)
+{
+	static const char	*Months[MONTHS] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+											"Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	
+	printf("Month   switch-on p5     p50     p95   switch-off p5     p50     p95   ons      offs\n");
+	for(uint32_t Month = 0; Month < MONTHS; Month++)
+	{
+		uint64_t	On = Total(Result->Histogram[Month][EVENT_ON]);
+		uint64_t	Off = Total(Result->Histogram[Month][EVENT_OFF]);
+		
+		if( (On == 0) && (Off == 0) )
+			continue;
+		printf("%s      ", Months[Month]);
+		PrintPercentile(Result->Histogram[Month][EVENT_ON], On, 0.05);
+		PrintPercentile(Result->Histogram[Month][EVENT_ON], On, 0.50);
+		PrintPercentile(Result->Histogram[Month][EVENT_ON], On, 0.95);
+		printf("      ");
+		PrintPercentile(Result->Histogram[Month][EVENT_OFF], Off, 0.05);
+		PrintPercentile(Result->Histogram[Month][EVENT_OFF], Off, 0.50);
+		PrintPercentile(Result->Histogram[Month][EVENT_OFF], Off, 0.95);
+		printf("   %-8llu %llu\n", (unsigned long long)On, (unsigned long long)Off);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FleetRun		*Run;
+	SolarTrace		Trace;
+	uint8_t			*Samples;
+	uint64_t		SampleCount;
+	uint32_t		Units = 10000;
+	uint32_t		Threads = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	double			Drift = 0.05;
+	double			Gain = 0.10;
+	double			Threshold = 1.0;
+	uint64_t		Seed = 1;
+	uint32_t		Mismatches = 0;
+	pthread_t		*Workers;
+	struct timespec	Start;
+	struct timespec	End;
+	int				Option;
+	int				Result;
+	
+	Run = calloc(1, sizeof(FleetRun));
+	while( (Option = getopt(argc, argv, "n:d:g:t:S:j:V:")) != -1 )
+	{
+		switch(Option)
+		{
+			case 'n':	Units = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'd':	Drift = strtod(optarg, NULL) / 100.0; break;
+			case 'g':	Gain = strtod(optarg, NULL) / 100.0; break;
+			case 't':	Threshold = strtod(optarg, NULL); break;
+			case 'S':	Seed = strtoull(optarg, NULL, 10); break;
+			case 'j':	Threads = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 'V':	Run->VerifyUnits = (uint32_t)strtoul(optarg, NULL, 10); break;
+			default:
+				fprintf(stderr, "Usage: SolarFleetRun [-n units] [-d %%] [-g %%] [-t counts] [-S seed] [-j threads] [-V units] site.sltr\n");
+				return 2;
+		}
+	}
+	if( (optind != argc - 1) || (Units == 0) )
+	{
+		fprintf(stderr, "Usage: SolarFleetRun [-n units] [-d %%] [-g %%] [-t counts] [-S seed] [-j threads] [-V units] site.sltr\n");
+		return 2;
+	}
+	if(Threads == 0)
+		Threads = 1;
+	if(Run->VerifyUnits > Units)
+		Run->VerifyUnits = Units;
+	
+	Result = SolarTrace_Open(&Trace, argv[optind]);
+	if(Result != SOLAR_TRACE_OK)
+	{
+		fprintf(stderr, "%s: %s\n", argv[optind], SolarTrace_ErrorString(Result));
+		return 1;
+	}
+	SampleCount = Trace.Header->SampleCount;
+	if(SampleCount == 0)
+	{
+		fprintf(stderr, "%s: no samples\n", argv[optind]);
+		return 1;
+	}
+	
+	// Every unit looks at a different moment of the trace, decode it once so it can be indexed:
+	Samples = malloc((size_t)SampleCount);
+	{
+		SolarTraceCursor	Cursor;
+		SolarTrace_Begin(&Trace, &Cursor);
+		SolarTrace_Read(&Cursor, Samples, (size_t)SampleCount);
+	}
+	
+	Run->Header = Trace.Header;
+	Run->Days = (SampleCount * Trace.Header->SampleIntervalS) / 86400 + 2;
+	Run->MonthOfDay = malloc((size_t)Run->Days);
+	{
+		int64_t	FirstDay = (Trace.Header->StartTime + Trace.Header->UtcOffsetMin * 60 - 12 * 3600) / 86400;
+		for(uint64_t Day = 0; Day < Run->Days; Day++)
+		{
+			time_t		Time = (time_t)((FirstDay + (int64_t)Day) * 86400);
+			struct tm	Clock;
+			gmtime_r(&Time, &Clock);
+			Run->MonthOfDay[Day] = (uint8_t)Clock.tm_mon;
+		}
+	}
+	
+	Run->BlockCount = (Units + SOLAR_FLEET_LANES - 1) / SOLAR_FLEET_LANES;
+	Run->Blocks = aligned_alloc(64, ((Run->BlockCount * sizeof(SolarFleetBlock) + 63) / 64) * 64);
+	Run->Hashes = calloc(Run->VerifyUnits + 1, sizeof(uint32_t));
+	for(uint32_t Block = 0; Block < Run->BlockCount; Block++)
+	{
+		SolarFleetUnit	Unit[SOLAR_FLEET_LANES];
+		uint32_t		Count = 0;
+		
+		for(; (Count < SOLAR_FLEET_LANES) && (Block * SOLAR_FLEET_LANES + Count < Units); Count++)
+			MakeUnit(&Unit[Count], Seed, Block * SOLAR_FLEET_LANES + Count, Drift, Gain, Threshold);
+		SolarFleet_InitBlock(&Run->Blocks[Block], Unit, Count, Samples, SampleCount, Trace.Header->SampleIntervalS);
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	pthread_mutex_init(&Run->Lock, NULL);
+	Workers = calloc(Threads, sizeof(pthread_t));
+	for(uint32_t Thread = 0; Thread < Threads; Thread++)
+		pthread_create(&Workers[Thread], NULL, Worker, Run);
+	for(uint32_t Thread = 0; Thread < Threads; Thread++)
+		pthread_join(Workers[Thread], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	
+	printf("%u units, %.1f days of %.32s, WDT spread %.1f%%, gain spread %.1f%%, threshold spread %.1f counts\n",
+		   Units, SampleCount * Trace.Header->SampleIntervalS / 86400.0, Trace.Header->SiteName,
+		   Drift * 100.0, Gain * 100.0, Threshold);
+	Report(&Run->Result);
+	fprintf(stderr, "%.2f s on %u threads\n", (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9, Threads);
+	
+	for(uint32_t Index = 0; Index < Run->VerifyUnits; Index++)
+	{
+		SolarFleetUnit	Unit;
+		SolarHostState	Reference;
+		SolarHostState	Model;
+		uint32_t		Hash = 0;
+		
+		MakeUnit(&Unit, Seed, Index, Drift, Gain, Threshold);
+		SolarFleet_Reference(&Unit, Samples, SampleCount, Trace.Header->SampleIntervalS, &Hash, &Reference);
+		SolarFleet_GetLane(&Run->Blocks[Index / SOLAR_FLEET_LANES], Index % SOLAR_FLEET_LANES, &Model);
+		
+		if( (Hash != Run->Hashes[Index]) || (SolarFleet_HashState(0, &Reference) != SolarFleet_HashState(0, &Model)) )
+		{
+			fprintf(stderr, "Unit %u does not match the firmware (Ticks %u/%u, flags %02X/%02X, duty %u/%u)\n", Index,
+					Model.Ticks, Reference.Ticks, Model.OperationalFlags, Reference.OperationalFlags, Model.Duty, Reference.Duty);
+			Mismatches++;
+		}
+	}
+	if(Run->VerifyUnits != 0)
+		fprintf(stderr, "%u of %u checked units match the firmware\n", Run->VerifyUnits - Mismatches, Run->VerifyUnits);
+	
+	SolarTrace_Close(&Trace);
+	return (Mismatches != 0) ? 1 : 0;
+}
@@ -0,0 +1,675 @@
+/*
+ * SolarHost.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Host build of the firmware, see SolarHost.h. Compile with the SolarCounter-Host directory
+ * on the include path, so <avr/io.h> and friends resolve to the stand-ins in avr/:
+ *   gcc -O2 -I. -c SolarHost.c
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "SolarHost.h"
+
+uint8_t		SolarHost_IO[0x40];
+
+void	SolarHost_WDT_vect(void);
+void	SolarHost_ADC_vect(void);
+void	SolarHost_TIM0_OVF_vect(void);
+void	SolarHost_PCINT0_vect(void);
+
+#define		main	SolarHost_FirmwareMain
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarCounter-Tiny10.c"
+#undef		main
+
+uint8_t		SolarHost_Flash[FLASHEND + 1];
+uint8_t		SolarHost_Data[RAMEND + 1];
+
+#define		WDT_BASE_PERIOD_MS		16 // 2k cycles of the 128kHz WDT oscillator
+
+#if defined(FADE_ENGINE_ENABLED) || defined(WDT_DRIFT_ENABLED) || defined(FULL_DUTY_LOAD_ENABLED)
+#define		HOST_TIMER0_INTERRUPT	// The firmware uses the Timer0 overflow interrupt
+#endif
+
+int32_t		SolarHost_WdtDriftPpm;
+uint32_t	SolarHost_MotionEveryS;
+uint32_t	SolarHost_FrozenPwm;
+
+static jmp_buf	InitialisationDone;
+static uint8_t	SensorInput;
+#ifdef		HOST_TIMER0_INTERRUPT
+static uint32_t	OverflowRemainder;	// Timer0 overflow time carried over between WDT periods, in ms/OVF_HZ
+#endif
+static uint8_t	LoadedDuty;			// OCR0x as Timer0 has loaded it, see SleepAfterInterrupt()
+static bool		TimerWasRunning;
+static bool		PwmFrozen;
+
+static void		SleepAfterInterrupt(void);
+
+/*
+  The firmware enables interrupts as the very last step of initialisation, after which main()
+  only sleeps. Jumping back out of sei() is the easiest way to run just the initialisation.
+*/
+void SolarHost_Sei(void)
+{
+	longjmp(InitialisationDone, 1);
+}
+
+void SolarHost_Reset(uint8_t Input)
+{
+	memset(SolarHost_IO, 0, sizeof(SolarHost_IO));
+	SensorInput = Input;
+	
+	// Cold start: SRAM holds no defined values (the firmware clears .bss, but be fair to it):
+	Ticks = 0;
+	DayStreak = 0;
+	NightStreak = 0;
+	WDT_CountDown = 0;
+	OperationalFlags = 0;
+	TicksLimitPWM1 = 0;
+	TicksLimitPWM2 = 0;
+#ifdef		FADE_ENGINE_ENABLED
+	LightTarget = 0;
+	FadeCountDown = 0;
+#endif
+#ifdef		HOST_TIMER0_INTERRUPT
+	OverflowRemainder = 0;
+#endif
+	LoadedDuty = 0;
+	TimerWasRunning = false;
+	PwmFrozen = false;
+	SolarHost_FrozenPwm = 0;
+#ifdef		WDT_DRIFT_ENABLED
+	DriftOverflows = 0;
+	DriftPeriod = 0;
+	DriftCarry = 0;
+#endif
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+	DarkTicks = 0;
+	MidnightPhase = 0;
+#endif
+#ifdef		PREDAWN_LIGHT_ENABLED
+	HalfNight = 0;
+#endif
+#ifdef		LIFETIME_STATS_ENABLED
+	memset(&LifetimeStats, 0, sizeof(LifetimeStats)); // No magic, the firmware starts it over
+#endif
+#ifdef		UNIT_CONFIG_ENABLED
+	// Program the release block, unless a unit block was put there before the reset:
+	if(SolarHost_Flash[UNIT_CONFIG_ADDRESS] != UNIT_CONFIG_MAGIC)
+		memcpy(&SolarHost_Flash[UNIT_CONFIG_ADDRESS], &UnitConfigDefaults, UNIT_CONFIG_BYTES);
+#endif
+	
+	if(setjmp(InitialisationDone) == 0)
+		SolarHost_FirmwareMain();
+	SleepAfterInterrupt();
+}
+
+/*
+  The main loop going back to sleep after an interrupt. In Idle Timer0 runs on and loads OCR0x at
+  the end of the PWM period, in any deeper sleep mode it stops with the duty it had loaded on the pin,
+  which is only right for full brightness (a constant high output). The firmware writes OCR0x before
+  it starts the timer, that one is loaded right away. Counts the times the output got stuck.
+*/
+static void SleepAfterInterrupt(void)
+{
+	bool	PowerDown = false;
+	bool	Frozen;
+	
+#ifndef		SMCR_UNDIFFERENTIATED
+	PowerDown = (OperationalFlags & FLAG_PWM_OPERATONAL) == 0;
+#endif
+	if( !TimerWasRunning || !PowerDown )
+		LoadedDuty = OCR0OUT_REGISTER_LOW;
+	TimerWasRunning = TCCR0B != 0x00;
+	
+	Frozen = TimerWasRunning && PowerDown
+		&& ((LoadedDuty != MAXIMUM_OCR0L_INTERNAL) || (OCR0OUT_REGISTER_LOW != MAXIMUM_OCR0L_INTERNAL));
+	if( Frozen && !PwmFrozen )
+		SolarHost_FrozenPwm++;
+	PwmFrozen = Frozen;
+}
+
+#ifdef		HOST_TIMER0_INTERRUPT
+/*
+  Runs the Timer0 overflows of the WDT period that just ended. The fade engine only does
+  something every FadeCountDown overflows, so the ones in between are skipped in one go, and
+  the WDT drift measurement only counts them.
+*/
+static void RunTimer0(void)
+{
+	uint32_t	Overflows;
+	uint32_t	Skip;
+	
+	OverflowRemainder += SolarHost_WdtPeriodMs() * TIMER0_OVERFLOW_HZ;
+	Overflows = OverflowRemainder / 1000;
+	OverflowRemainder %= 1000;
+	
+	while( (Overflows != 0) && ((TIMSK0 & (1<<TOIE0)) != 0) )
+	{
+#ifdef		WDT_DRIFT_ENABLED
+		if( DriftIsRunning() )
+		{ // Never along with a ramp, see StartFade()
+#ifdef		FULL_DUTY_LOAD_ENABLED
+			SolarHost_TIM0_OVF_vect(); // Counts the first one, and sees a full duty loaded
+			SleepAfterInterrupt();
+			Overflows--;
+#endif
+			DriftOverflows += (uint16_t)Overflows;
+			break;
+		}
+#endif
+#ifdef		FADE_ENGINE_ENABLED
+		Skip = FadeCountDown - 1;
+		if(Skip > Overflows - 1)
+			Skip = Overflows - 1;
+		FadeCountDown -= Skip;
+		Overflows -= Skip + 1;
+		SolarHost_TIM0_OVF_vect();
+		SleepAfterInterrupt();
+#else
+		(void)Skip;
+		SolarHost_TIM0_OVF_vect(); // The one after SetFullDuty()
+		SleepAfterInterrupt();
+		break;
+#endif
+	}
+}
+#endif
+
+/*
+  ADCSRA. A conversion started with the interrupt disabled is polled (the cold start does that
+  at power-up), so it is done the moment anything looks at the register, on the reading of the
+  last reset or tick. The ones the WDT interrupt starts are finished in SolarHost_Tick().
+*/
+uint8_t *SolarHost_AdcControl(void)
+{
+	uint8_t	*Register = &SolarHost_IO[0x1D];
+	
+	if( (*Register & ((1<<ADSC)|(1<<ADIE))) == (1<<ADSC) )
+	{
+		ADCL = SensorInput;
+		*Register = (*Register & ~(1<<ADSC)) | (1<<ADIF);
+	}
+	return Register;
+}
+
+bool SolarHost_Tick(uint8_t Input)
+{
+	SensorInput = Input;
+#ifdef		HOST_TIMER0_INTERRUPT
+	RunTimer0();
+#endif
+	SolarHost_WDT_vect();
+	
+	// The WDT interrupt starts a conversion by writing ADCSRA, finish it right away:
+	if( (ADCSRA & ((1<<ADSC)|(1<<ADIE))) == ((1<<ADSC)|(1<<ADIE)) )
+	{
+		ADCL = SensorInput;
+		ADCSRA &= ~(1<<ADSC);
+		SolarHost_ADC_vect();
+		SleepAfterInterrupt();
+		return true;
+	}
+	SleepAfterInterrupt();
+	return false;
+}
+
+void SolarHost_Motion(void)
+{
+#ifdef		MOTION_SENSOR_ENABLED
+	// Someone walks by: the sensor output goes active and back, a pin change interrupt for each edge
+	for(uint8_t Edge = 0; Edge < 2; Edge++)
+	{
+#ifdef		MOTION_ACTIVE_LOW
+		bool	High = (Edge != 0);
+#else
+		bool	High = (Edge == 0);
+#endif
+		if(High)
+			PINB |= PORTB_MOTION_PIN;
+		else
+			PINB &= ~PORTB_MOTION_PIN;
+		if( ((PIN_CHANGE_CONTROL_REGISTER & PIN_CHANGE_ENABLE) != 0) && ((PCMSK & PCMSK_MOTION_PIN) != 0) )
+		{
+			SolarHost_PCINT0_vect();
+			SleepAfterInterrupt();
+		}
+	}
+#endif
+}
+
+size_t SolarHost_StatsBlock(const uint8_t **Block, uint16_t *Address)
+{
+#ifdef		LIFETIME_STATS_ENABLED
+	*Block = (const uint8_t *)&LifetimeStats;
+	*Address = STATS_ADDRESS;
+	return STATS_BYTES;
+#else
+	*Block = NULL;
+	*Address = 0;
+	return 0;
+#endif
+}
+
+uint32_t SolarHost_WdtPeriodMs(void)
+{
+	uint8_t		Prescaler = ((WDTCSR >> 2) & 0x08) | (WDTCSR & 0x07);
+	uint64_t	Period = (uint64_t)WDT_BASE_PERIOD_MS << Prescaler;
+	
+	if( SolarHost_WdtDriftPpm != 0 )
+		Period = (Period * (uint64_t)(1000000 + SolarHost_WdtDriftPpm) + 500000) / 1000000;
+	return (uint32_t)Period;
+}
+
+void SolarHost_GetState(SolarHostState *State)
+{
+	State->Ticks = Ticks;
+	State->DayStreak = DayStreak;
+	State->NightStreak = NightStreak;
+	State->WDT_CountDown = WDT_CountDown;
+	State->OperationalFlags = OperationalFlags;
+	State->TicksLimitPWM1 = TicksLimitPWM1;
+	State->TicksLimitPWM2 = TicksLimitPWM2;
+	State->Duty = OCR0OUT_REGISTER_LOW;
+	State->Boost = (PORTB & PORTB_ENABLEBOOST_PIN) != 0;
+}
+
+// True when SolarHost_MotionEveryS has a passer-by come along in the WDT period that ends at TimeMs:
+static bool MotionBefore(uint64_t TimeMs, uint64_t PeriodMs)
+{
+	uint64_t	EveryMs = (uint64_t)SolarHost_MotionEveryS * 1000;
+	
+	return (EveryMs != 0) && ((TimeMs / EveryMs) != ((TimeMs - PeriodMs) / EveryMs));
+}
+
+/*
+  Runs the firmware over a whole trace, from power-up at the first sample. Every WDT interrupt
+  happens one WDT period after the previous one and sees the trace sample covering that moment.
+  Returns the number of samples the firmware took.
+*/
+uint64_t SolarHost_Replay(const SolarTrace *Trace, SolarHostSampleHook Hook, void *Context)
+{
+	SolarTraceCursor	Cursor;
+	uint64_t			IntervalMs = (uint64_t)Trace->Header->SampleIntervalS * 1000;
+	uint64_t			EndMs = Trace->Header->SampleCount * IntervalMs;
+	uint64_t			TimeMs = 0;
+	uint64_t			Samples = 0;
+	
+	if( (Trace->Header->SampleCount == 0) || (IntervalMs == 0) )
+		return 0;
+	
+	SolarTrace_Begin(Trace, &Cursor);
+	SolarHost_Reset(SolarTrace_SampleAt(&Cursor, 0));
+	
+	while(1)
+	{
+		uint64_t	PeriodMs = SolarHost_WdtPeriodMs();
+		uint8_t		Input;
+		
+		TimeMs += PeriodMs;
+		if(TimeMs >= EndMs)
+			break;
+		
+		if( MotionBefore(TimeMs, PeriodMs) )
+			SolarHost_Motion();
+		Input = SolarTrace_SampleAt(&Cursor, TimeMs / IntervalMs);
+		if(SolarHost_Tick(Input))
+		{
+			Samples++;
+			if(Hook != NULL)
+				Hook(Context, TimeMs, Input);
+		}
+	}
+	return Samples;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Event-skipping replay
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// The motion sensor and the telemetry do something with every sample, SkipSample() doesn't write those out,
+// and with the WDT drift measurement every sample interval is worked out anew:
+#if defined(MOTION_SENSOR_ENABLED) || defined(TELEMETRY_ENABLED) || defined(WDT_DRIFT_ENABLED)
+#define		SKIP_SAMPLES		0 // Those builds only skip the WDT interrupts in between samples
+#else
+#define		SKIP_SAMPLES		1
+#endif
+
+typedef enum
+{
+	RUN_NONE,
+	RUN_DAY,		// Day mode, lights off, and SwitchToDayMode() would change nothing
+	RUN_NIGHT		// Light on and counting down, no ramp or fade-out running
+} SolarHostRun;
+
+/*
+  True when a WDT interrupt that doesn't start a conversion does nothing but count down
+  WDT_CountDown (and set FLAG_SET_SLEEP, which stays set on the host, nothing clears it), apart
+  from the slow turn-off step without the fade engine, see SkipTicks().
+*/
+static bool TickIsQuiet(void)
+{
+	if( (WDTCSR & (1<<WDIE)) == 0 )
+		return false;
+#ifdef		HOST_TIMER0_INTERRUPT
+	if( (TIMSK0 & (1<<TOIE0)) != 0 )
+		return false; // A ramp or a drift measurement is running
+#endif
+#ifdef		MOTION_SENSOR_ENABLED
+	if( MotionHold != 0 )
+		return false;
+#ifndef		FADE_ENGINE_ENABLED
+	if( ((OperationalFlags & FLAG_LIGHTISON) == FLAG_LIGHTISON) && (OCR0OUT_REGISTER_LOW > ScheduledDuty()) )
+		return false; // EndMotionHold() steps back to the schedule
+#endif
+#endif
+#ifdef		WDT_DRIFT_ENABLED
+	if( (DriftOverflows == WDT_DRIFT_ARMED)
+		&& ((OperationalFlags & (FLAG_LIGHTISON | FLAG_PWM_OPERATONAL | FLAG_SLOWTURNOFF)) == (FLAG_LIGHTISON | FLAG_PWM_OPERATONAL)) )
+		return false; // RunDriftMeasurement() starts on the next one
+#endif
+	return true;
+}
+
+// Same as Count calls of RunTimer0() without a ramp running:
+static void SkipTimer0(uint64_t Count)
+{
+#ifdef		HOST_TIMER0_INTERRUPT
+	OverflowRemainder = (uint32_t)((OverflowRemainder + Count * SolarHost_WdtPeriodMs() * TIMER0_OVERFLOW_HZ) % 1000);
+#else
+	(void)Count;
+#endif
+}
+
+/*
+  Runs up to Count WDT interrupts that don't start a conversion, in one go, as long as they only
+  count down (or step the slow turn-off, but not the last step). Returns how many it ran.
+*/
+static uint64_t SkipTicks(uint64_t Count)
+{
+	if( (Count == 0) || !TickIsQuiet() )
+		return 0;
+#ifndef		FADE_ENGINE_ENABLED
+	if( (OperationalFlags & FLAG_SLOWTURNOFF) == FLAG_SLOWTURNOFF )
+	{
+		uint8_t	Steps = (OCR0OUT_REGISTER_LOW > OCR0_DECREASE_STEPSIZE) ? (OCR0OUT_REGISTER_LOW - 1) / OCR0_DECREASE_STEPSIZE : 0;
+		
+		if(Count > Steps)
+			Count = Steps;
+		SET_OCR0OUT(OCR0OUT_REGISTER_LOW - (uint8_t)Count * OCR0_DECREASE_STEPSIZE);
+	}
+#endif
+	SkipTimer0(Count);
+	WDT_CountDown -= (uint8_t)Count;
+	if(Count != 0)
+		OperationalFlags |= FLAG_SET_SLEEP;
+	return Count;
+}
+
+// True when SwitchToDayMode() would write what is there already:
+static bool DayModeIsSettled(void)
+{
+	return (TCCR0A == 0x00) && (TCCR0B == 0x00) && (OCR0OUT_REGISTER_LOW == INITIAL_OCR0L_INTERNAL)
+		&& (OCR0OUT_REGISTER_HIGH == 0) && ((PORTB & PORTB_ENABLEBOOST_PIN) == 0)
+		&& (WDTCSR == WDTCR_VALUE_DAY) && ((PRR & PRR_TIMEROFF) == PRR_TIMEROFF)
+#ifdef		HOST_TIMER0_INTERRUPT
+		&& (TIMSK0 == 0x00)
+#endif
+		&& ((OperationalFlags & (FLAG_SLOWTURNOFF | FLAG_LIGHTISON | FLAG_PWM_OPERATONAL | FLAG_MORNING_LIGHT | FLAG_RUNNING_DAY)) == FLAG_RUNNING_DAY);
+}
+
+// Which kind of run the firmware is in after the sample it just took:
+static SolarHostRun ClassifyRun(void)
+{
+	if( !SKIP_SAMPLES || !TickIsQuiet() )
+		return RUN_NONE;
+	if( (OperationalFlags & FLAG_RUNNING_DAY) == FLAG_RUNNING_DAY )
+		return DayModeIsSettled() ? RUN_DAY : RUN_NONE;
+	if( (OperationalFlags & (FLAG_LIGHTISON | FLAG_SLOWTURNOFF | FLAG_MORNING_LIGHT)) == FLAG_LIGHTISON )
+		return RUN_NIGHT;
+	return RUN_NONE;
+}
+
+// True when the afterglow step (or dusk ramp duty) the ADC interrupt does at NewTicks writes what is there already:
+static bool NightStepIsSettled(uint16_t NewTicks, uint8_t Input)
+{
+	uint8_t	Duty;
+	
+#ifdef		DUSK_RAMP_ENABLED
+	Duty = NightDuty(NewTicks, Input); // Written on every sample, full brightness included
+#else
+	(void)Input;
+	if( AFTERGLOW_STEP2_REACHED(NewTicks) )
+		Duty = CFG_LIMITATION_PWM2;
+	else if( AFTERGLOW_STEP1_REACHED(NewTicks) )
+		Duty = CFG_LIMITATION_PWM1;
+	else
+		return true; // No step at full brightness
+#endif
+	
+	if( (OCR0OUT_REGISTER_LOW != Duty) || (OCR0OUT_REGISTER_HIGH != 0) )
+		return false;
+#ifdef		FADE_ENGINE_ENABLED
+	return LightTarget == Duty; // And no ramp running, see TickIsQuiet()
+#elif defined(DUSK_RAMP_ENABLED)
+	return ((OperationalFlags & FLAG_PWM_OPERATONAL) != 0) == (Duty != MAXIMUM_OCR0L_INTERNAL);
+#else
+	return (OperationalFlags & FLAG_PWM_OPERATONAL) == FLAG_PWM_OPERATONAL;
+#endif
+}
+
+/*
+  ISR(ADC_vect) written out for the two runs, for the samples that only count: Ticks, the
+  streaks and the midnight clock. Returns false, and changes nothing, for a sample that would do anything else (switch
+  modes, change a flag, step the afterglow or start the fade-out), which the firmware has to run.
+  Nothing in a run writes a register, so what ClassifyRun() checked stays true along the way.
+*/
+static bool SkipSample(SolarHostRun Run, uint8_t Input)
+{
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+	uint16_t	NewDarkTicks = DarkTicks;
+	uint16_t	NewPhase = MidnightPhase;
+	uint8_t		Step = (Run == RUN_DAY) ? DAY_SAMPLE_DARK_TICKS : 1;
+	
+	// RunMidnightClock():
+	if( (NewDarkTicks != 0) && (NewDarkTicks <= MIDNIGHT_DARK_MAXIMUM + MIDNIGHT_DAWN_TICKS) )
+		NewDarkTicks += Step;
+	if( NewPhase != MIDNIGHT_PHASE_UNKNOWN )
+	{
+		NewPhase += Step;
+		if( NewPhase >= MIDNIGHT_DAY_TICKS )
+			NewPhase -= MIDNIGHT_DAY_TICKS;
+	}
+#ifdef		PREDAWN_LIGHT_ENABLED
+	// RunMorningLight(), the flag is clear in both runs:
+	if( (Run == RUN_DAY) && (HalfNight != 0) && (NewDarkTicks != 0) )
+	{
+		int16_t	Since = (int16_t)NewPhase - ((int16_t)HalfNight - PREDAWN_LEAD_MINUTES);
+		
+		if( Since < 0 )
+			Since += MIDNIGHT_DAY_TICKS;
+		if( Since < (int16_t)DAY_SAMPLE_DARK_TICKS )
+			return false; // The morning window opens
+	}
+#endif
+#endif
+	
+	if( Input > CFG_LIGHT_THRESHOLD )
+	{
+		if( DayStreak + 1 >= MINIMUM_DAY_STREAK )
+		{
+			if( (Run == RUN_NIGHT) || ((OperationalFlags & FLAG_LASTMODE_WAS_DAY) == 0) )
+				return false; // Day break, or the first confirmed day after the night
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+			if( NewDarkTicks != 0 )
+				return false; // The end of a measured night
+#endif
+			DayStreak = 0; // Day mode again, which is settled
+		}
+		else
+			DayStreak++;
+		Ticks++;
+#ifdef		LIFETIME_STATS_ENABLED
+		if( (Run == RUN_DAY) && (NightStreak != 0) && ((OperationalFlags & FLAG_LASTMODE_WAS_DAY) == FLAG_LASTMODE_WAS_DAY) )
+			STATS_INCREMENT(LifetimeStats.AbortedDusks);
+#endif
+		NightStreak = 0;
+	}
+	else if( Input < CFG_DARK_THRESHOLD )
+	{
+		if(Run == RUN_DAY)
+		{
+			if( (OperationalFlags & FLAG_LASTMODE_WAS_DAY) == FLAG_LASTMODE_WAS_DAY )
+			{
+				if( NightStreak + 1 >= MINIMUM_NIGHT_STREAK )
+					return false; // May be the night trigger
+				NightStreak++;
+			}
+		}
+		else
+		{
+			if( (Ticks == 1) || !NightStepIsSettled(Ticks - 1, Input) )
+				return false;
+			Ticks--;
+			if( DayStreak != 0 )
+			{
+				if( ++NightStreak >= MINIMUM_NIGHT_TO_RESET_DAY )
+				{
+					NightStreak = 0;
+					DayStreak = 0;
+#ifdef		LIFETIME_STATS_ENABLED
+					if( STATS_TICKS(Ticks + MINIMUM_NIGHT_TO_RESET_DAY) != LifetimeStats.Afterglow )
+						STATS_INCREMENT(LifetimeStats.DayResets);
+#endif
+				}
+			}
+		}
+	}
+	// In between the thresholds the ADC interrupt does nothing at all
+	
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+	DarkTicks = NewDarkTicks;
+	MidnightPhase = NewPhase;
+#endif
+	ADCL = Input;
+	SensorInput = Input;
+	OperationalFlags |= FLAG_SET_SLEEP;
+	return true;
+}
+
+/*
+  Same as SolarHost_Replay(), bit for bit, but the WDT interrupts that only count down are jumped
+  over, and so are the samples that only count (see SkipSample()): the trace is read at the sample
+  times only, and the firmware runs where something changes. The hook is only called for the
+  samples the firmware ran, which includes every sample that changed the flags, duty or boost.
+  The motion sensor, telemetry and WDT drift builds turn SKIP_SAMPLES off: every sample runs there.
+*/
+uint64_t SolarHost_ReplayEvents(const SolarTrace *Trace, SolarHostSampleHook Hook, void *Context, SolarHostReplayStats *Stats)
+{
+	SolarTraceCursor	Cursor;
+	uint64_t			IntervalMs = (uint64_t)Trace->Header->SampleIntervalS * 1000;
+	uint64_t			EndMs = Trace->Header->SampleCount * IntervalMs;
+	uint64_t			TimeMs = 0;
+	uint64_t			Samples = 0;
+	SolarHostReplayStats	Count = { 0, 0 };
+	
+	if( (Trace->Header->SampleCount == 0) || (IntervalMs == 0) )
+		return 0;
+	
+	SolarTrace_Begin(Trace, &Cursor);
+	SolarHost_Reset(SolarTrace_SampleAt(&Cursor, 0));
+	
+	while(1)
+	{
+		uint64_t		PeriodMs = SolarHost_WdtPeriodMs();
+		uint8_t			Input;
+		SolarHostRun	Run;
+		
+		// The WDT interrupts up to the one that starts the next conversion:
+		if( WDT_CountDown > 1 )
+		{
+			uint64_t	Skip = WDT_CountDown - 1;
+			uint64_t	UntilMs = EndMs;
+			
+			if(SolarHost_MotionEveryS != 0) // Not past the WDT period with the next passer-by
+				UntilMs = (TimeMs / (SolarHost_MotionEveryS * 1000ULL) + 1) * (SolarHost_MotionEveryS * 1000ULL);
+			if(UntilMs > EndMs)
+				UntilMs = EndMs;
+			if( TimeMs + Skip * PeriodMs >= UntilMs )
+				Skip = (UntilMs - TimeMs - 1) / PeriodMs;
+			TimeMs += SkipTicks(Skip) * PeriodMs;
+		}
+		
+		TimeMs += PeriodMs;
+		if(TimeMs >= EndMs)
+			break;
+		
+		if( MotionBefore(TimeMs, PeriodMs) )
+			SolarHost_Motion();
+		Input = SolarTrace_SampleAt(&Cursor, TimeMs / IntervalMs);
+		Count.Interrupts++;
+		if( !SolarHost_Tick(Input) )
+			continue;
+		
+		Samples++;
+		Count.Interrupts++;
+		if(Hook != NULL)
+			Hook(Context, TimeMs, Input);
+		
+		// Then the samples after it, as long as they only count:
+		Run = ClassifyRun();
+		if(Run != RUN_NONE)
+		{
+			uint8_t		SampleTicks = IsSetToDayMode() ? CFG_TICKS_BEFORE_SAMPLE_DAY : CFG_TICKS_BEFORE_SAMPLE_NIGHT;
+			uint64_t	NextMs;
+			uint64_t	Skipped = 0;
+			
+			PeriodMs = SolarHost_WdtPeriodMs(); // The sample may have switched modes
+			NextMs = TimeMs + (uint64_t)WDT_CountDown * PeriodMs; // The count-down was loaded before the switch
+			
+			while( (NextMs < EndMs) && SkipSample(Run, SolarTrace_SampleAt(&Cursor, NextMs / IntervalMs)) )
+			{
+				SkipTimer0( (Skipped == 0) ? WDT_CountDown : SampleTicks );
+				WDT_CountDown = SampleTicks; // Reloaded at the sample
+				Skipped++;
+				TimeMs = NextMs;
+				NextMs += SampleTicks * PeriodMs;
+			}
+			Samples += Skipped;
+			Count.SkippedSamples += Skipped;
+		}
+	}
+	
+	if(Stats != NULL)
+		*Stats = Count;
+	return Samples;
+}
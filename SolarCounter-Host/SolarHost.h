@@ -0,0 +1,99 @@
+/*
+ * SolarHost.h
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Host build of the firmware: SolarHost.c compiles SolarCounter-Tiny10.c itself, unchanged,
+ * against the register stand-ins in avr/, so everything run through here behaves exactly like
+ * the firmware does (as far as C semantics go, the compiler for the chip may still surprise).
+ *
+ * The firmware keeps its state in globals, so there is one controller per process. Tools that
+ * need many at once (fleet runs, sweeps) have to use their own model and check it against this one.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#ifndef __SOLAR_HOST_H__
+#define __SOLAR_HOST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SolarTrace.h"
+
+typedef struct
+{
+	uint16_t	Ticks;
+	uint8_t		DayStreak;
+	uint8_t		NightStreak;
+	uint8_t		WDT_CountDown;
+	uint8_t		OperationalFlags;
+	uint16_t	TicksLimitPWM1;
+	uint16_t	TicksLimitPWM2;
+	uint8_t		Duty;			// OCR0OUT_REGISTER_LOW
+	bool		Boost;			// PORTB_ENABLEBOOST_PIN is high
+} SolarHostState;
+
+// Called after every sample the firmware took, with the time since the start of the trace:
+typedef void (*SolarHostSampleHook)(void *Context, uint64_t TimeMs, uint8_t Sample);
+
+typedef struct
+{
+	uint64_t	Interrupts;		// WDT and ADC interrupts the firmware actually ran
+	uint64_t	SkippedSamples;	// Samples applied in closed form, without running the ADC interrupt
+} SolarHostReplayStats;
+
+void		SolarHost_Reset(uint8_t Input);		// Power-up, Input is the sensor reading at that time
+bool		SolarHost_Tick(uint8_t Input);		// One WDT interrupt, true if the firmware took a sample
+uint32_t	SolarHost_WdtPeriodMs(void);		// Time to the next WDT interrupt, as currently configured
+
+// WDT oscillator error for all of the above, in parts per million, positive is slow. 0 at start-up,
+// which is the nominal period the firmware assumes. The Timer0 clock always runs exact.
+extern int32_t	SolarHost_WdtDriftPpm;
+
+// USE_MOTION_SENSOR: a passer-by, the sensor output active and back, before the next SolarHost_Tick().
+// The replays below bring one along every SolarHost_MotionEveryS seconds of the trace, 0 is nobody.
+void		SolarHost_Motion(void);
+extern uint32_t	SolarHost_MotionEveryS;
+// Times since the last reset the core went to Power-Down with the PWM output not (yet) at full
+// brightness, which stops it halfway. Should stay 0:
+extern uint32_t	SolarHost_FrozenPwm;
+
+void		SolarHost_GetState(SolarHostState *State);
+// The lifetime statistics as the firmware has them and their data space address on the chip, 0 bytes if not built in:
+size_t		SolarHost_StatsBlock(const uint8_t **Block, uint16_t *Address);
+
+uint64_t	SolarHost_Replay(const SolarTrace *Trace, SolarHostSampleHook Hook, void *Context);
+
+/*
+  The same replay, bit for bit, with the interrupts that only count jumped over. The hook then only
+  sees the samples the firmware ran, but always the ones that changed the flags, duty or boost.
+  Builds with USE_MOTION_SENSOR, USE_TELEMETRY or USE_WDT_DRIFT run every sample (SKIP_SAMPLES is 0
+  for them) and only jump over the WDT interrupts in between. Stats may be NULL.
+*/
+uint64_t	SolarHost_ReplayEvents(const SolarTrace *Trace, SolarHostSampleHook Hook, void *Context,
+								   SolarHostReplayStats *Stats);
+
+#endif // __SOLAR_HOST_H__
@@ -0,0 +1,331 @@
+/*
+ * SolarPwm.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Picks PWM_FREQUENCY_HZ and PWM_PHASE_CORRECT (SolarConfig.h) for a boost converter:
+ *   gcc -O2 -I. -o SolarPwm SolarPwm.c -lm
+ *
+ * Usage:
+ *   SolarPwm [-k clock] [-f minimum] [-d duty,...] [-l W] [-e uJ] [-r ohm] [-c uF] [-v V] [-i W] [-p W/W] [-n rows]
+ *
+ * Every setting the firmware can make at the system clock of the build this is compiled against
+ * (or the one given with -k) is run through a loss model of the lamp: battery, input capacitor,
+ * boost converter and LEDs. The converter is switched by the PWM, so it loses:
+ *   -- Per PWM period, the energy to start up again: its soft-start, the inductor and output
+ *      capacitor charge that is not delivered to the LEDs, and the enable switching (-e). This
+ *      grows with the frequency.
+ *   -- In the source, the pulsed input current through the battery and wiring resistance (-r).
+ *      The input capacitor (-c) smooths it above its corner 1/(2 pi R C), so this shrinks with
+ *      the frequency.
+ *   -- Its own conduction and idle losses, BoostLossPerW and BoostIdleW as in SolarEnergy.h
+ *      (-p and -i). They don't depend on the frequency, but are in the efficiency shown.
+ * The light is the LED power at the duty the timer really makes, so the rounding of a TOP below
+ * 255 costs nothing, only the switching does.
+ *
+ * The duties are the ones the build lights at (full, and the two limitation levels), out of 255
+ * like in SolarConfig.h; the efficiency shown is their average. Settings below the flicker minimum
+ * (-f, 1250Hz by default, 0 to allow all of them) are left out. The best one is printed as the
+ * lines for SolarConfig.h, and the setting of the build for comparison.
+ *
+ * Options:
+ *   -k clock       System clock in Hz, in stead of SYSTEM_CLOCK_HZ of the build
+ *   -f minimum     Lowest PWM frequency allowed, Hz
+ *   -d duty,...    Duties to average over, out of 255
+ *   -l W           LED power at 100% duty
+ *   -e uJ          Converter energy lost per PWM period
+ *   -r ohm         Battery and wiring resistance in front of the converter
+ *   -c uF          Converter input capacitance
+ *   -v V           Battery voltage
+ *   -i W           Converter idle loss while enabled
+ *   -p W/W         Converter conduction loss per W of LED power, times the LED power
+ *   -n rows        Number of settings listed
+ *
+ * The model only ranks the settings, the numbers are as good as the parameters. Measure the
+ * battery current at two frequencies to find -e and -r for a converter.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <avr/io.h>
+
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarCounter.h"
+
+#define		DUTIES_MAXIMUM			8
+#define		SETTINGS_MAXIMUM		4096
+#define		TOP_MINIMUM				63		// As checked in SolarCounter.h
+#define		TOP_MAXIMUM				255
+
+#ifdef PWM_PHASE_CORRECT_ENABLED
+#define		BUILD_PHASE_CORRECT		true
+#else
+#define		BUILD_PHASE_CORRECT		false
+#endif
+
+static const unsigned long Dividers[] = { 1, 8, 64, 256, 1024 };
+
+typedef struct
+{
+	double		LedW;
+	double		EdgeJ;				// Lost per PWM period
+	double		SourceOhm;
+	double		InputF;
+	double		BatteryV;
+	double		BoostIdleW;
+	double		BoostLossPerW;
+} ConverterModel;
+
+typedef struct
+{
+	unsigned long	FrequencyHz;	// The PWM_FREQUENCY_HZ that gives it, the lowest one
+	bool			PhaseCorrect;
+	unsigned long	Divider;
+	unsigned long	Top;
+	double			ActualHz;
+	double			Efficiency;		// Average over the duties
+	double			LossW;			// Frequency dependent part, average over the duties
+} PwmSetting;
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: SolarPwm [-k clock] [-f minimum] [-d duty,...] [-l W] [-e uJ] [-r ohm] [-c uF] [-v V] [-i W] [-p W/W] [-n rows]\n");
+	exit(2);
+}
+
+static double PositiveOption(const char *Text, bool ZeroAllowed)
+{
+	char	*End;
+	double	Value = strtod(Text, &End);
+	
+	if( (*End != '\0') || (Value < 0.0) || (!ZeroAllowed && (Value == 0.0)) )
+		Usage();
+	return Value;
+}
+
+// Same selection as SolarCounter.h: the smallest prescaler with a TOP of 255 or below.
+static bool SettingFor(unsigned long ClockHz, unsigned long FrequencyHz, bool PhaseCorrect, PwmSetting *Setting)
+{
+	for(size_t Index = 0; Index < sizeof(Dividers) / sizeof(Dividers[0]); Index++)
+	{
+		unsigned long	Divider = Dividers[Index];
+		long			Top = ClockHz / (Divider * (PhaseCorrect ? 2 : 1) * FrequencyHz) - (PhaseCorrect ? 0 : 1);
+		
+		if(Top > TOP_MAXIMUM)
+			continue;
+		if(Top < TOP_MINIMUM)
+		{
+			if(Index == 0)
+				return false;
+			Divider = Dividers[Index - 1]; // Like SolarCounter.h: the prescaler below with a TOP of 255
+			Top = TOP_MAXIMUM;
+		}
+		Setting->FrequencyHz = FrequencyHz;
+		Setting->PhaseCorrect = PhaseCorrect;
+		Setting->Divider = Divider;
+		Setting->Top = (unsigned long)Top;
+		Setting->ActualHz = (double)ClockHz / (Divider * (PhaseCorrect ? 2.0 * Top : Top + 1.0));
+		return true;
+	}
+	return false;
+}
+
+// Part of the period the LED is on at a duty out of 255, scaled like PWM_LEVEL:
+static double OnFraction(const PwmSetting *Setting, unsigned Duty)
+{
+	unsigned long	Level = ((Duty * (Setting->Top + 1)) + Setting->Top) >> 8;
+	
+	if(Setting->PhaseCorrect)
+		return (double)Level / Setting->Top;
+	return (Level + 1.0) / (Setting->Top + 1.0);
+}
+
+static void Evaluate(PwmSetting *Setting, const ConverterModel *Model, const unsigned *Duties, int DutyCount)
+{
+	double	CornerHz = 1.0 / (2.0 * M_PI * Model->SourceOhm * Model->InputF);
+	double	Ratio = Setting->ActualHz / CornerHz;
+	
+	Setting->Efficiency = 0.0;
+	Setting->LossW = 0.0;
+	for(int Index = 0; Index < DutyCount; Index++)
+	{
+		double	On = OnFraction(Setting, Duties[Index]);
+		double	LightW = Model->LedW * On;
+		double	ConverterW = Model->BoostIdleW + Model->BoostLossPerW * Model->LedW * Model->LedW * On;
+		double	SwitchedW = 0.0;
+		
+		if(On < 1.0)
+		{
+			double	PeakA = (Model->LedW + Model->BoostLossPerW * Model->LedW * Model->LedW) / Model->BatteryV;
+			
+			// Energy to start every period, and the AC part of the input current in the source:
+			SwitchedW = Model->EdgeJ * Setting->ActualHz;
+			SwitchedW += Model->SourceOhm * PeakA * PeakA * On * (1.0 - On) / (1.0 + Ratio * Ratio);
+		}
+		Setting->Efficiency += LightW / (LightW + ConverterW + SwitchedW);
+		Setting->LossW += SwitchedW;
+	}
+	Setting->Efficiency /= DutyCount;
+	Setting->LossW /= DutyCount;
+}
+
+static int ByEfficiency(const void *Left, const void *Right)
+{
+	const PwmSetting	*A = Left, *B = Right;
+	
+	if(A->Efficiency != B->Efficiency)
+		return (A->Efficiency < B->Efficiency) ? 1 : -1;
+	return (A->ActualHz > B->ActualHz) ? 1 : -1; // The lower frequency switches the enable less
+}
+
+static void PrintSetting(const PwmSetting *Setting)
+{
+	printf("%7lu  %-13s  %4lu  %3lu  %9.1f  %6.2f%%  %7.1f\n", Setting->FrequencyHz,
+		   Setting->PhaseCorrect ? "phase correct" : "fast", Setting->Divider, Setting->Top,
+		   Setting->ActualHz, 100.0 * Setting->Efficiency, 1000.0 * Setting->LossW);
+}
+
+int main(int argc, char **argv)
+{
+	ConverterModel	Model;
+	unsigned long	ClockHz = SYSTEM_CLOCK_HZ;
+	double			MinimumHz = 1250.0;
+	unsigned		Duties[DUTIES_MAXIMUM] = { MAXIMUM_OCR0 & 0x0FF, LIMITATION_PWM1_SELECTED, LIMITATION_PWM2_SELECTED };
+	int				DutyCount = 3;
+	int				Rows = 10;
+	int				Option;
+	PwmSetting		*Settings;
+	PwmSetting		Build;
+	int				Count = 0;
+	
+	// The converter of SolarEnergy_DefaultModel, the rest typical of a 1W-5W boost LED driver:
+	Model.LedW = 3.0;
+	Model.EdgeJ = 2.0e-6;
+	Model.SourceOhm = 0.15;
+	Model.InputF = 100.0e-6;
+	Model.BatteryV = 3.7;
+	Model.BoostIdleW = 0.03;
+	Model.BoostLossPerW = 0.02;
+	
+	while( (Option = getopt(argc, argv, "k:f:d:l:e:r:c:v:i:p:n:")) != -1 )
+	{
+		switch(Option)
+		{
+			case 'k':	ClockHz = (unsigned long)PositiveOption(optarg, false); break;
+			case 'f':	MinimumHz = PositiveOption(optarg, true); break;
+			case 'l':	Model.LedW = PositiveOption(optarg, false); break;
+			case 'e':	Model.EdgeJ = PositiveOption(optarg, true) * 1.0e-6; break;
+			case 'r':	Model.SourceOhm = PositiveOption(optarg, false); break;
+			case 'c':	Model.InputF = PositiveOption(optarg, false) * 1.0e-6; break;
+			case 'v':	Model.BatteryV = PositiveOption(optarg, false); break;
+			case 'i':	Model.BoostIdleW = PositiveOption(optarg, true); break;
+			case 'p':	Model.BoostLossPerW = PositiveOption(optarg, true); break;
+			case 'n':	Rows = (int)PositiveOption(optarg, false); break;
+			case 'd':
+			{
+				char	*Next = optarg;
+				
+				for(DutyCount = 0; (*Next != '\0') && (DutyCount < DUTIES_MAXIMUM); DutyCount++)
+				{
+					char	*End;
+					long	Value = strtol(Next, &End, 0);
+					
+					if( (End == Next) || (Value < 1) || (Value > 255) || ((*End != ',') && (*End != '\0')) )
+						Usage();
+					Duties[DutyCount] = (unsigned)Value;
+					Next = (*End == ',') ? End + 1 : End;
+				}
+				if( (DutyCount == 0) || (*Next != '\0') )
+					Usage();
+				break;
+			}
+			default:	Usage();
+		}
+	}
+	if(optind != argc)
+		Usage();
+	
+	Settings = malloc(SETTINGS_MAXIMUM * sizeof(PwmSetting));
+	if(Settings == NULL)
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	
+	// Every frequency setting, keeping the lowest one that makes each prescaler and TOP:
+	for(int Phase = 0; Phase <= 1; Phase++)
+	{
+		unsigned long	Last = 0, LastDivider = 0;
+		
+		for(unsigned long FrequencyHz = 1; FrequencyHz <= ClockHz / (TOP_MINIMUM + 1); FrequencyHz++)
+		{
+			PwmSetting	Setting;
+			
+			if(!SettingFor(ClockHz, FrequencyHz, Phase != 0, &Setting) || (Setting.ActualHz < MinimumHz))
+				continue;
+			if( (Setting.Top == Last) && (Setting.Divider == LastDivider) )
+				continue;
+			Last = Setting.Top;
+			LastDivider = Setting.Divider;
+			if(Count == SETTINGS_MAXIMUM)
+				break;
+			Evaluate(&Setting, &Model, Duties, DutyCount);
+			Settings[Count++] = Setting;
+		}
+	}
+	
+	printf("System clock %luHz, converter input corner %.0fHz, duties", ClockHz,
+		   1.0 / (2.0 * M_PI * Model.SourceOhm * Model.InputF));
+	for(int Index = 0; Index < DutyCount; Index++)
+		printf(" %u", Duties[Index]);
+	printf("\n\n%7s  %-13s  %4s  %3s  %9s  %7s  %7s\n", "Hz", "mode", "pre", "TOP", "actual", "eff", "loss mW");
+	
+	if(SettingFor(ClockHz, PWM_FREQUENCY_HZ, BUILD_PHASE_CORRECT, &Build))
+	{
+		Evaluate(&Build, &Model, Duties, DutyCount);
+		PrintSetting(&Build);
+		printf("         (the setting of this build)\n\n");
+	}
+	
+	if(Count == 0)
+	{
+		fprintf(stderr, "No setting at or above %.0fHz at this clock\n", MinimumHz);
+		return 1;
+	}
+	qsort(Settings, Count, sizeof(PwmSetting), ByEfficiency);
+	for(int Index = 0; (Index < Count) && (Index < Rows); Index++)
+		PrintSetting(&Settings[Index]);
+	
+	printf("\nFor SolarConfig.h:\n#define\t\tPWM_FREQUENCY_HZ\t\t\t\t%lu\n%s#define\t\tPWM_PHASE_CORRECT\n",
+		   Settings[0].FrequencyHz, Settings[0].PhaseCorrect ? "" : "//");
+	free(Settings);
+	return 0;
+}
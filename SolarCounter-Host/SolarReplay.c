@@ -0,0 +1,313 @@
+/*
+ * SolarReplay.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Runs the firmware (host build, see SolarHost.h) over trace files and lists what the lights
+ * did, in site clock time:
+ *   gcc -O2 -I. -o SolarReplay SolarReplay.c SolarHost.c SolarTrace.c
+ *   SolarReplay [-s] [-c] [-m dump.bin] [-w ppm] [-p seconds] site.sltr [...]
+ *
+ * Every change of the boost enable or the PWM duty is printed as one line:
+ *   site,clock time,boost,duty,Ticks
+ * With -s only a per-trace summary is printed.
+ *
+ * The replay skips the interrupts that only count, see SolarHost_ReplayEvents(). With
+ * USE_MOTION_SENSOR, USE_TELEMETRY or USE_WDT_DRIFT it still runs every sample, and only skips
+ * the WDT interrupts in between (SKIP_SAMPLES is 0), so those builds replay slower. With -c every
+ * trace is also replayed one WDT interrupt at a time, and the two are compared: the firmware
+ * state at every change of the flags, duty or boost, and the state, I/O registers and lifetime
+ * statistics at the end.
+ *
+ * With -m the lifetime statistics block (USE_LIFETIME_STATS) is written to a file after the
+ * last trace, as SolarStats.c decodes it from a chip: the data space from 0, with the block at
+ * STATS_ADDRESS and zeroes before it. Every trace starts from a power-up.
+ *
+ * With -w the WDT oscillator runs ppm parts per million slow (negative is fast), as it does on a
+ * cold or a hot night, to see what that does to the switch-off times (and what USE_WDT_DRIFT
+ * makes of it).
+ *
+ * With -p a passer-by comes along every so many seconds (USE_MOTION_SENSOR). Any trace on which
+ * the core went to Power-Down with the PWM output halfway a period fails, see SolarHost_FrozenPwm.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <avr/io.h>
+
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarCounter.h"
+#include "SolarHost.h"
+#include "SolarTrace.h"
+
+// Every change of the flags, duty or boost, with the rest of the state at that time:
+typedef struct
+{
+	uint64_t		TimeMs;
+	SolarHostState	State;
+} CheckEvent;
+
+typedef struct
+{
+	CheckEvent		*Events;
+	size_t			Count;
+	size_t			Size;
+	SolarHostState	Last;
+} CheckContext;
+
+typedef struct
+{
+	const SolarTraceHeader	*Header;
+	bool					Summary;
+	bool					Boost;
+	uint8_t					Duty;
+	uint64_t				LitMs;			// Time with the boost enabled
+	uint64_t				LastMs;
+	uint32_t				Nights;			// Times the boost was switched on
+} ReplayContext;
+
+static void PrintClock(const SolarTraceHeader *Header, uint64_t TimeMs)
+{
+	char	Clock[24];
+	time_t	Time = (time_t)(Header->StartTime + (int64_t)(TimeMs / 1000) + Header->UtcOffsetMin * 60);
+	
+	strftime(Clock, sizeof(Clock), "%Y-%m-%d %H:%M:%S", gmtime(&Time));
+	fputs(Clock, stdout);
+}
+
+static void OnSample(void *Context, uint64_t TimeMs, uint8_t Sample)
+{
+	ReplayContext	*Replay = Context;
+	SolarHostState	State;
+	
+	(void)Sample;
+	SolarHost_GetState(&State);
+	
+	if(Replay->Boost)
+		Replay->LitMs += TimeMs - Replay->LastMs;
+	Replay->LastMs = TimeMs;
+	
+	if( (State.Boost == Replay->Boost) && (State.Duty == Replay->Duty) )
+		return;
+	if(State.Boost && !Replay->Boost)
+		Replay->Nights++;
+	Replay->Boost = State.Boost;
+	Replay->Duty = State.Duty;
+	
+	if(!Replay->Summary)
+	{
+		printf("%u,", Replay->Header->SiteId);
+		PrintClock(Replay->Header, TimeMs);
+		printf(",%u,%u,%u\n", State.Boost, State.Duty, State.Ticks);
+	}
+}
+
+static void OnCheckSample(void *Context, uint64_t TimeMs, uint8_t Sample)
+{
+	CheckContext	*Check = Context;
+	SolarHostState	State;
+	
+	(void)Sample;
+	SolarHost_GetState(&State);
+	State.OperationalFlags &= ~FLAG_SET_SLEEP; // Only the main loop clears it, which the host doesn't run
+	if( (Check->Count != 0) && (State.OperationalFlags == Check->Last.OperationalFlags)
+		&& (State.Duty == Check->Last.Duty) && (State.Boost == Check->Last.Boost) )
+		return;
+	
+	if(Check->Count == Check->Size)
+	{
+		Check->Size = (Check->Size != 0) ? Check->Size * 2 : 1024;
+		Check->Events = realloc(Check->Events, Check->Size * sizeof(CheckEvent));
+		if(Check->Events == NULL)
+		{
+			perror("SolarReplay");
+			exit(1);
+		}
+	}
+	Check->Events[Check->Count].TimeMs = TimeMs;
+	Check->Events[Check->Count].State = State;
+	Check->Count++;
+	Check->Last = State;
+}
+
+static bool SameState(const SolarHostState *A, const SolarHostState *B)
+{
+	return (A->Ticks == B->Ticks) && (A->DayStreak == B->DayStreak) && (A->NightStreak == B->NightStreak)
+		&& (A->WDT_CountDown == B->WDT_CountDown) && (A->OperationalFlags == B->OperationalFlags)
+		&& (A->TicksLimitPWM1 == B->TicksLimitPWM1) && (A->TicksLimitPWM2 == B->TicksLimitPWM2)
+		&& (A->Duty == B->Duty) && (A->Boost == B->Boost);
+}
+
+// Replays the trace both ways and compares, prints what differs first:
+static bool CheckReplay(const SolarTrace *Trace, const char *Path)
+{
+	CheckContext			Tick, Event;
+	SolarHostState			TickEnd, EventEnd;
+	uint8_t					TickIO[sizeof(SolarHost_IO)];
+	uint8_t					TickStats[64];
+	const uint8_t			*Stats;
+	size_t					StatsSize;
+	uint16_t				StatsAddress;
+	uint64_t				TickSamples, EventSamples;
+	uint32_t				TickFrozen;
+	SolarHostReplayStats	Count;
+	bool					Same = true;
+	
+	memset(&Tick, 0, sizeof(Tick));
+	memset(&Event, 0, sizeof(Event));
+	
+	TickSamples = SolarHost_Replay(Trace, OnCheckSample, &Tick);
+	SolarHost_GetState(&TickEnd);
+	TickFrozen = SolarHost_FrozenPwm;
+	memcpy(TickIO, SolarHost_IO, sizeof(TickIO));
+	StatsSize = SolarHost_StatsBlock(&Stats, &StatsAddress);
+	if(StatsSize != 0)
+		memcpy(TickStats, Stats, StatsSize);
+	EventSamples = SolarHost_ReplayEvents(Trace, OnCheckSample, &Event, &Count);
+	SolarHost_GetState(&EventEnd);
+	
+	if(TickSamples != EventSamples)
+	{
+		printf("%s: %llu samples stepped, %llu with skipping\n", Path,
+			   (unsigned long long)TickSamples, (unsigned long long)EventSamples);
+		Same = false;
+	}
+	for(size_t Index = 0; Same && (Index < Tick.Count || Index < Event.Count); Index++)
+	{
+		if( (Index >= Tick.Count) || (Index >= Event.Count) || (Tick.Events[Index].TimeMs != Event.Events[Index].TimeMs)
+			|| !SameState(&Tick.Events[Index].State, &Event.Events[Index].State) )
+		{
+			printf("%s: change %zu differs (at %llu ms stepped, %llu ms with skipping)\n", Path, Index,
+				   (unsigned long long)((Index < Tick.Count) ? Tick.Events[Index].TimeMs : 0),
+				   (unsigned long long)((Index < Event.Count) ? Event.Events[Index].TimeMs : 0));
+			Same = false;
+		}
+	}
+	if( Same && (!SameState(&TickEnd, &EventEnd) || (memcmp(TickIO, SolarHost_IO, sizeof(TickIO)) != 0)
+				 || (TickFrozen != SolarHost_FrozenPwm)
+				 || ((StatsSize != 0) && (memcmp(TickStats, Stats, StatsSize) != 0))) )
+	{
+		printf("%s: end state differs\n", Path);
+		Same = false;
+	}
+	
+	if(Same)
+		printf("%s: %zu changes match, %llu interrupts run for %llu samples (%llu applied in one go)\n", Path,
+			   Tick.Count, (unsigned long long)Count.Interrupts, (unsigned long long)EventSamples,
+			   (unsigned long long)Count.SkippedSamples);
+	free(Tick.Events);
+	free(Event.Events);
+	return Same;
+}
+
+int main(int argc, char **argv)
+{
+	bool	Summary = false;
+	bool	Check = false;
+	char	*DumpPath = NULL;
+	int		Option;
+	int		Failed = 0;
+	
+	while( (Option = getopt(argc, argv, "scm:w:p:")) != -1 )
+	{
+		if(Option == 's')
+			Summary = true;
+		else if(Option == 'c')
+			Check = true;
+		else if(Option == 'm')
+			DumpPath = optarg;
+		else if( (Option == 'w') && (labs(strtol(optarg, NULL, 10)) < 500000) )
+			SolarHost_WdtDriftPpm = (int32_t)strtol(optarg, NULL, 10);
+		else if( (Option == 'p') && (strtol(optarg, NULL, 10) > 0) )
+			SolarHost_MotionEveryS = (uint32_t)strtol(optarg, NULL, 10);
+		else
+		{
+			fprintf(stderr, "Usage: SolarReplay [-s] [-c] [-m dump.bin] [-w ppm] [-p seconds] site.sltr [...]\n");
+			return 2;
+		}
+	}
+	
+	for(int Index = optind; Index < argc; Index++)
+	{
+		SolarTrace		Trace;
+		ReplayContext	Replay;
+		uint64_t		Samples;
+		int				Result = SolarTrace_Open(&Trace, argv[Index]);
+		
+		if(Result != SOLAR_TRACE_OK)
+		{
+			fprintf(stderr, "%s: %s\n", argv[Index], SolarTrace_ErrorString(Result));
+			Failed = 1;
+			continue;
+		}
+		
+		memset(&Replay, 0, sizeof(Replay));
+		Replay.Header = Trace.Header;
+		Replay.Summary = Summary;
+		if( Check && !CheckReplay(&Trace, argv[Index]) )
+			Failed = 1;
+		Samples = SolarHost_ReplayEvents(&Trace, OnSample, &Replay, NULL);
+		
+		if(Summary)
+			printf("%s: %llu samples, %u nights lit, %.1f lamp-hours\n", argv[Index],
+				   (unsigned long long)Samples, Replay.Nights, Replay.LitMs / 3600000.0);
+		if(SolarHost_FrozenPwm != 0)
+		{
+			printf("%s: Power-Down stopped the PWM output halfway %u times\n", argv[Index], SolarHost_FrozenPwm);
+			Failed = 1;
+		}
+		SolarTrace_Close(&Trace);
+	}
+	
+	if(DumpPath != NULL)
+	{
+		const uint8_t	*Block;
+		uint16_t		Address;
+		size_t			Size = SolarHost_StatsBlock(&Block, &Address);
+		FILE			*Dump;
+		bool			Written;
+		
+		if(Size == 0)
+		{
+			fprintf(stderr, "The firmware is built without USE_LIFETIME_STATS\n");
+			return 1;
+		}
+		// Data space from 0 to the end of the block, as a dump from the chip would have it:
+		Written = (Dump = fopen(DumpPath, "wb")) != NULL;
+		for(uint16_t Byte = 0; Written && (Byte < Address); Byte++)
+			Written = fputc(0, Dump) != EOF;
+		if( !Written || (fwrite(Block, 1, Size, Dump) != Size) || (fclose(Dump) != 0) )
+		{
+			perror(DumpPath);
+			return 1;
+		}
+	}
+	return Failed;
+}
@@ -0,0 +1,368 @@
+/*
+ * SolarStats.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Decodes the lifetime statistics block (USE_LIFETIME_STATS in SolarConfig.h) from a memory dump:
+ *   gcc -O2 -I. -o SolarStats SolarStats.c
+ *
+ * Usage:
+ *   SolarStats [-t address | -a address | -s [-A]] dump.bin|dump.hex [...]
+ *
+ * The dump is the data space as read over TPI or saved from a simulator, either raw binary or
+ * Intel HEX. A binary dump is addressed from 0, a HEX dump at the addresses in its records, so
+ * both at the data space addresses of the part (the ATtiny10 SRAM is 0x40 to 0x5F). SolarReplay -m
+ * writes the block of the host build that way, as a binary.
+ *
+ * The firmware keeps the block at a fixed place, STATS_ADDRESS: it ends at the top of the SRAM.
+ * It starts with the magic byte 0xA5 and a version byte, which holds the layout: the revision in
+ * the top nibble (1), plus 0x08 for the compact layout (8 bit counters, tick values in units of 4),
+ * plus the number of day lengths. Every layout has its own size, so its own start address: the one
+ * where the magic and a matching version are found is decoded. Nothing is searched for, unless -s
+ * is given.
+ *
+ * Options:
+ *   -t address     Top of the SRAM of the part (default 0x5F, the ATtiny10; 0x9F for the ATtiny13A,
+ *                  0xDF, 0x15F and 0x25F for the ATtiny25/45/85)
+ *   -a address     Decode the block at this address (0x.. for hex)
+ *   -s             Search the whole dump for the magic and version bytes, for dumps of older builds
+ *                  or ones that were not read at the data space addresses
+ *   -A             With -s, decode every match, not just the first
+ *
+ * Counters that show a + have saturated. Day lengths are in day samples, the afterglow in night
+ * samples, converted to hours with the sample times of the build this is compiled against.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <avr/io.h>
+
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarCounter.h"
+
+// Copies of SolarCounter.h, which only defines the version of the build:
+#define		STATS_MAGIC_BYTE		0xA5
+#define		STATS_REVISION_MASK		0xF0
+#define		STATS_REVISION_1		0x10
+#define		STATS_VERSION_COMPACT	0x08
+#define		STATS_VERSION_DAYS		0x07
+
+#define		DUMP_BYTES_MAXIMUM		0x10000
+
+#define		DAY_SAMPLE_HOURS		(TICKS_BEFORE_SAMPLE_DAY * WDT_DAY_PERIOD_MS / 3600000.0)
+#define		NIGHT_SAMPLE_HOURS		(TICKS_BEFORE_SAMPLE_NIGHT * WDT_NIGHT_PERIOD_MS / 3600000.0)
+
+typedef struct
+{
+	uint8_t		*Bytes;
+	bool		*Valid;			// Addresses a HEX dump has data for
+	uint32_t	Size;
+} MemoryDump;
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: SolarStats [-t address | -a address | -s [-A]] dump.bin|dump.hex [...]\n");
+	exit(2);
+}
+
+static int HexByte(const char *Text)
+{
+	unsigned int	Value;
+	
+	if( (sscanf(Text, "%2x", &Value) != 1) || (Text[0] == '\0') || (Text[1] == '\0') )
+		return -1;
+	return (int)Value;
+}
+
+// Intel HEX, data records (00) with extended segment (02) and linear (04) addresses, up to 64kB:
+static bool ReadHex(FILE *File, MemoryDump *Dump)
+{
+	char		Line[600];
+	uint32_t	Base = 0;
+	
+	while(fgets(Line, sizeof(Line), File) != NULL)
+	{
+		int			Count, Type, Byte;
+		uint32_t	Address;
+		uint8_t		Check;
+		
+		if(Line[0] != ':')
+			continue;
+		Count = HexByte(Line + 1);
+		if( (Count < 0) || (strlen(Line) < 11 + 2 * (size_t)Count) )
+			return false;
+		Address = (HexByte(Line + 3) << 8) | HexByte(Line + 5);
+		Type = HexByte(Line + 7);
+		Check = Count + (Address >> 8) + Address + Type;
+		for(int Index = 0; Index <= Count; Index++)
+		{
+			if( (Byte = HexByte(Line + 9 + 2 * Index)) < 0 )
+				return false;
+			Check += Byte;
+		}
+		if(Check != 0)
+			return false;
+		
+		if(Type == 0x00)
+		{
+			for(int Index = 0; Index < Count; Index++)
+			{
+				uint32_t	At = Base + Address + Index;
+				
+				if(At >= DUMP_BYTES_MAXIMUM)
+					return false;
+				Dump->Bytes[At] = HexByte(Line + 9 + 2 * Index);
+				Dump->Valid[At] = true;
+				if(At >= Dump->Size)
+					Dump->Size = At + 1;
+			}
+		}
+		else if(Type == 0x01)
+			break;
+		else if( (Type == 0x02) && (Count == 2) )
+			Base = ((HexByte(Line + 9) << 8) | HexByte(Line + 11)) << 4;
+		else if( (Type == 0x04) && (Count == 2) )
+			Base = ((HexByte(Line + 9) << 8) | HexByte(Line + 11)) << 16;
+	}
+	return true;
+}
+
+static bool ReadDump(const char *Path, MemoryDump *Dump)
+{
+	FILE	*File = fopen(Path, "rb");
+	int		First;
+	bool	Good = true;
+	
+	if(File == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", Path, strerror(errno));
+		return false;
+	}
+	memset(Dump->Valid, 0, DUMP_BYTES_MAXIMUM * sizeof(bool));
+	Dump->Size = 0;
+	
+	First = fgetc(File);
+	ungetc(First, File);
+	if(First == ':')
+		Good = ReadHex(File, Dump);
+	else
+	{
+		Dump->Size = fread(Dump->Bytes, 1, DUMP_BYTES_MAXIMUM, File);
+		memset(Dump->Valid, 1, Dump->Size * sizeof(bool));
+	}
+	fclose(File);
+	
+	if(!Good)
+		fprintf(stderr, "%s: not a valid Intel HEX file\n", Path);
+	return Good;
+}
+
+// Bytes in the block that goes with Version, 0 if it isn't one:
+static uint32_t BlockBytes(uint8_t Version)
+{
+	uint32_t	Days = Version & STATS_VERSION_DAYS;
+	
+	if( ((Version & STATS_REVISION_MASK) != STATS_REVISION_1) || (Days == 0) )
+		return 0;
+	return 5 + (3 + Days) * (((Version & STATS_VERSION_COMPACT) != 0) ? 1 : 2);
+}
+
+static bool BlockFits(const MemoryDump *Dump, uint32_t Address)
+{
+	uint32_t	Bytes;
+	
+	if( (Address + 2 > Dump->Size) || !Dump->Valid[Address] || !Dump->Valid[Address + 1]
+		|| (Dump->Bytes[Address] != STATS_MAGIC_BYTE) )
+		return false;
+	Bytes = BlockBytes(Dump->Bytes[Address + 1]);
+	if( (Bytes == 0) || (Address + Bytes > Dump->Size) )
+		return false;
+	for(uint32_t Index = 0; Index < Bytes; Index++)
+	{
+		if(!Dump->Valid[Address + Index])
+			return false;
+	}
+	return true;
+}
+
+// The block at its fixed place below Top, for whichever layout is found there. Returns its address, or -1:
+static long FixedBlock(const MemoryDump *Dump, uint32_t Top)
+{
+	for(uint8_t Layout = 0; Layout < 2 * STATS_VERSION_DAYS; Layout++)
+	{
+		uint8_t		Version = STATS_REVISION_1 | ((Layout & 1) ? STATS_VERSION_COMPACT : 0) | (Layout / 2 + 1);
+		uint32_t	Bytes = BlockBytes(Version);
+		
+		if( (Bytes <= Top + 1) && BlockFits(Dump, Top + 1 - Bytes) && (Dump->Bytes[Top + 2 - Bytes] == Version) )
+			return (long)(Top + 1 - Bytes);
+	}
+	return -1;
+}
+
+static void PrintCounter(const char *Name, uint32_t Value, uint32_t Maximum)
+{
+	printf("  %-16s%u%s\n", Name, Value, (Value == Maximum) ? "+" : "");
+}
+
+static void PrintTicks(const char *Name, uint32_t Value, uint32_t Maximum, uint32_t Shift, double Hours)
+{
+	printf("  %-16s%u%s ticks, %.1f h\n", Name, Value << Shift, (Value == Maximum) ? "+" : "",
+		   (Value << Shift) * Hours);
+}
+
+static void Decode(const MemoryDump *Dump, uint32_t Address)
+{
+	const uint8_t	*Block = Dump->Bytes + Address;
+	uint8_t			Version = Block[1];
+	bool			Compact = (Version & STATS_VERSION_COMPACT) != 0;
+	uint32_t		Days = Version & STATS_VERSION_DAYS;
+	uint32_t		Width = Compact ? 1 : 2;
+	uint32_t		Maximum = Compact ? 0xFF : 0xFFFF;
+	uint32_t		Shift = Compact ? 2 : 0;
+	uint32_t		Field[3 + STATS_VERSION_DAYS];
+	
+	// Magic, version, nights lit (16 bit), the counters: day resets, aborted dusks, afterglow, days, then warm resets
+	for(uint32_t Index = 0; Index < 3 + Days; Index++)
+	{
+		const uint8_t	*Value = Block + 4 + Index * Width;
+		
+		Field[Index] = Compact ? Value[0] : (Value[0] | (Value[1] << 8));
+	}
+	
+	printf("Block at 0x%04X: version 0x%02X, %s, %u day length%s\n", Address, Version,
+		   Compact ? "compact" : "full", Days, (Days == 1) ? "" : "s");
+	PrintCounter("warm resets", Block[4 + (3 + Days) * Width], 0xFF);
+	PrintCounter("nights lit", Block[2] | (Block[3] << 8), 0xFFFF);
+	PrintCounter("day resets", Field[0], Maximum);
+	PrintCounter("aborted dusks", Field[1], Maximum);
+	PrintTicks("afterglow", Field[2], Maximum, Shift, NIGHT_SAMPLE_HOURS);
+	for(uint32_t Day = 0; Day < Days; Day++)
+	{
+		char	Name[24];
+		
+		snprintf(Name, sizeof(Name), "day %u", Day + 1);
+		PrintTicks(Name, Field[3 + Day], Maximum, Shift, DAY_SAMPLE_HOURS);
+	}
+}
+
+// An address option, 0.. or 0x.. within the dump range:
+static long AddressOption(const char *Text)
+{
+	char	*End;
+	long	Value = strtol(Text, &End, 0);
+	
+	if( (*End != '\0') || (Value < 0) || (Value >= DUMP_BYTES_MAXIMUM) )
+		Usage();
+	return Value;
+}
+
+int main(int argc, char **argv)
+{
+	MemoryDump	Dump;
+	long		Address = -1;
+	long		Top = RAMEND;
+	bool		Search = false;
+	bool		All = false;
+	int			Option;
+	int			Failed = 0;
+	
+	while( (Option = getopt(argc, argv, "t:a:sA")) != -1 )
+	{
+		switch(Option)
+		{
+			case 't':	Top = AddressOption(optarg);		break;
+			case 'a':	Address = AddressOption(optarg);	break;
+			case 's':	Search = true;						break;
+			case 'A':	All = true;							break;
+			default:
+				Usage();
+		}
+	}
+	if( (optind == argc) || (All && !Search) || (Search && (Address >= 0)) )
+		Usage();
+	
+	Dump.Bytes = malloc(DUMP_BYTES_MAXIMUM);
+	Dump.Valid = malloc(DUMP_BYTES_MAXIMUM * sizeof(bool));
+	if( (Dump.Bytes == NULL) || (Dump.Valid == NULL) )
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	
+	for(int Index = optind; Index < argc; Index++)
+	{
+		uint32_t	Found = 0;
+		long		At = Address;
+		
+		if(!ReadDump(argv[Index], &Dump))
+		{
+			Failed = 1;
+			continue;
+		}
+		if(argc - optind > 1)
+			printf("%s:\n", argv[Index]);
+		
+		if(Search)
+		{
+			for(uint32_t Try = 0; (Try < Dump.Size) && (All || (Found == 0)); Try++)
+			{
+				if(BlockFits(&Dump, Try))
+				{
+					Decode(&Dump, Try);
+					Found++;
+				}
+			}
+		}
+		else
+		{
+			if(At < 0)
+				At = FixedBlock(&Dump, (uint32_t)Top);
+			if( (At >= 0) && BlockFits(&Dump, (uint32_t)At) )
+			{
+				Decode(&Dump, (uint32_t)At);
+				Found++;
+			}
+		}
+		
+		if(Found == 0)
+		{
+			if(Search)
+				fprintf(stderr, "%s: no statistics block\n", argv[Index]);
+			else if(Address >= 0)
+				fprintf(stderr, "%s: no statistics block at 0x%04lX\n", argv[Index], Address);
+			else
+				fprintf(stderr, "%s: no statistics block below 0x%04lX (-t for another part, -s to search)\n",
+						argv[Index], Top);
+			Failed = 1;
+		}
+	}
+	return Failed;
+}
@@ -0,0 +1,260 @@
+/*
+ * SolarTelemetry.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Decodes the telemetry of a testing build (USE_TELEMETRY in SolarConfig.h) into a trace file,
+ * and optionally lists every record:
+ *   gcc -O2 -I. -o SolarTelemetry SolarTelemetry.c SolarTrace.c
+ *
+ * Usage:
+ *   stty -F /dev/ttyUSB0 raw 9600 && cat /dev/ttyUSB0 > bench.bin
+ *   SolarTelemetry [options] bench.bin bench.sltr
+ *
+ * The capture is the raw byte stream ("-" for stdin). Records are found by their sync byte and
+ * checked with their checksum, anything that doesn't check out is skipped and counted.
+ *
+ * A testing build samples on the testing WDT settings, seconds instead of minutes. The trace is
+ * written in production time instead: every record taken after a night interval is one sample of
+ * the trace interval (one production night interval, 60 seconds), every record taken after a day
+ * interval is as many samples as a day interval is longer (two, as committed). That way a bench
+ * session replays on a production build with the same number of samples in every streak. (The
+ * WDT periods are not whole seconds, so over long sessions a replay drops a sample now and then.)
+ *
+ * Options:
+ *   -c             Also list the records, as CSV on stdout
+ *   -i seconds     Trace sample interval (default: one production night interval)
+ *   -t time        Unix time (UTC) of the first record (default: now)
+ *   -e encoding    raw, delta, rle or delta-rle (default: rle)
+ *   -s id          Site number
+ *   -n name        Site name (up to 31 characters)
+ *   -z minutes     Site clock time minus UTC (default: 60, CET)
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <avr/io.h>
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "SolarTrace.h"
+
+#define		TELEMETRY_SYNC				0xA5	// Copy of SolarCounter.h, which only defines it in DEBUG builds
+#define		TELEMETRY_RECORD_SIZE		9
+#define		FLAG_RUNNING_DAY			0x10
+
+#define		WDT_PERIOD_MS(Prescaler)	(16u << ((((Prescaler) >> 2) & 0x08) | ((Prescaler) & 0x07)))
+
+typedef struct
+{
+	uint8_t		Sample;
+	uint16_t	Ticks;
+	uint8_t		DayStreak;
+	uint8_t		NightStreak;
+	uint8_t		Flags;
+	uint8_t		Duty;
+} TelemetryRecord;
+
+typedef struct
+{
+	uint8_t		*Samples;
+	uint64_t	Count;
+	uint64_t	Allocated;
+} TelemetryBuffer;
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: SolarTelemetry [-c] [-i seconds] [-t time] [-e encoding] [-s id] [-n name] [-z minutes] capture.bin site.sltr\n");
+	exit(2);
+}
+
+static void Append(TelemetryBuffer *Buffer, uint8_t Sample, uint32_t Repeat)
+{
+	while(Repeat-- != 0)
+	{
+		if(Buffer->Count == Buffer->Allocated)
+		{
+			Buffer->Allocated = (Buffer->Allocated == 0) ? 65536 : Buffer->Allocated * 2;
+			Buffer->Samples = realloc(Buffer->Samples, Buffer->Allocated);
+			if(Buffer->Samples == NULL)
+			{
+				fprintf(stderr, "Out of memory\n");
+				exit(1);
+			}
+		}
+		Buffer->Samples[Buffer->Count++] = Sample;
+	}
+}
+
+// Checks a record starting at its sync byte, fills in Record if it is good:
+static bool ParseRecord(const uint8_t *Bytes, TelemetryRecord *Record)
+{
+	uint8_t	Check = 0;
+	
+	if(Bytes[0] != TELEMETRY_SYNC)
+		return false;
+	for(uint32_t Index = 1; Index < TELEMETRY_RECORD_SIZE - 1; Index++)
+		Check ^= Bytes[Index];
+	if(Check != Bytes[TELEMETRY_RECORD_SIZE - 1])
+		return false;
+	
+	Record->Sample = Bytes[1];
+	Record->Ticks = Bytes[2] | (Bytes[3] << 8);
+	Record->DayStreak = Bytes[4];
+	Record->NightStreak = Bytes[5];
+	Record->Flags = Bytes[6];
+	Record->Duty = Bytes[7];
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	SolarTraceHeader	Header;
+	TelemetryBuffer		Buffer;
+	uint32_t			Encoding = SOLAR_TRACE_ENC_RLE;
+	uint32_t			DayMs = WDT_PERIOD_MS(WDT_PRESC_DAY_TESTING) * TICKS_BEFORE_SAMPLE_DAY_TESTING;
+	uint32_t			NightMs = WDT_PERIOD_MS(WDT_PRESC_NIGHT_TESTING) * TICKS_BEFORE_SAMPLE_NIGHT_TESTING;
+	uint32_t			DayRepeat = (DayMs + NightMs / 2) / NightMs;
+	uint32_t			Interval = (WDT_PERIOD_MS(WDT_PRESC_NIGHT_PRODUCTION) * TICKS_BEFORE_SAMPLE_NIGHT_PRODUCTION) / 1000;
+	int64_t				StartTime = (int64_t)time(NULL);
+	bool				List = false;
+	uint8_t				Window[TELEMETRY_RECORD_SIZE];
+	uint32_t			Filled = 0;
+	uint64_t			Records = 0;
+	uint64_t			Skipped = 0;
+	bool				WasDay = false;
+	FILE				*Input;
+	int					Byte;
+	int					Option;
+	int					Result;
+	
+	memset(&Header, 0, sizeof(Header));
+	memset(&Buffer, 0, sizeof(Buffer));
+	Header.UtcOffsetMin = 60;
+	
+	while( (Option = getopt(argc, argv, "ci:t:e:s:n:z:")) != -1 )
+	{
+		switch(Option)
+		{
+			case 'c':	List = true; break;
+			case 'i':	Interval = (uint32_t)strtoul(optarg, NULL, 10); break;
+			case 't':	StartTime = strtoll(optarg, NULL, 10); break;
+			case 's':	Header.SiteId = (uint16_t)strtoul(optarg, NULL, 10); break;
+			case 'n':	strncpy(Header.SiteName, optarg, sizeof(Header.SiteName) - 1); break;
+			case 'z':	Header.UtcOffsetMin = (int16_t)strtol(optarg, NULL, 10); break;
+			case 'e':
+				if(strcmp(optarg, "raw") == 0)				Encoding = SOLAR_TRACE_ENC_RAW;
+				else if(strcmp(optarg, "delta") == 0)		Encoding = SOLAR_TRACE_ENC_DELTA;
+				else if(strcmp(optarg, "rle") == 0)			Encoding = SOLAR_TRACE_ENC_RLE;
+				else if(strcmp(optarg, "delta-rle") == 0)	Encoding = SOLAR_TRACE_ENC_DELTA | SOLAR_TRACE_ENC_RLE;
+				else Usage();
+				break;
+			default:
+				Usage();
+		}
+	}
+	if( (optind != argc - 2) || (Interval == 0) )
+		Usage();
+	
+	Input = (strcmp(argv[optind], "-") == 0) ? stdin : fopen(argv[optind], "rb");
+	if(Input == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+		return 1;
+	}
+	
+	if(List)
+		printf("record,trace sample,adc,ticks,day streak,night streak,flags,duty\n");
+	
+	while( (Byte = fgetc(Input)) != EOF )
+	{
+		TelemetryRecord	Record;
+		
+		Window[Filled++] = (uint8_t)Byte;
+		if( (Window[0] != TELEMETRY_SYNC) || (Filled < TELEMETRY_RECORD_SIZE) )
+		{
+			if(Window[0] != TELEMETRY_SYNC)
+			{
+				Filled = 0;
+				Skipped++;
+			}
+			continue;
+		}
+		
+		if(!ParseRecord(Window, &Record))
+		{ // Not a record after all, look for the next sync from the byte after this one:
+			uint32_t	Next = 1;
+			
+			while( (Next < TELEMETRY_RECORD_SIZE) && (Window[Next] != TELEMETRY_SYNC) )
+				Next++;
+			memmove(Window, Window + Next, TELEMETRY_RECORD_SIZE - Next);
+			Filled = TELEMETRY_RECORD_SIZE - Next;
+			Skipped += Next;
+			continue;
+		}
+		Filled = 0;
+		
+		// The interval before this sample was set by the previous one:
+		Append(&Buffer, Record.Sample, (Records != 0) && WasDay ? DayRepeat : 1);
+		WasDay = (Record.Flags & FLAG_RUNNING_DAY) != 0;
+		
+		if(List)
+			printf("%llu,%llu,%u,%u,%u,%u,0x%02X,%u\n", (unsigned long long)Records, (unsigned long long)(Buffer.Count - 1),
+				   Record.Sample, Record.Ticks, Record.DayStreak, Record.NightStreak, Record.Flags, Record.Duty);
+		Records++;
+	}
+	if(Input != stdin)
+		fclose(Input);
+	Skipped += Filled;
+	
+	if(Buffer.Count == 0)
+	{
+		fprintf(stderr, "%s: no records found\n", argv[optind]);
+		return 1;
+	}
+	
+	Header.SampleIntervalS = Interval;
+	Header.SupplyVoltageMv = (uint32_t)SUPPLY_VOLTAGE_MV;
+	Header.StartTime = StartTime;
+	
+	Result = SolarTrace_Write(argv[optind + 1], &Header, Encoding, Buffer.Samples, Buffer.Count);
+	if(Result != SOLAR_TRACE_OK)
+	{
+		fprintf(stderr, "%s: %s\n", argv[optind + 1], SolarTrace_ErrorString(Result));
+		return 1;
+	}
+	
+	fprintf(stderr, "%llu records, %llu samples every %u s (%llu bytes skipped)\n", (unsigned long long)Records,
+			(unsigned long long)Buffer.Count, Interval, (unsigned long long)Skipped);
+	free(Buffer.Samples);
+	return 0;
+}
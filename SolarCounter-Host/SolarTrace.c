@@ -0,0 +1,416 @@
+/*
+ * SolarTrace.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Reading, writing and (de)compressing trace files. See SolarTrace.h for the format.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SolarTrace.h"
+
+_Static_assert(sizeof(SolarTraceHeader) == 96, "Trace header layout changed, bump SOLAR_TRACE_VERSION");
+
+#define		HEADER_CRC_LENGTH		offsetof(SolarTraceHeader, HeaderCrc)
+
+#define		RLE_MAXIMUM_LITERAL		128
+#define		RLE_MINIMUM_REPEAT		3	// Shorter runs are cheaper to keep inside a literal block
+#define		RLE_MAXIMUM_REPEAT		129
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Checksum
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Plain CRC-32 (IEEE 802.3, reflected), so files can be checked with any zip-ish tool as well:
+uint32_t SolarTrace_Crc32(uint32_t Crc, const void *Data, size_t Length)
+{
+	static uint32_t	Table[256];
+	const uint8_t	*Byte = Data;
+	
+	if(Table[1] == 0)
+	{
+		for(uint32_t Index = 0; Index < 256; Index++)
+		{
+			uint32_t Value = Index;
+			for(uint8_t Bit = 0; Bit < 8; Bit++)
+				Value = (Value & 1) ? (Value >> 1) ^ 0xEDB88320u : (Value >> 1);
+			Table[Index] = Value;
+		}
+	}
+	
+	Crc = ~Crc;
+	while(Length--)
+		Crc = Table[(Crc ^ *Byte++) & 0xFF] ^ (Crc >> 8);
+	return ~Crc;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Opening and closing
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int SolarTrace_Open(SolarTrace *Trace, const char *Path)
+{
+	struct stat		Info;
+	int				File;
+	void			*Map;
+	const SolarTraceHeader	*Header;
+	
+	memset(Trace, 0, sizeof(*Trace));
+	
+	File = open(Path, O_RDONLY);
+	if(File < 0)
+		return SOLAR_TRACE_E_IO;
+	if(fstat(File, &Info) != 0)
+	{
+		close(File);
+		return SOLAR_TRACE_E_IO;
+	}
+	if((size_t)Info.st_size < sizeof(SolarTraceHeader))
+	{
+		close(File);
+		return SOLAR_TRACE_E_FORMAT;
+	}
+	
+	Map = mmap(NULL, (size_t)Info.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close(File); // The mapping keeps its own reference
+	if(Map == MAP_FAILED)
+		return SOLAR_TRACE_E_IO;
+	
+	Trace->Map = Map;
+	Trace->MapSize = (size_t)Info.st_size;
+	Header = Map;
+	
+	if( (memcmp(Header->Magic, SOLAR_TRACE_MAGIC, 4) != 0) || (Header->Version != SOLAR_TRACE_VERSION)
+		|| (Header->HeaderSize < sizeof(SolarTraceHeader)) || (Header->HeaderSize > Trace->MapSize) )
+	{
+		SolarTrace_Close(Trace);
+		return SOLAR_TRACE_E_FORMAT;
+	}
+	if(SolarTrace_Crc32(0, Header, HEADER_CRC_LENGTH) != Header->HeaderCrc)
+	{
+		SolarTrace_Close(Trace);
+		return SOLAR_TRACE_E_CRC;
+	}
+	if(Header->PayloadSize > Trace->MapSize - Header->HeaderSize)
+	{
+		SolarTrace_Close(Trace);
+		return SOLAR_TRACE_E_TRUNCATED;
+	}
+	
+	Trace->Header = Header;
+	Trace->Payload = (const uint8_t *)Map + Header->HeaderSize;
+	
+	// Replays read front to back, tell the kernel so it can read ahead:
+	madvise(Map, Trace->MapSize, MADV_SEQUENTIAL);
+	return SOLAR_TRACE_OK;
+}
+
+void SolarTrace_Close(SolarTrace *Trace)
+{
+	if(Trace->Map != NULL)
+		munmap(Trace->Map, Trace->MapSize);
+	memset(Trace, 0, sizeof(*Trace));
+}
+
+int SolarTrace_Verify(const SolarTrace *Trace)
+{
+	if(SolarTrace_Crc32(0, Trace->Payload, Trace->Header->PayloadSize) != Trace->Header->PayloadCrc)
+		return SOLAR_TRACE_E_CRC;
+	return SOLAR_TRACE_OK;
+}
+
+const char *SolarTrace_ErrorString(int Error)
+{
+	switch(Error)
+	{
+		case SOLAR_TRACE_OK:			return "no error";
+		case SOLAR_TRACE_E_IO:			return strerror(errno);
+		case SOLAR_TRACE_E_FORMAT:		return "not a trace file, or an unsupported version";
+		case SOLAR_TRACE_E_CRC:			return "checksum mismatch";
+		case SOLAR_TRACE_E_TRUNCATED:	return "file is shorter than its header says";
+		default:						return "unknown error";
+	}
+}
+
+const uint8_t *SolarTrace_RawSamples(const SolarTrace *Trace)
+{
+	if(Trace->Header->Encoding != SOLAR_TRACE_ENC_RAW)
+		return NULL;
+	return Trace->Payload;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Decoding
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void SolarTrace_Begin(const SolarTrace *Trace, SolarTraceCursor *Cursor)
+{
+	memset(Cursor, 0, sizeof(*Cursor));
+	Cursor->Pos = Trace->Payload;
+	Cursor->End = Trace->Payload + Trace->Header->PayloadSize;
+	Cursor->Encoding = Trace->Header->Encoding;
+	Cursor->Count = Trace->Header->SampleCount;
+}
+
+// Next byte as stored before delta decoding. A damaged payload reads as zeroes instead of running off the map.
+static inline uint8_t NextCoded(SolarTraceCursor *Cursor)
+{
+	if( (Cursor->Encoding & SOLAR_TRACE_ENC_RLE) == 0 )
+		return (Cursor->Pos < Cursor->End) ? *Cursor->Pos++ : 0;
+	
+	if(Cursor->RunLeft == 0)
+	{
+		uint8_t	Control;
+		
+		if(Cursor->Pos >= Cursor->End)
+			return 0;
+		Control = *Cursor->Pos++;
+		if(Control < 128)
+		{
+			Cursor->RunRepeats = false;
+			Cursor->RunLeft = Control + 1;
+		}
+		else
+		{
+			Cursor->RunRepeats = true;
+			Cursor->RunLeft = Control - 126;
+			Cursor->RunByte = (Cursor->Pos < Cursor->End) ? *Cursor->Pos++ : 0;
+		}
+	}
+	
+	Cursor->RunLeft--;
+	if(Cursor->RunRepeats)
+		return Cursor->RunByte;
+	return (Cursor->Pos < Cursor->End) ? *Cursor->Pos++ : 0;
+}
+
+// Decode Count samples without storing them; whole repeat blocks are skipped in one go.
+static void Skip(SolarTraceCursor *Cursor, uint64_t Count)
+{
+	if(Cursor->Encoding == SOLAR_TRACE_ENC_RAW)
+	{
+		Cursor->Pos += Count - 1;
+		Cursor->Value = NextCoded(Cursor);
+		Cursor->Consumed += Count;
+		return;
+	}
+	
+	while(Count != 0)
+	{
+		if(Cursor->RunRepeats && (Cursor->RunLeft != 0))
+		{
+			uint8_t	Step = (Count < Cursor->RunLeft) ? (uint8_t)Count : Cursor->RunLeft;
+			
+			if(Cursor->Encoding & SOLAR_TRACE_ENC_DELTA)
+				Cursor->Value += (uint8_t)(Step * Cursor->RunByte);
+			else
+				Cursor->Value = Cursor->RunByte;
+			Cursor->RunLeft -= Step;
+			Cursor->Consumed += Step;
+			Count -= Step;
+			continue;
+		}
+		
+		if(Cursor->Encoding & SOLAR_TRACE_ENC_DELTA)
+			Cursor->Value += NextCoded(Cursor);
+		else
+			Cursor->Value = NextCoded(Cursor);
+		Cursor->Consumed++;
+		Count--;
+	}
+}
+
+size_t SolarTrace_Read(SolarTraceCursor *Cursor, uint8_t *Out, size_t Count)
+{
+	size_t	Done;
+	
+	if(Count > Cursor->Count - Cursor->Consumed)
+		Count = (size_t)(Cursor->Count - Cursor->Consumed);
+	
+	if(Cursor->Encoding == SOLAR_TRACE_ENC_RAW)
+	{
+		memcpy(Out, Cursor->Pos, Count);
+		Cursor->Pos += Count;
+		Cursor->Consumed += Count;
+		if(Count != 0)
+			Cursor->Value = Out[Count - 1];
+		return Count;
+	}
+	
+	for(Done = 0; Done < Count; Done++)
+	{
+		Skip(Cursor, 1);
+		Out[Done] = Cursor->Value;
+	}
+	return Count;
+}
+
+/*
+  Sample at an absolute index. Asking for an index before the current one returns the current
+  sample (the cursor only goes forward), asking past the end returns the last sample.
+*/
+uint8_t SolarTrace_SampleAt(SolarTraceCursor *Cursor, uint64_t Index)
+{
+	if(Cursor->Count == 0)
+		return 0;
+	if(Index >= Cursor->Count)
+		Index = Cursor->Count - 1;
+	if(Index + 1 > Cursor->Consumed)
+		Skip(Cursor, Index + 1 - Cursor->Consumed);
+	return Cursor->Value;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Encoding and writing
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+size_t SolarTrace_EncodeBound(uint64_t Count)
+{
+	// Worst case is all literals: one control byte for every 128 samples.
+	return (size_t)(Count + (Count + RLE_MAXIMUM_LITERAL - 1) / RLE_MAXIMUM_LITERAL);
+}
+
+size_t SolarTrace_Encode(uint32_t Encoding, const uint8_t *Samples, uint64_t Count, uint8_t *Out)
+{
+	uint8_t		*Coded = Out;
+	uint8_t		Previous = 0;
+	uint64_t	Index;
+	
+	// Delta pass first (into the output buffer, which is always big enough), RLE then works in place:
+	for(Index = 0; Index < Count; Index++)
+	{
+		Coded[Index] = (Encoding & SOLAR_TRACE_ENC_DELTA) ? (uint8_t)(Samples[Index] - Previous) : Samples[Index];
+		Previous = Samples[Index];
+	}
+	if( (Encoding & SOLAR_TRACE_ENC_RLE) == 0 )
+		return (size_t)Count;
+	
+	/*
+	  The RLE output can run ahead of its input by one control byte per literal block, so it
+	  can't be done in place from the front. Move the deltas to the back of the buffer first.
+	*/
+	{
+		size_t		Bound = SolarTrace_EncodeBound(Count);
+		uint8_t		*Source = Out + (Bound - Count);
+		uint8_t		*Write = Out;
+		uint64_t	Literal = 0; // Start index of the pending literal block
+		
+		memmove(Source, Out, (size_t)Count);
+		
+		Index = 0;
+		while(Index < Count)
+		{
+			uint64_t	Run = 1;
+			
+			while( (Index + Run < Count) && (Source[Index + Run] == Source[Index]) && (Run < RLE_MAXIMUM_REPEAT) )
+				Run++;
+			
+			if( (Run >= RLE_MINIMUM_REPEAT) || (Index + Run == Count) )
+			{
+				// Flush the pending literals before the run (or before the end):
+				uint64_t	LiteralEnd = (Run >= RLE_MINIMUM_REPEAT) ? Index : Count;
+				
+				while(Literal < LiteralEnd)
+				{
+					uint64_t Length = LiteralEnd - Literal;
+					if(Length > RLE_MAXIMUM_LITERAL)
+						Length = RLE_MAXIMUM_LITERAL;
+					*Write++ = (uint8_t)(Length - 1);
+					memmove(Write, Source + Literal, (size_t)Length);
+					Write += Length;
+					Literal += Length;
+				}
+				if(Run >= RLE_MINIMUM_REPEAT)
+				{
+					// Write can be at Source + Index here (leading run, or right after a literal block):
+					uint8_t	Repeated = Source[Index];
+					
+					*Write++ = (uint8_t)(Run + 126);
+					*Write++ = Repeated;
+					Literal = Index + Run;
+				}
+			}
+			Index += Run;
+		}
+		return (size_t)(Write - Out);
+	}
+}
+
+int SolarTrace_Write(const char *Path, SolarTraceHeader *Header, uint32_t Encoding,
+					 const uint8_t *Samples, uint64_t Count)
+{
+	uint8_t		*Payload;
+	size_t		PayloadSize;
+	FILE		*File;
+	int			Result = SOLAR_TRACE_OK;
+	
+	Payload = malloc(SolarTrace_EncodeBound(Count) + 1);
+	if(Payload == NULL)
+		return SOLAR_TRACE_E_IO;
+	PayloadSize = SolarTrace_Encode(Encoding, Samples, Count, Payload);
+	
+	memcpy(Header->Magic, SOLAR_TRACE_MAGIC, 4);
+	Header->Version = SOLAR_TRACE_VERSION;
+	Header->HeaderSize = sizeof(SolarTraceHeader);
+	Header->Encoding = Encoding;
+	Header->SampleCount = Count;
+	Header->PayloadSize = PayloadSize;
+	Header->PayloadCrc = SolarTrace_Crc32(0, Payload, PayloadSize);
+	Header->HeaderCrc = SolarTrace_Crc32(0, Header, HEADER_CRC_LENGTH);
+	
+	File = fopen(Path, "wb");
+	if(File == NULL)
+	{
+		free(Payload);
+		return SOLAR_TRACE_E_IO;
+	}
+	if( (fwrite(Header, sizeof(*Header), 1, File) != 1)
+		|| ((PayloadSize != 0) && (fwrite(Payload, PayloadSize, 1, File) != 1)) )
+		Result = SOLAR_TRACE_E_IO;
+	if(fclose(File) != 0)
+		Result = SOLAR_TRACE_E_IO;
+	
+	free(Payload);
+	return Result;
+}
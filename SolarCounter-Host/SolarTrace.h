@@ -0,0 +1,137 @@
+/*
+ * SolarTrace.h
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Binary trace format for recorded (or generated) sensor logs, used by all host tools.
+ *
+ * A trace file is one site: a fixed 96 byte header followed by the payload. The payload holds
+ * one byte per sample, being exactly what the firmware reads from ADCL at that moment (so 8 bit,
+ * scaled against SupplyVoltageMv like DARK_THRESHOLD and LIGHT_THRESHOLD are in SolarCounter.h).
+ * Samples are taken every SampleIntervalS seconds, starting at StartTime.
+ *
+ * The payload can optionally be compressed, see the SOLAR_TRACE_ENC_ flags:
+ *   DELTA  -- every byte is the difference with the previous sample (modulo 256, starting from 0)
+ *   RLE    -- PackBits style runs: a control byte n of 0..127 is followed by n+1 literal bytes, a
+ *             control byte n of 128..255 is followed by one byte that repeats n-126 times (2..129).
+ * With both flags set, the deltas are run-length encoded. Day-time saturation and night-time
+ * zero readings make up the bulk of any log, so RLE typically brings a year of one-minute samples
+ * from 526kB down to a few tens of kB.
+ *
+ * All multi-byte values are little endian, which means the header can be used in place on any
+ * PC this is likely to run on. The file is mapped with mmap(), nothing is read or copied on
+ * opening; the payload CRC is only checked when SolarTrace_Verify() is called.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#ifndef __SOLAR_TRACE_H__
+#define __SOLAR_TRACE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define		SOLAR_TRACE_MAGIC			"SLTR"
+#define		SOLAR_TRACE_VERSION			1
+
+#define		SOLAR_TRACE_ENC_RAW			0x00
+#define		SOLAR_TRACE_ENC_DELTA		0x01
+#define		SOLAR_TRACE_ENC_RLE			0x02
+
+#define		SOLAR_TRACE_OK				0
+#define		SOLAR_TRACE_E_IO			-1	// open/stat/mmap/write failed, see errno
+#define		SOLAR_TRACE_E_FORMAT		-2	// not a trace file, or a version we don't know
+#define		SOLAR_TRACE_E_CRC			-3	// header or payload checksum mismatch
+#define		SOLAR_TRACE_E_TRUNCATED		-4	// payload shorter than the header promises
+
+typedef struct
+{
+	char		Magic[4];			// SOLAR_TRACE_MAGIC, not terminated
+	uint16_t	Version;			// SOLAR_TRACE_VERSION
+	uint16_t	HeaderSize;			// sizeof(SolarTraceHeader), the payload starts here
+	uint32_t	Encoding;			// SOLAR_TRACE_ENC_ flags
+	uint32_t	SampleIntervalS;	// Seconds between two samples
+	uint32_t	SupplyVoltageMv;	// SUPPLY_VOLTAGE_MV the samples are scaled against
+	int32_t		LatitudeE6;			// Site latitude in millionths of a degree, north positive
+	int32_t		LongitudeE6;		// Site longitude in millionths of a degree, east positive
+	int16_t		UtcOffsetMin;		// Local clock time minus UTC, in minutes
+	uint16_t	SiteId;
+	int64_t		StartTime;			// Unix time (UTC) of the first sample
+	uint64_t	SampleCount;
+	uint64_t	PayloadSize;		// Bytes of payload following the header
+	char		SiteName[32];		// Zero padded
+	uint32_t	PayloadCrc;			// CRC-32 of the payload bytes
+	uint32_t	HeaderCrc;			// CRC-32 of all header bytes before this field
+} SolarTraceHeader;
+
+typedef struct
+{
+	const SolarTraceHeader	*Header;
+	const uint8_t			*Payload;
+	void					*Map;		// What to munmap, NULL for traces built in memory
+	size_t					MapSize;
+} SolarTrace;
+
+/*
+  Sequential decoder. Reading never copies from the map for a raw trace, and never buffers
+  more than the current run for a compressed one. Sample indexes only go up.
+*/
+typedef struct
+{
+	const uint8_t	*Pos;
+	const uint8_t	*End;
+	uint32_t		Encoding;
+	uint64_t		Consumed;		// Number of samples decoded so far, Value is the last one
+	uint64_t		Count;			// SampleCount of the trace
+	uint8_t			Value;			// Current sample (after delta decoding)
+	uint8_t			RunByte;		// Byte repeated by the current RLE repeat block
+	uint8_t			RunLeft;		// Samples left in the current RLE control block
+	bool			RunRepeats;		// Current block is a repeat (true) or literal (false) block
+} SolarTraceCursor;
+
+int			SolarTrace_Open(SolarTrace *Trace, const char *Path);
+void		SolarTrace_Close(SolarTrace *Trace);
+int			SolarTrace_Verify(const SolarTrace *Trace);
+const char	*SolarTrace_ErrorString(int Error);
+
+// Returns the payload as is when the trace is not compressed, NULL otherwise:
+const uint8_t	*SolarTrace_RawSamples(const SolarTrace *Trace);
+
+void		SolarTrace_Begin(const SolarTrace *Trace, SolarTraceCursor *Cursor);
+size_t		SolarTrace_Read(SolarTraceCursor *Cursor, uint8_t *Out, size_t Count);
+uint8_t		SolarTrace_SampleAt(SolarTraceCursor *Cursor, uint64_t Index);
+
+/*
+  Writing: fill in the site fields of Header (interval, supply voltage, location, name, start
+  time), the rest is filled in by SolarTrace_Write().
+*/
+int			SolarTrace_Write(const char *Path, SolarTraceHeader *Header, uint32_t Encoding,
+							 const uint8_t *Samples, uint64_t Count);
+size_t		SolarTrace_Encode(uint32_t Encoding, const uint8_t *Samples, uint64_t Count, uint8_t *Out);
+size_t		SolarTrace_EncodeBound(uint64_t Count);
+
+uint32_t	SolarTrace_Crc32(uint32_t Crc, const void *Data, size_t Length);
+
+#endif // __SOLAR_TRACE_H__
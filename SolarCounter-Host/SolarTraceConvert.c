@@ -0,0 +1,435 @@
+/*
+ * SolarTraceConvert.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Converts a CSV field log into a trace file (see SolarTrace.h), or shows what is in one.
+ *   gcc -O2 -I. -o SolarTraceConvert SolarTraceConvert.c SolarTrace.c
+ *
+ * Usage:
+ *   SolarTraceConvert [options] log.csv site.sltr
+ *   SolarTraceConvert -I site.sltr
+ *   SolarTraceConvert -T
+ *
+ * The CSV has the time in the first column and the reading in the second, anything after that is
+ * ignored, as are empty lines, lines starting with '#' and lines that don't parse (headers). The
+ * time is either unix time (UTC) or "YYYY-MM-DD HH:MM[:SS]" in site clock time (see -z).
+ * The reading is an ADC count (0..255, as read from ADCL) or, with -m, the sensor voltage in mV.
+ *
+ * Missing samples are filled in with the previous reading, out of order and duplicate times are
+ * dropped. Both are counted and reported, a log with many of them deserves a closer look.
+ *
+ * Options:
+ *   -i seconds     Sample interval (default: time between the first two readings)
+ *   -m             Readings are millivolts, scale against the supply voltage like the firmware does
+ *   -v millivolts  Supply voltage (default: SUPPLY_VOLTAGE_MV from SolarConfig.h)
+ *   -e encoding    raw, delta, rle or delta-rle (default: rle)
+ *   -s id          Site number
+ *   -n name        Site name (up to 31 characters)
+ *   -l lat,lon     Site location in degrees, north and east positive
+ *   -z minutes     Site clock time minus UTC (default: 60, CET)
+ *   -I             Show the header of a trace file and check its payload
+ *   -T             Round-trip the encoder over short, leading-run and random buffers, as a self test
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../SolarCounter-Tiny10/SolarCounter-Tiny10/SolarConfig.h"
+#include "SolarTrace.h"
+
+#define		LINE_LENGTH			256
+
+typedef struct
+{
+	uint8_t		*Samples;
+	uint64_t	Count;
+	uint64_t	Allocated;
+	uint64_t	Filled;			// Samples made up to fill gaps
+	uint64_t	Dropped;		// Readings out of order or on a time already taken
+	uint64_t	Skipped;		// Lines that didn't parse
+} ConvertBuffer;
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: SolarTraceConvert [-i s] [-m] [-v mV] [-e raw|delta|rle|delta-rle] [-s id] [-n name]\n"
+					"                         [-l lat,lon] [-z minutes] log.csv site.sltr\n"
+					"       SolarTraceConvert -I site.sltr\n"
+					"       SolarTraceConvert -T\n");
+	exit(2);
+}
+
+static void Append(ConvertBuffer *Buffer, uint8_t Sample)
+{
+	if(Buffer->Count == Buffer->Allocated)
+	{
+		Buffer->Allocated = (Buffer->Allocated == 0) ? (1 << 20) : Buffer->Allocated * 2;
+		Buffer->Samples = realloc(Buffer->Samples, (size_t)Buffer->Allocated);
+		if(Buffer->Samples == NULL)
+		{
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+	Buffer->Samples[Buffer->Count++] = Sample;
+}
+
+// Time in the first column: unix time, or a clock time in the site's time zone.
+static bool ParseTime(const char *Field, int UtcOffsetMin, int64_t *Time)
+{
+	struct tm	Clock;
+	char		*End;
+	
+	if( (strchr(Field, '-') != NULL) && (strchr(Field, ':') != NULL) )
+	{
+		memset(&Clock, 0, sizeof(Clock));
+		if(sscanf(Field, "%d-%d-%d%*[ T]%d:%d:%d", &Clock.tm_year, &Clock.tm_mon, &Clock.tm_mday,
+				  &Clock.tm_hour, &Clock.tm_min, &Clock.tm_sec) < 5)
+			return false;
+		Clock.tm_year -= 1900;
+		Clock.tm_mon -= 1;
+		*Time = (int64_t)timegm(&Clock) - (int64_t)UtcOffsetMin * 60;
+		return true;
+	}
+	
+	errno = 0;
+	*Time = strtoll(Field, &End, 10);
+	return (errno == 0) && (End != Field);
+}
+
+static bool ParseReading(const char *Field, bool Millivolts, double SupplyMv, uint8_t *Sample)
+{
+	char	*End;
+	double	Value = strtod(Field, &End);
+	
+	if(End == Field)
+		return false;
+	if(Millivolts)
+		Value = (Value * 255.0) / SupplyMv; // Same scaling (and truncation) as DARK_THRESHOLD in SolarCounter.h
+	if(Value < 0)
+		Value = 0;
+	else if(Value > 255)
+		Value = 255;
+	*Sample = (uint8_t)Value;
+	return true;
+}
+
+static int ShowTrace(const char *Path)
+{
+	SolarTrace	Trace;
+	char		Start[32];
+	time_t		StartTime;
+	int			Result = SolarTrace_Open(&Trace, Path);
+	
+	if(Result != SOLAR_TRACE_OK)
+	{
+		fprintf(stderr, "%s: %s\n", Path, SolarTrace_ErrorString(Result));
+		return 1;
+	}
+	
+	StartTime = (time_t)Trace.Header->StartTime;
+	strftime(Start, sizeof(Start), "%Y-%m-%d %H:%M:%S UTC", gmtime(&StartTime));
+	printf("Site:           %u %.32s\n", Trace.Header->SiteId, Trace.Header->SiteName);
+	printf("Location:       %.6f, %.6f (UTC%+d min)\n", Trace.Header->LatitudeE6 / 1e6,
+		   Trace.Header->LongitudeE6 / 1e6, Trace.Header->UtcOffsetMin);
+	printf("Start:          %s\n", Start);
+	printf("Samples:        %llu every %u s (%.1f days)\n", (unsigned long long)Trace.Header->SampleCount,
+		   Trace.Header->SampleIntervalS, Trace.Header->SampleCount * Trace.Header->SampleIntervalS / 86400.0);
+	printf("Supply:         %u mV\n", Trace.Header->SupplyVoltageMv);
+	printf("Encoding:       %s%s%s\n", (Trace.Header->Encoding == SOLAR_TRACE_ENC_RAW) ? "raw" : "",
+		   (Trace.Header->Encoding & SOLAR_TRACE_ENC_DELTA) ? "delta " : "",
+		   (Trace.Header->Encoding & SOLAR_TRACE_ENC_RLE) ? "rle" : "");
+	printf("Payload:        %llu bytes (%.2f bytes/sample)\n", (unsigned long long)Trace.Header->PayloadSize,
+		   Trace.Header->SampleCount ? (double)Trace.Header->PayloadSize / Trace.Header->SampleCount : 0.0);
+	
+	Result = SolarTrace_Verify(&Trace);
+	printf("Payload CRC:    %s\n", (Result == SOLAR_TRACE_OK) ? "ok" : SolarTrace_ErrorString(Result));
+	SolarTrace_Close(&Trace);
+	return (Result == SOLAR_TRACE_OK) ? 0 : 1;
+}
+
+// Encodes Samples in every encoding, decodes them again from memory and compares. Returns the number of failures.
+static int RoundTrip(const uint8_t *Samples, uint64_t Count, const char *Name)
+{
+	static const uint32_t	Encodings[] = { SOLAR_TRACE_ENC_RAW, SOLAR_TRACE_ENC_DELTA, SOLAR_TRACE_ENC_RLE,
+											SOLAR_TRACE_ENC_DELTA | SOLAR_TRACE_ENC_RLE };
+	SolarTraceHeader	Header;
+	SolarTrace			Trace;
+	SolarTraceCursor	Cursor;
+	uint8_t				*Payload = malloc(SolarTrace_EncodeBound(Count) + 1);
+	uint8_t				*Decoded = malloc((size_t)Count + 1);
+	int					Failures = 0;
+	unsigned int		Which;
+	
+	if( (Payload == NULL) || (Decoded == NULL) )
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	for(Which = 0; Which < sizeof(Encodings) / sizeof(Encodings[0]); Which++)
+	{
+		memset(&Header, 0, sizeof(Header));
+		memset(&Trace, 0, sizeof(Trace));
+		Header.Encoding = Encodings[Which];
+		Header.SampleCount = Count;
+		Header.PayloadSize = SolarTrace_Encode(Header.Encoding, Samples, Count, Payload);
+		Trace.Header = &Header;
+		Trace.Payload = Payload;
+		
+		SolarTrace_Begin(&Trace, &Cursor);
+		if( (Header.PayloadSize > SolarTrace_EncodeBound(Count))
+			|| (SolarTrace_Read(&Cursor, Decoded, (size_t)Count) != Count)
+			|| ((Count != 0) && (memcmp(Samples, Decoded, (size_t)Count) != 0)) )
+		{
+			fprintf(stderr, "%s (%llu samples, encoding %u): round trip failed\n", Name,
+					(unsigned long long)Count, Header.Encoding);
+			Failures++;
+		}
+	}
+	free(Payload);
+	free(Decoded);
+	return Failures;
+}
+
+static int SelfTest(void)
+{
+	static const uint8_t	LeadingRun[] = { 9, 9, 9, 9, 1 };
+	static const uint8_t	RunAfterLiteral[] = { 5, 9, 9, 9, 9, 1 };
+	static const uint8_t	OnlyRun[] = { 7, 7, 7 };
+	static const uint8_t	TwoRuns[] = { 3, 3, 3, 4, 4, 4, 4 };
+	static const uint8_t	ShortPair[] = { 2, 2 };
+	static const uint8_t	Single[] = { 42 };
+	uint8_t					Buffer[1000];
+	uint64_t				Count;
+	uint32_t				Random = 1;
+	int						Failures = 0;
+	
+	Failures += RoundTrip(Buffer, 0, "empty");
+	Failures += RoundTrip(Single, sizeof(Single), "single");
+	Failures += RoundTrip(ShortPair, sizeof(ShortPair), "short pair");
+	Failures += RoundTrip(OnlyRun, sizeof(OnlyRun), "only a run");
+	Failures += RoundTrip(LeadingRun, sizeof(LeadingRun), "leading run");
+	Failures += RoundTrip(RunAfterLiteral, sizeof(RunAfterLiteral), "run after a literal");
+	Failures += RoundTrip(TwoRuns, sizeof(TwoRuns), "two runs");
+	
+	// Runs and literal blocks around their maximum lengths, starting with either:
+	for(Count = 1; Count <= 300; Count++)
+	{
+		uint64_t	Index;
+		
+		for(Index = 0; Index < Count; Index++)
+			Buffer[Index] = (Index < Count / 2) ? 200 : (uint8_t)Index;
+		Failures += RoundTrip(Buffer, Count, "run then literals");
+		for(Index = 0; Index < Count; Index++)
+			Buffer[Index] = (Index < Count / 2) ? (uint8_t)Index : 200;
+		Failures += RoundTrip(Buffer, Count, "literals then run");
+	}
+	
+	// Random mixes of short literals and runs, like a sensor log but denser in edges:
+	for(Count = 0; Count < 2000; Count++)
+	{
+		uint64_t	Length = 1 + Count % sizeof(Buffer);
+		uint64_t	Index = 0;
+		
+		while(Index < Length)
+		{
+			uint32_t	Span;
+			uint8_t		Value;
+			
+			Random = Random * 1103515245 + 12345;
+			Span = 1 + (Random >> 16) % ((Random & 0x100) ? 140 : 4);
+			Value = (uint8_t)(Random >> 24);
+			for(; (Span != 0) && (Index < Length); Span--, Index++)
+				Buffer[Index] = (Random & 0x200) ? Value : (uint8_t)(Value + Index);
+		}
+		Failures += RoundTrip(Buffer, Length, "random");
+	}
+	
+	printf("Encoder round trip: %s\n", (Failures == 0) ? "ok" : "FAILED");
+	return (Failures == 0) ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	SolarTraceHeader	Header;
+	ConvertBuffer		Buffer;
+	uint32_t			Encoding = SOLAR_TRACE_ENC_RLE;
+	bool				Millivolts = false;
+	double				SupplyMv = SUPPLY_VOLTAGE_MV;
+	int64_t				Interval = 0;
+	int64_t				FirstTime = 0;
+	int64_t				PendingTime = 0;	// Time of the first reading, while the interval is still unknown
+	uint8_t				PendingSample = 0;
+	bool				HavePending = false;
+	double				Latitude = 0;
+	double				Longitude = 0;
+	char				Line[LINE_LENGTH];
+	FILE				*Input;
+	int					Option;
+	int					Result;
+	
+	memset(&Header, 0, sizeof(Header));
+	memset(&Buffer, 0, sizeof(Buffer));
+	Header.UtcOffsetMin = 60;
+	
+	while( (Option = getopt(argc, argv, "i:mv:e:s:n:l:z:IT")) != -1 )
+	{
+		switch(Option)
+		{
+			case 'i':	Interval = strtoll(optarg, NULL, 10); break;
+			case 'm':	Millivolts = true; break;
+			case 'v':	SupplyMv = strtod(optarg, NULL); break;
+			case 's':	Header.SiteId = (uint16_t)strtoul(optarg, NULL, 10); break;
+			case 'n':	strncpy(Header.SiteName, optarg, sizeof(Header.SiteName) - 1); break;
+			case 'z':	Header.UtcOffsetMin = (int16_t)strtol(optarg, NULL, 10); break;
+			case 'l':
+				if(sscanf(optarg, "%lf,%lf", &Latitude, &Longitude) != 2)
+					Usage();
+				break;
+			case 'e':
+				if(strcmp(optarg, "raw") == 0)				Encoding = SOLAR_TRACE_ENC_RAW;
+				else if(strcmp(optarg, "delta") == 0)		Encoding = SOLAR_TRACE_ENC_DELTA;
+				else if(strcmp(optarg, "rle") == 0)			Encoding = SOLAR_TRACE_ENC_RLE;
+				else if(strcmp(optarg, "delta-rle") == 0)	Encoding = SOLAR_TRACE_ENC_DELTA | SOLAR_TRACE_ENC_RLE;
+				else Usage();
+				break;
+			case 'I':
+				if(optind != argc - 1)
+					Usage();
+				return ShowTrace(argv[optind]);
+			case 'T':
+				return SelfTest();
+			default:
+				Usage();
+		}
+	}
+	if(optind != argc - 2)
+		Usage();
+	
+	Input = (strcmp(argv[optind], "-") == 0) ? stdin : fopen(argv[optind], "r");
+	if(Input == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+		return 1;
+	}
+	
+	while(fgets(Line, sizeof(Line), Input) != NULL)
+	{
+		char		*Comma = strchr(Line, ',');
+		int64_t		Time;
+		uint8_t		Sample;
+		
+		if( (Line[0] == '#') || (Line[0] == '\n') || (Line[0] == '\r') )
+			continue;
+		if( (Comma == NULL) || !ParseTime(Line, Header.UtcOffsetMin, &Time)
+			|| !ParseReading(Comma + 1, Millivolts, SupplyMv, &Sample) )
+		{
+			Buffer.Skipped++;
+			continue;
+		}
+		
+		if( (Buffer.Count == 0) && (Interval == 0) )
+		{ // Interval not given: take it from the first two readings
+			if(!HavePending)
+			{
+				PendingTime = Time;
+				PendingSample = Sample;
+				HavePending = true;
+				continue;
+			}
+			if(Time <= PendingTime)
+			{
+				Buffer.Dropped++;
+				continue;
+			}
+			Interval = Time - PendingTime;
+		}
+		if(HavePending)
+		{
+			FirstTime = PendingTime;
+			Append(&Buffer, PendingSample);
+			HavePending = false;
+		}
+		else if(Buffer.Count == 0)
+		{
+			FirstTime = Time;
+		}
+		
+		{
+			int64_t	Index = (Time - FirstTime + Interval / 2) / Interval;
+			
+			if( (Time < FirstTime) || ((uint64_t)Index < Buffer.Count) )
+			{
+				Buffer.Dropped++;
+				continue;
+			}
+			while((uint64_t)Index > Buffer.Count)
+			{
+				Append(&Buffer, Buffer.Samples[Buffer.Count - 1]);
+				Buffer.Filled++;
+			}
+			Append(&Buffer, Sample);
+		}
+	}
+	if(HavePending)
+	{ // Just the one reading
+		FirstTime = PendingTime;
+		Append(&Buffer, PendingSample);
+	}
+	if(Input != stdin)
+		fclose(Input);
+	
+	if( (Buffer.Count == 0) || (Interval <= 0) )
+	{
+		fprintf(stderr, "%s: need at least two readings, or one and -i\n", argv[optind]);
+		return 1;
+	}
+	
+	Header.SampleIntervalS = (uint32_t)Interval;
+	Header.SupplyVoltageMv = (uint32_t)SupplyMv;
+	Header.LatitudeE6 = (int32_t)(Latitude * 1e6);
+	Header.LongitudeE6 = (int32_t)(Longitude * 1e6);
+	Header.StartTime = FirstTime;
+	
+	Result = SolarTrace_Write(argv[optind + 1], &Header, Encoding, Buffer.Samples, Buffer.Count);
+	if(Result != SOLAR_TRACE_OK)
+	{
+		fprintf(stderr, "%s: %s\n", argv[optind + 1], SolarTrace_ErrorString(Result));
+		return 1;
+	}
+	
+	fprintf(stderr, "%llu samples every %lld s, %llu bytes (%llu filled in, %llu dropped, %llu lines skipped)\n",
+			(unsigned long long)Buffer.Count, (long long)Interval, (unsigned long long)Header.PayloadSize,
+			(unsigned long long)Buffer.Filled, (unsigned long long)Buffer.Dropped, (unsigned long long)Buffer.Skipped);
+	free(Buffer.Samples);
+	return 0;
+}
@@ -0,0 +1,618 @@
+/*
+ * SolarUnitConfig.c
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Stamps per-unit values into the configuration block (USE_UNIT_CONFIG_BLOCK in SolarConfig.h)
+ * of a release HEX file, one output file per unit:
+ *   gcc -O2 -I. -o SolarUnitConfig SolarUnitConfig.c
+ *
+ * Usage:
+ *   SolarUnitConfig [-a address] [-o directory] [-n] release.hex [units.csv]
+ *
+ * Without a CSV file the block in the release file is checked and printed, along with the flash
+ * the program takes (code and initialised data, what avr-size counts as .text plus .data) and
+ * what is left of the budget below the block. The block sits at the end of the flash, a file
+ * with data past it is refused. With a CSV file every row
+ * gives a unit, and <directory>/<unit>.hex is written: the release image with the unit ID and
+ * the values of that row in the block, and a new check byte. The block of the release file is
+ * checked first (layout version and check byte), and every written file is read back and checked
+ * again, nothing is written when the release file or any row is wrong.
+ *
+ * The CSV file starts with a header row naming the columns, "unit" is the only one needed. Any
+ * other column replaces the release value of one field, an empty cell keeps it:
+ *   unit               Unit ID, 0 to 65535, also the output file name
+ *   tick_constant      TICK_CONSTANT
+ *   ticks_day          TICKS_BEFORE_SAMPLE_DAY, 1 to 255
+ *   ticks_night        TICKS_BEFORE_SAMPLE_NIGHT, 1 to 255
+ *   dark_threshold     DARK_THRESHOLD, in ADC counts (8 bit, against SUPPLY_VOLTAGE_MV)
+ *   light_threshold    LIGHT_THRESHOLD, in ADC counts, above dark_threshold
+ *   min_afterglow      MINIMUM_AFTERGLOW_MINUTES, in night ticks
+ *   max_afterglow      MAXIMUM_AFTERGLOW_MINUTES, at least min_afterglow
+ *   threshold1, pwm1   First afterglow limitation step, in night ticks and PWM value
+ *   threshold2, pwm2   Second step, swapped with the first if its threshold is lower
+ * Values are decimal or 0x.. hex, lines starting with # are skipped.
+ *
+ * Options:
+ *   -a address     The block is at this flash address (0x.. for hex), default 0x3EC for the ATtiny10
+ *   -o directory   Write the unit files here, default the current directory
+ *   -n             Check the release file and the CSV file, don't write anything
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define		UNIT_BLOCK_VERSION		1		// Copy of SolarCounter.h, which only defines it with USE_UNIT_CONFIG_BLOCK
+#define		UNIT_BLOCK_MAGIC		(0xC0 | UNIT_BLOCK_VERSION)
+#define		UNIT_BLOCK_MAGIC_MASK	0xF0
+#define		UNIT_BLOCK_BYTES		20
+#define		UNIT_BLOCK_ADDRESS		(0x400 - UNIT_BLOCK_BYTES) // End of the ATtiny10 flash
+
+#define		IMAGE_BYTES_MAXIMUM		0x10000
+#define		CSV_COLUMNS_MAXIMUM		32
+
+// The fields of UnitConfigBlock in the firmware, by offset:
+typedef struct
+{
+	const char	*Column;
+	uint8_t		Offset;
+	uint8_t		Width;
+	uint16_t	Minimum;
+} UnitField;
+
+enum
+{
+	FIELD_UNIT, FIELD_TICK_CONSTANT, FIELD_TICKS_DAY, FIELD_TICKS_NIGHT, FIELD_DARK, FIELD_LIGHT,
+	FIELD_MIN_AFTERGLOW, FIELD_MAX_AFTERGLOW, FIELD_THRESHOLD1, FIELD_PWM1, FIELD_THRESHOLD2, FIELD_PWM2,
+	FIELD_COUNT
+};
+
+static const UnitField	Fields[FIELD_COUNT] =
+{
+	{ "unit",				2,	2,	0 },
+	{ "tick_constant",		4,	2,	1 },
+	{ "ticks_day",			1,	1,	1 },
+	{ "ticks_night",		14,	1,	1 },
+	{ "dark_threshold",		15,	1,	1 },
+	{ "light_threshold",	16,	1,	1 },
+	{ "min_afterglow",		6,	2,	1 },
+	{ "max_afterglow",		8,	2,	1 },
+	{ "threshold1",			10,	2,	0 },
+	{ "pwm1",				17,	1,	0 },
+	{ "threshold2",			12,	2,	0 },
+	{ "pwm2",				18,	1,	0 },
+};
+
+#define		BLOCK_CHECK_OFFSET		19
+
+typedef struct
+{
+	uint8_t		*Bytes;
+	bool		*Valid;			// Addresses the HEX file has data for
+	uint32_t	Size;
+} FlashImage;
+
+static void Usage(void)
+{
+	fprintf(stderr, "Usage: SolarUnitConfig [-a address] [-o directory] [-n] release.hex [units.csv]\n");
+	exit(2);
+}
+
+static int HexByte(const char *Text)
+{
+	unsigned int	Value;
+	
+	if( (sscanf(Text, "%2x", &Value) != 1) || (Text[0] == '\0') || (Text[1] == '\0') )
+		return -1;
+	return (int)Value;
+}
+
+// Intel HEX, data records (00) with extended segment (02) and linear (04) addresses, up to 64kB:
+static bool ReadHex(FILE *File, FlashImage *Image)
+{
+	char		Line[600];
+	uint32_t	Base = 0;
+	
+	while(fgets(Line, sizeof(Line), File) != NULL)
+	{
+		int			Count, Type, Byte;
+		uint32_t	Address;
+		uint8_t		Check;
+		
+		if(Line[0] != ':')
+			continue;
+		Count = HexByte(Line + 1);
+		if( (Count < 0) || (strlen(Line) < 11 + 2 * (size_t)Count) )
+			return false;
+		Address = (HexByte(Line + 3) << 8) | HexByte(Line + 5);
+		Type = HexByte(Line + 7);
+		Check = Count + (Address >> 8) + Address + Type;
+		for(int Index = 0; Index <= Count; Index++)
+		{
+			if( (Byte = HexByte(Line + 9 + 2 * Index)) < 0 )
+				return false;
+			Check += Byte;
+		}
+		if(Check != 0)
+			return false;
+		
+		if(Type == 0x00)
+		{
+			for(int Index = 0; Index < Count; Index++)
+			{
+				uint32_t	At = Base + Address + Index;
+				
+				if(At >= IMAGE_BYTES_MAXIMUM)
+					return false;
+				Image->Bytes[At] = HexByte(Line + 9 + 2 * Index);
+				Image->Valid[At] = true;
+				if(At >= Image->Size)
+					Image->Size = At + 1;
+			}
+		}
+		else if(Type == 0x01)
+			break;
+		else if( (Type == 0x02) && (Count == 2) )
+			Base = ((HexByte(Line + 9) << 8) | HexByte(Line + 11)) << 4;
+		else if( (Type == 0x04) && (Count == 2) )
+			Base = ((HexByte(Line + 9) << 8) | HexByte(Line + 11)) << 16;
+	}
+	return true;
+}
+
+static bool ReadImage(const char *Path, FlashImage *Image)
+{
+	FILE	*File = fopen(Path, "r");
+	bool	Good;
+	
+	if(File == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", Path, strerror(errno));
+		return false;
+	}
+	memset(Image->Valid, 0, IMAGE_BYTES_MAXIMUM * sizeof(bool));
+	Image->Size = 0;
+	Good = ReadHex(File, Image);
+	fclose(File);
+	
+	if(!Good)
+		fprintf(stderr, "%s: not a valid Intel HEX file\n", Path);
+	return Good;
+}
+
+// Data records of 16 bytes, split where the image has no data, and the end record:
+static bool WriteHex(const char *Path, const FlashImage *Image)
+{
+	FILE		*File = fopen(Path, "w");
+	uint32_t	At = 0;
+	
+	if(File == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", Path, strerror(errno));
+		return false;
+	}
+	while(At < Image->Size)
+	{
+		uint32_t	Count = 0;
+		uint8_t		Check;
+		
+		if(!Image->Valid[At])
+		{
+			At++;
+			continue;
+		}
+		while( (Count < 16) && (At + Count < Image->Size) && Image->Valid[At + Count] )
+			Count++;
+		
+		Check = Count + (At >> 8) + At;
+		fprintf(File, ":%02X%04X00", Count, At);
+		for(uint32_t Index = 0; Index < Count; Index++)
+		{
+			fprintf(File, "%02X", Image->Bytes[At + Index]);
+			Check += Image->Bytes[At + Index];
+		}
+		fprintf(File, "%02X\n", (uint8_t)(0 - Check));
+		At += Count;
+	}
+	fprintf(File, ":00000001FF\n");
+	
+	if(fclose(File) != 0)
+	{
+		fprintf(stderr, "%s: %s\n", Path, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+static uint32_t GetField(const uint8_t *Block, int Field)
+{
+	const uint8_t	*Value = Block + Fields[Field].Offset;
+	
+	return (Fields[Field].Width == 1) ? Value[0] : (Value[0] | (Value[1] << 8));
+}
+
+static void SetField(uint8_t *Block, int Field, uint32_t Value)
+{
+	Block[Fields[Field].Offset] = Value;
+	if(Fields[Field].Width == 2)
+		Block[Fields[Field].Offset + 1] = Value >> 8;
+}
+
+static uint8_t BlockSum(const uint8_t *Block)
+{
+	uint8_t	Sum = 0;
+	
+	for(int Index = 0; Index < UNIT_BLOCK_BYTES; Index++)
+		Sum += Block[Index];
+	return Sum;
+}
+
+static bool CheckBlock(const FlashImage *Image, uint32_t Address, const char *Path)
+{
+	const uint8_t	*Block = Image->Bytes + Address;
+	
+	for(uint32_t Index = 0; Index < UNIT_BLOCK_BYTES; Index++)
+	{
+		if( (Address + Index >= Image->Size) || !Image->Valid[Address + Index] )
+		{
+			fprintf(stderr, "%s: no data at 0x%04X, built without USE_UNIT_CONFIG_BLOCK?\n", Path, Address + Index);
+			return false;
+		}
+	}
+	if( (Block[0] & UNIT_BLOCK_MAGIC_MASK) != (UNIT_BLOCK_MAGIC & UNIT_BLOCK_MAGIC_MASK) )
+	{
+		fprintf(stderr, "%s: no configuration block at 0x%04X (magic 0x%02X)\n", Path, Address, Block[0]);
+		return false;
+	}
+	if(Block[0] != UNIT_BLOCK_MAGIC)
+	{
+		fprintf(stderr, "%s: block layout version %u, this tool knows version %u\n", Path,
+				Block[0] & ~UNIT_BLOCK_MAGIC_MASK, UNIT_BLOCK_VERSION);
+		return false;
+	}
+	if(BlockSum(Block) != 0)
+	{
+		fprintf(stderr, "%s: configuration block check byte is wrong\n", Path);
+		return false;
+	}
+	return true;
+}
+
+// The flash below the block is the program's budget, the linker keeps it out of the block itself:
+static bool CheckBudget(const FlashImage *Image, uint32_t Address, const char *Path, uint32_t *Used)
+{
+	*Used = 0;
+	for(uint32_t At = 0; At < Image->Size; At++)
+	{
+		if(!Image->Valid[At])
+			continue;
+		if(At >= Address + UNIT_BLOCK_BYTES)
+		{
+			fprintf(stderr, "%s: data at 0x%04X, past the configuration block at the end of the flash\n", Path, At);
+			return false;
+		}
+		if(At < Address)
+			*Used = At + 1;
+	}
+	return true;
+}
+
+static void PrintBlock(const uint8_t *Block, uint32_t Address)
+{
+	printf("Block at 0x%04X: version %u\n", Address, Block[0] & ~UNIT_BLOCK_MAGIC_MASK);
+	for(int Field = 0; Field < FIELD_COUNT; Field++)
+		printf("  %-16s%u\n", Fields[Field].Column, GetField(Block, Field));
+}
+
+// Splits Line at the commas, in place. Returns the number of cells, -1 if there are too many:
+static int SplitCsv(char *Line, char **Cells)
+{
+	int		Count = 0;
+	char	*Cell = Line;
+	
+	Line[strcspn(Line, "\r\n")] = '\0';
+	while(1)
+	{
+		char	*Comma = strchr(Cell, ',');
+		char	*End;
+		
+		if(Count == CSV_COLUMNS_MAXIMUM)
+			return -1;
+		if(Comma != NULL)
+			*Comma = '\0';
+		while( (*Cell == ' ') || (*Cell == '\t') )
+			Cell++;
+		End = Cell + strlen(Cell);
+		while( (End > Cell) && ((End[-1] == ' ') || (End[-1] == '\t')) )
+			*--End = '\0';
+		Cells[Count++] = Cell;
+		if(Comma == NULL)
+			return Count;
+		Cell = Comma + 1;
+	}
+}
+
+// Checks the values of one unit the way SolarCounter.h checks the compile-time ones:
+static bool CheckUnit(uint8_t *Block, const char *Where)
+{
+	if(GetField(Block, FIELD_DARK) >= GetField(Block, FIELD_LIGHT))
+	{
+		fprintf(stderr, "%s: dark_threshold has to be below light_threshold\n", Where);
+		return false;
+	}
+	if(GetField(Block, FIELD_MIN_AFTERGLOW) > GetField(Block, FIELD_MAX_AFTERGLOW))
+	{
+		fprintf(stderr, "%s: min_afterglow is larger than max_afterglow\n", Where);
+		return false;
+	}
+	if(GetField(Block, FIELD_THRESHOLD1) > GetField(Block, FIELD_THRESHOLD2))
+	{
+		uint32_t	Threshold = GetField(Block, FIELD_THRESHOLD1);
+		uint32_t	Pwm = GetField(Block, FIELD_PWM1);
+		
+		fprintf(stderr, "%s: threshold1 larger than threshold2, swapping 1 and 2 values\n", Where);
+		SetField(Block, FIELD_THRESHOLD1, GetField(Block, FIELD_THRESHOLD2));
+		SetField(Block, FIELD_PWM1, GetField(Block, FIELD_PWM2));
+		SetField(Block, FIELD_THRESHOLD2, Threshold);
+		SetField(Block, FIELD_PWM2, Pwm);
+	}
+	return true;
+}
+
+/*
+  Reads the CSV file into one block per unit, starting from the release block. Returns the
+  number of units, or -1 after printing what is wrong.
+*/
+static int ReadUnits(const char *Path, const uint8_t *Release, uint8_t (**Units)[UNIT_BLOCK_BYTES])
+{
+	FILE	*File = fopen(Path, "r");
+	char	Line[1024];
+	char	*Cells[CSV_COLUMNS_MAXIMUM];
+	int		Column[CSV_COLUMNS_MAXIMUM];	// Field of every column
+	int		Columns = 0;
+	int		Count = 0;
+	int		Allocated = 0;
+	int		LineNumber = 0;
+	bool	Good = true;
+	
+	if(File == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", Path, strerror(errno));
+		return -1;
+	}
+	*Units = NULL;
+	
+	while( Good && (fgets(Line, sizeof(Line), File) != NULL) )
+	{
+		char	Where[300];
+		int		Cell;
+		
+		LineNumber++;
+		snprintf(Where, sizeof(Where), "%s:%d", Path, LineNumber);
+		if( (Line[0] == '#') || (Line[strspn(Line, " \t\r\n")] == '\0') )
+			continue;
+		if( (Cell = SplitCsv(Line, Cells)) < 0 )
+		{
+			fprintf(stderr, "%s: more than %d columns\n", Where, CSV_COLUMNS_MAXIMUM);
+			Good = false;
+			break;
+		}
+		
+		if(Columns == 0)
+		{
+			bool	HasUnit = false;
+			
+			Columns = Cell;
+			for(int Index = 0; (Index < Columns) && Good; Index++)
+			{
+				Column[Index] = -1;
+				for(int Field = 0; Field < FIELD_COUNT; Field++)
+				{
+					if(strcmp(Cells[Index], Fields[Field].Column) == 0)
+						Column[Index] = Field;
+				}
+				if(Column[Index] < 0)
+				{
+					fprintf(stderr, "%s: unknown column \"%s\"\n", Where, Cells[Index]);
+					Good = false;
+				}
+				for(int Before = 0; Good && (Before < Index); Before++)
+				{
+					if(Column[Before] == Column[Index])
+					{
+						fprintf(stderr, "%s: column \"%s\" is there twice\n", Where, Cells[Index]);
+						Good = false;
+					}
+				}
+				HasUnit |= (Column[Index] == FIELD_UNIT);
+			}
+			if(Good && !HasUnit)
+			{
+				fprintf(stderr, "%s: no \"unit\" column\n", Where);
+				Good = false;
+			}
+			continue;
+		}
+		
+		if(Cell != Columns)
+		{
+			fprintf(stderr, "%s: %d cells, the header has %d\n", Where, Cell, Columns);
+			Good = false;
+			break;
+		}
+		if(Count == Allocated)
+		{
+			void	*Grown;
+			
+			Allocated = (Allocated == 0) ? 64 : 2 * Allocated;
+			if( (Grown = realloc(*Units, Allocated * sizeof(**Units))) == NULL )
+			{
+				fprintf(stderr, "Out of memory\n");
+				Good = false;
+				break;
+			}
+			*Units = Grown;
+		}
+		
+		uint8_t	*Block = (*Units)[Count];
+		
+		memcpy(Block, Release, UNIT_BLOCK_BYTES);
+		for(int Index = 0; Index < Columns; Index++)
+		{
+			const UnitField	*Field = &Fields[Column[Index]];
+			uint32_t		Maximum = (Field->Width == 1) ? 0xFF : 0xFFFF;
+			char			*End;
+			long			Value;
+			
+			if( (Cells[Index][0] == '\0') && (Column[Index] != FIELD_UNIT) )
+				continue;
+			Value = strtol(Cells[Index], &End, 0);
+			if( (*End != '\0') || (Cells[Index][0] == '\0') || (Value < Field->Minimum) || (Value > (long)Maximum) )
+			{
+				fprintf(stderr, "%s: %s \"%s\" is not a number from %u to %u\n", Where, Field->Column,
+						Cells[Index], Field->Minimum, Maximum);
+				Good = false;
+				break;
+			}
+			SetField(Block, Column[Index], (uint32_t)Value);
+		}
+		for(int Before = 0; Good && (Before < Count); Before++)
+		{
+			if(GetField((*Units)[Before], FIELD_UNIT) == GetField(Block, FIELD_UNIT))
+			{
+				fprintf(stderr, "%s: unit %u is there twice\n", Where, GetField(Block, FIELD_UNIT));
+				Good = false;
+			}
+		}
+		if(Good && !CheckUnit(Block, Where))
+			Good = false;
+		
+		Block[BLOCK_CHECK_OFFSET] = 0;
+		Block[BLOCK_CHECK_OFFSET] = 0 - BlockSum(Block);
+		Count++;
+	}
+	fclose(File);
+	
+	if(Good && (Columns == 0))
+	{
+		fprintf(stderr, "%s: no header row\n", Path);
+		Good = false;
+	}
+	if(!Good)
+	{
+		free(*Units);
+		*Units = NULL;
+		return -1;
+	}
+	return Count;
+}
+
+int main(int argc, char **argv)
+{
+	FlashImage	Image;
+	FlashImage	Written;
+	long		Address = UNIT_BLOCK_ADDRESS;
+	const char	*Directory = ".";
+	bool		DryRun = false;
+	int			Option;
+	int			Count;
+	uint8_t		Release[UNIT_BLOCK_BYTES];
+	uint8_t		(*Units)[UNIT_BLOCK_BYTES];
+	uint32_t	Used;
+	
+	while( (Option = getopt(argc, argv, "a:o:n")) != -1 )
+	{
+		if(Option == 'a')
+		{
+			char	*End;
+			
+			Address = strtol(optarg, &End, 0);
+			if( (*End != '\0') || (Address < 0) || (Address > IMAGE_BYTES_MAXIMUM - UNIT_BLOCK_BYTES) )
+				Usage();
+		}
+		else if(Option == 'o')
+			Directory = optarg;
+		else if(Option == 'n')
+			DryRun = true;
+		else
+			Usage();
+	}
+	if( (argc - optind < 1) || (argc - optind > 2) )
+		Usage();
+	
+	Image.Bytes = malloc(IMAGE_BYTES_MAXIMUM);
+	Image.Valid = malloc(IMAGE_BYTES_MAXIMUM * sizeof(bool));
+	Written.Bytes = malloc(IMAGE_BYTES_MAXIMUM);
+	Written.Valid = malloc(IMAGE_BYTES_MAXIMUM * sizeof(bool));
+	if( (Image.Bytes == NULL) || (Image.Valid == NULL) || (Written.Bytes == NULL) || (Written.Valid == NULL) )
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	
+	if( !ReadImage(argv[optind], &Image) || !CheckBlock(&Image, (uint32_t)Address, argv[optind])
+	   || !CheckBudget(&Image, (uint32_t)Address, argv[optind], &Used) )
+		return 1;
+	memcpy(Release, Image.Bytes + Address, UNIT_BLOCK_BYTES);
+	if(argc - optind == 1)
+	{
+		printf("Program: %u bytes, %u left below the block\n", Used, (uint32_t)Address - Used);
+		PrintBlock(Release, (uint32_t)Address);
+		return 0;
+	}
+	
+	if( (Count = ReadUnits(argv[optind + 1], Release, &Units)) < 0 )
+		return 1;
+	if(DryRun)
+	{
+		printf("%d unit%s, nothing written\n", Count, (Count == 1) ? "" : "s");
+		free(Units);
+		return 0;
+	}
+	
+	for(int Unit = 0; Unit < Count; Unit++)
+	{
+		char	Path[4096];
+		
+		snprintf(Path, sizeof(Path), "%s/%u.hex", Directory, GetField(Units[Unit], FIELD_UNIT));
+		memcpy(Image.Bytes + Address, Units[Unit], UNIT_BLOCK_BYTES);
+		if( !WriteHex(Path, &Image) || !ReadImage(Path, &Written) || !CheckBlock(&Written, (uint32_t)Address, Path)
+		   || (Written.Size != Image.Size) || (memcmp(Written.Bytes, Image.Bytes, Image.Size) != 0) )
+		{
+			fprintf(stderr, "%s: did not read back as written\n", Path);
+			free(Units);
+			return 1;
+		}
+		printf("%s\n", Path);
+	}
+	free(Units);
+	return 0;
+}
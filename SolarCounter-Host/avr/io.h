@@ -0,0 +1,153 @@
+/*
+ * avr/io.h (host build)
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Stand-in for the avr-libc header when compiling the firmware source on a PC. Every I/O
+ * register of the ATtiny10 is mapped onto a byte in the SolarHost_IO array, at its own I/O
+ * address, so the firmware reads and writes "registers" exactly as it does on the chip and the
+ * host code in SolarHost.c can inspect them afterwards.
+ *
+ * Only the registers and bit names the firmware uses are defined here. If a change to the
+ * firmware uses a new one, add it below with the address/bit from the ATtiny10 datasheet.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#ifndef __SOLAR_HOST_AVR_IO_H__
+#define __SOLAR_HOST_AVR_IO_H__
+
+#include <stdint.h>
+
+#define		__AVR_ATtiny10__		1	// The host build always stands in for the ATtiny10
+
+extern uint8_t	SolarHost_IO[0x40];		// I/O space 0x00 to 0x3F, see SolarHost.c
+uint8_t		*SolarHost_AdcControl(void);
+
+#define		FLASHEND			0x3FF
+extern uint8_t	SolarHost_Flash[FLASHEND + 1];	// Program memory, only the data the firmware reads from it
+#define		MAPPED_FLASH_START	((uintptr_t)SolarHost_Flash)	// Where LD finds the flash, 0x4000 on the chip
+
+#define		RAMSTART			0x40
+#define		RAMEND				0x5F
+extern uint8_t	SolarHost_Data[RAMEND + 1];	// Data space, only what the firmware keeps at a fixed address (DATA_AT)
+#define		DATA_SPACE_START	((uintptr_t)SolarHost_Data)
+#define		BSS_END_ADDRESS		RAMSTART	// The host keeps the globals outside of SolarHost_Data
+
+#define		UNIT_CONFIG_LINKED	1	// No linker here, SolarHost_Reset copies the unit configuration block in place
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Registers (I/O addresses, page 8 and on of the ATtiny10 datasheet)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#define		PINB		SolarHost_IO[0x00]
+#define		DDRB		SolarHost_IO[0x01]
+#define		PORTB		SolarHost_IO[0x02]
+#define		PUEB		SolarHost_IO[0x03]
+#define		PCMSK		SolarHost_IO[0x10]
+#define		PCIFR		SolarHost_IO[0x11]
+#define		PCICR		SolarHost_IO[0x12]
+#define		DIDR0		SolarHost_IO[0x17]
+#define		ADCL		SolarHost_IO[0x19]
+#define		ADMUX		SolarHost_IO[0x1B]
+#define		ADCSRB		SolarHost_IO[0x1C]
+#define		ADCSRA		(*SolarHost_AdcControl())	// Finishes a polled conversion when read, see SolarHost.c
+#define		ACSR		SolarHost_IO[0x1F]
+#define		ICR0L		SolarHost_IO[0x22]
+#define		ICR0H		SolarHost_IO[0x23]
+#define		OCR0BL		SolarHost_IO[0x24]
+#define		OCR0BH		SolarHost_IO[0x25]
+#define		OCR0AL		SolarHost_IO[0x26]
+#define		OCR0AH		SolarHost_IO[0x27]
+#define		TCNT0L		SolarHost_IO[0x28]
+#define		TCNT0H		SolarHost_IO[0x29]
+#define		TIFR0		SolarHost_IO[0x2A]
+#define		TIMSK0		SolarHost_IO[0x2B]
+#define		TCCR0C		SolarHost_IO[0x2C]
+#define		TCCR0B		SolarHost_IO[0x2D]
+#define		TCCR0A		SolarHost_IO[0x2E]
+#define		GTCCR		SolarHost_IO[0x2F]
+#define		WDTCSR		SolarHost_IO[0x31]
+#define		PRR			SolarHost_IO[0x35]
+#define		CLKPSR		SolarHost_IO[0x36]
+#define		CLKMSR		SolarHost_IO[0x37]
+#define		OSCCAL		SolarHost_IO[0x39]
+#define		SMCR		SolarHost_IO[0x3A]
+#define		RSTFLR		SolarHost_IO[0x3B]
+#define		CCP			SolarHost_IO[0x3C]
+#define		SP			SolarHost_IO[0x3D]	// SPL, SPH stays 0 with 32 bytes of SRAM
+#define		SREG		SolarHost_IO[0x3F]
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Bit names
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#define		PORTB0		0
+#define		PORTB1		1
+#define		PORTB2		2
+#define		PORTB3		3
+#define		PINB0		0
+#define		PINB1		1
+#define		PINB2		2
+#define		PINB3		3
+
+#define		PCINT0		0
+#define		PCINT1		1
+#define		PCINT2		2
+#define		PCINT3		3
+#define		PCIE0		0
+#define		PCIF0		0
+
+#define		ADC0D		0
+#define		ADC1D		1
+#define		ADC2D		2
+#define		ADC3D		3
+
+#define		ADEN		7
+#define		ADSC		6
+#define		ADATE		5
+#define		ADIF		4
+#define		ADIE		3
+
+#define		TOIE0		0
+#define		OCIE0A		1
+#define		OCIE0B		2
+#define		TOV0		0
+
+#define		WDIF		7
+#define		WDIE		6
+#define		WDP3		5
+#define		WDE			3
+
+#define		PRTIM0		0
+#define		PRADC		1
+
+#define		SE			0
+
+#define		EXTRF		1
+#define		WDRF		3
+
+#endif // __SOLAR_HOST_AVR_IO_H__
@@ -0,0 +1,48 @@
+/*
+ * util/delay_basic.h (host build)
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below).
+ *
+ * Stand-in for the avr-libc busy-wait loops. Time does not pass in the host build, a WDT period
+ * is one call of the interrupt routine, so the delays simply return.
+ */
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+#ifndef __SOLAR_HOST_UTIL_DELAY_BASIC_H__
+#define __SOLAR_HOST_UTIL_DELAY_BASIC_H__
+
+#include <stdint.h>
+
+static inline void _delay_loop_1(uint8_t Count)
+{
+	(void)Count;
+}
+
+static inline void _delay_loop_2(uint16_t Count)
+{
+	(void)Count;
+}
+
+#endif // __SOLAR_HOST_UTIL_DELAY_BASIC_H__
@@ -22,8 +22,7 @@
  * The following defined constants will be useful to discover the pinning for your own hardware design:
  *   PORTB_LEDPWM_PIN  -- LED PWM Output (Slowly decreases brightness once the time-out is reached)
  *   PORTB_ENABLEBOOST_PIN  -- LED Boost Enable (switches hard on when PWM > 0%, hard off when PWM == 0%)
- *   PORTB_SENSOR_PIN  -- Sensor input (Analog Sensor pin)
- *   ADC_DIDR_SENSOR_PIN  -- ADC Sensor Channel Disable bit - Don't forget to change this when changing the sensor input.
+ *   PORTB_SENSOR_PIN  -- Sensor input (Analog Sensor pin, the ADC channel and input disable bit follow from it)
  * 
  * The following values will be useful to you when making a design with a different sensor or
  * supply voltage:
@@ -71,7 +70,7 @@
  *                      git-open@asmyldof.com
  */
 
-#ifndef __SOLAR_COUNTER_H__
+#ifndef __SOLAR_CONFIG_H__
 #define __SOLAR_CONFIG_H__
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -97,6 +96,7 @@
 											 // powered up, using more energy. While compared to 3W of lights
 											 // it's still negligible, you never know what might be using up your 
 											 // very last Wh of battery).
+											 // USE_WDT_DRIFT (below) measures the error instead.
 #define		TICKS_BEFORE_SAMPLE_NIGHT_PRODUCTION	15
 
 #define		USE_PRODUCTION			// Use this flag to switch between 	testing and production.	
@@ -107,12 +107,32 @@
  * 
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#define		NIGHT_INSTALL			// Setting this define will make the unit start a 120minute 
+//#define		NIGHT_INSTALL			// Setting this define will make the unit start a 120minute 
 								// night mode run after power-up, this is most useful when installing at night
 								// to see if all the lights are properly connected, plus during the day it'll turn 
 								// off after 30 minutes (defined number, can be changed).
+								// Takes the place of USE_COLD_START below. Note: this used to be set by default,
+								// since USE_COLD_START it is not, so a unit powered up in daylight no longer
+								// lights for NIGHT_INSTALL_TIMEOUT_MINUTES. Set it again for the old behaviour.
 #define		NIGHT_INSTALL_TIMEOUT_MINUTES	120
 
+#define		USE_COLD_START			// Setting this define takes a quick burst of sensor readings at power-up and
+								// starts from what they show: at night the light comes on at the first sample,
+								// at dusk after the usual night streak, and during the day the day is taken as
+								// confirmed. At night or dusk the first night doesn't wait for
+								// MINIMUM_DAY_BEFORE_NIGHT, during the day it waits COLD_START_GUARD_MINUTES, so a
+								// unit installed in the afternoon lights that night but a cloud right after
+								// power-up doesn't switch it on. The part of the first day that was missed is
+								// made up with COLD_START_DAY_MINUTES, the counted day is used if it is longer.
+#define		COLD_START_SAMPLES				8	// Readings in the burst, all of them have to agree for day or night
+#define		COLD_START_SPACING_MS			50	// Time between two of them, to ride out a flickering lamp nearby
+#define		COLD_START_DAY_MINUTES			720	// Day length assumed for the first night, like
+											 // MINIMUM_DAY_BEFORE_NIGHT. 12 hours, for an afterglow
+											 // of TICK_CONSTANT minus 360 ticks.
+#define		COLD_START_GUARD_MINUTES		120	// Day counted after a power-up in daylight before a night
+											 // streak can switch the light on, at most
+											 // MINIMUM_DAY_BEFORE_NIGHT (which waits the full day again).
+
 // Make the defined milivolts floating (by addind a trailing .0):
 #define		SUPPLY_VOLTAGE_MV				2500.0 // uC supply voltage in mV
 #define		DARK_THRESHOLD_MV				450.0 // Level in mV below which it 
@@ -152,6 +172,34 @@
 #define		AFTERGLOW_LIMITATION_PWM1		170 // PWM value when Threshold 1 is reached
 #define		AFTERGLOW_LIMITATION_PWM2		105 // PWM value when Threshold 2 is reached
 
+//#define		USE_FADE_ENGINE			// Setting this define moves all dimming to the Timer0 overflow interrupt:
+								// switching on, the limitation steps above and the fade-out at the end of the
+								// night all ramp one PWM count at a time, in real time, independent of the WDT
+								// period. The overflow interrupt is only enabled while a ramp is running.
+#define		FADE_STEP_MS					2000 // Time a full scale (0 to 255) ramp takes when switching on and
+											 // going to the limitation PWM values, smaller steps take less
+#define		FADE_OFF_SECONDS				600 // Time a full scale fade-out at the end of the night takes
+											 // (without the fade engine: OCR0_DECREASE_STEPSIZE per night WDT period)
+
+//#define		USE_DUSK_RAMP			// Setting this define makes the brightness follow the twilight: at the switch to
+								// night mode the sensor still sees light, and the duty starts at DUSK_START_PWM.
+								// It goes up in a straight line with every night sample to full (or to the
+								// limitation step the night is at) when the sensor reads DUSK_DARK_MV. Works
+								// the other way around too, when it gets lighter again with the light still on.
+#define		DUSK_DARK_MV					100.0 // Sensor level in mV from which it is fully dark, below DARK_THRESHOLD_MV
+#define		DUSK_START_PWM					85 // PWM value at DARK_THRESHOLD_MV
+
+//#define		USE_WDT_DRIFT			// Setting this define measures the WDT period against the calibrated system clock,
+								// once every lit night: Timer0 overflows are counted over one night WDT period
+								// while the PWM keeps the core in Idle anyway. The filtered result sets how many
+								// WDT ticks make up a sample, so the sample interval (and with it the day length
+								// and the switch-off time) stays put when the WDT oscillator drifts with
+								// temperature and supply voltage. TICKS_BEFORE_SAMPLE_* are then taken as exact,
+								// no need to tweak them per unit. Measures only when a limitation step (or a ramp
+								// or the dusk ramp) is dimming: at full brightness the timer stops in Power-Down.
+#define		WDT_DRIFT_FILTER_SHIFT			2 // Every measurement moves the correction 1/2^n of the way
+#define		WDT_DRIFT_LIMIT_PERCENT			30 // A measurement further off than this was disturbed, and is ignored
+
 #define		SLEEP_MODE						2 // Sleep mode select
 /*
 NOTE: All modes are available now, but when the PWM output is used by the code, it will automatically go to Idle to keep ClkIO on, to allow PWM
@@ -168,6 +216,7 @@ NOTE: All modes are available now, but when the PWM output is used by the code,
 1 - Internal WDT 128kHz oscillator
 2 - External Clock
 3 - Reserved (Will be reverted back to 8MHz)
+On the 8 pin parts the fuses select the source, this setting only has to match them (0 is 9.6MHz on the ATtiny13A)
 */											 
 #define		CLOCK_PRESCALER					4 // System Clock Prescaler
 /*
@@ -194,16 +243,22 @@ NOTE: All modes are available now, but when the PWM output is used by the code,
 7 - Ckio / 128
 any higher number is masked back to the above series.
 */
-#define		TIMER_PRESCALER					1 // Timer0 Prescaler
-/* Can be used in testing to decrease the PWM cycle to something more easily detectable
-0 - Timer Turned off
-1 - Ckio / 1
-2 - Ckio / 8
-3 - Ckio / 64
-4 - Ckio / 256
-5 - Ckio / 1024
-6 - External on T0, Falling Edge
-7 - External on T0, Rising Edge
+#define		PWM_FREQUENCY_HZ				1953 // LED PWM frequency
+//#define		PWM_PHASE_CORRECT				// Setting this define uses phase correct PWM in stead of fast PWM
+/* The Timer0 prescaler and TOP follow from the system clock above, taking the smallest prescaler
+that keeps TOP at 255 or below. The duty stays 8 bit: all PWM values in this file are out of 255 and
+are scaled to TOP at compile time, only OCR0_DECREASE_STEPSIZE is in timer counts (a lower TOP fades
+out sooner). TOP has to be at least 63, which limits the frequency to the clock / 64 (fast) or the
+clock / 126 (phase correct). 1953 at the 500kHz clock is TOP 255, the 8 bit mode of the original.
+A frequency that would need a TOP below 63 at its prescaler runs at the prescaler below it with TOP
+255 instead, somewhat faster: 1953 on the ATtiny13A's 600kHz clock becomes 2344.
+Fast PWM - Clock / (prescaler * (TOP + 1))
+Phase correct PWM - Clock / (prescaler * 2 * TOP), half the frequency at the same resolution,
+	with the pulses centered in the period
+The timer only takes a new duty at the end of a period in both modes, so a change never makes a runt
+pulse. SolarPwm.c on the host models the boost converter over the frequencies the clock can make,
+use it to pick this one for a converter. Lowering it saves switching losses, but below 1250Hz the
+flicker of a fully modulated LED is no longer low-risk (IEEE 1789).
 */
 
 /*
@@ -211,12 +266,15 @@ In the porprietary set up:
 PB0/ADC0 -> Sensor
 PB1/OC0B -> LED PWM
 PB2/CLKO -> Enable LED boost
+On the 8 pin parts (ATtiny13A/25/45/85, see SolarTarget.h) PB0 has no ADC, there the sensor goes to PB4/ADC2.
 */
+#if defined(__AVR_ATtiny10__)
 #define		PORTB_SENSOR_PIN		(1<<PORTB0)
+#else
+#define		PORTB_SENSOR_PIN		(1<<PORTB4)
+#endif
 #define		PORTB_LEDPWM_PIN		(1<<PORTB1) // Has to be one of the two PWM outputs
 #define		PORTB_ENABLEBOOST_PIN	(1<<PORTB2)
-#define		ADC_DIDR_SENSOR_PIN		(1<<ADC0D)
-#define		ADC_ADMUX				0x00			// TODO: Make this and the DIDRPIN tied to the Sensor pin definition through internals
 #define		INITIAL_OCR0			0x00			// OCR0 at startup
 #define		MAXIMUM_OCR0			0xFF			// In this version, stick to 8 bit
 #define		OCR0_DECREASE_STEPSIZE	2 // decrease by 2, so it'll dim over 10 minutes with a 4s WDT interval.
@@ -227,7 +285,137 @@ If it's not 10, then if it's not 9, it's set to 8.
 So any value not 9 or 10 will always be 8 bit.
 */
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Motion sensor (optional)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+//#define		USE_MOTION_SENSOR		// Setting this define adds a motion sensor input: while the light is on, a
+								// detection brings it to full brightness for MOTION_HOLD_SECONDS, after which it
+								// ramps back to the schedule (without USE_FADE_ENGINE OCR0_DECREASE_STEPSIZE per
+								// night WDT period, the step-downs of the schedule as well). The pin change
+								// interrupt wakes the core from any sleep mode and is off during the day.
+#define		PORTB_MOTION_PIN		(1<<PORTB3) // PB3 is the RESET pin on the ATtiny10, see PORTB_TELEMETRY_PIN
+//#define		MOTION_ACTIVE_LOW		// Set for sensors that pull the line low on detection (add a pull-up)
+#define		MOTION_HOLD_SECONDS		60 // Full brightness after the last detection, in steps of the night WDT period
+#define		MOTION_LIMITATION_PWM1	60 // Replace AFTERGLOW_LIMITATION_PWM1 and 2 with the motion sensor, the
+#define		MOTION_LIMITATION_PWM2	25 // schedule can run much dimmer when passers-by get full brightness
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Day length history (parts with EEPROM only)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#define		USE_EEPROM_HISTORY		// Setting this define makes the ATtiny13A/25/45/85 store the length of every
+								// full day in EEPROM. After a power cycle the first night then uses the last
+								// stored day length in stead of the part of the day it saw, and doesn't wait
+								// for MINIMUM_DAY_BEFORE_NIGHT. Ignored on the ATtiny10, which has no EEPROM.
+								// Use the brown-out detector fuse, a write at a collapsing supply can go wrong
+								// (the CRC will reject it, but the record is lost).
+#define		EEPROM_HISTORY_SLOTS	16 // Records of 4 bytes, written round-robin, one a day. With 16 slots
+									 // every cell sees a write every 16 days, 100k writes is over 4000 years.
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Solar midnight estimator (optional)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+//#define		USE_MIDNIGHT_ESTIMATOR	// Setting this define measures every night from the dusk edge (the start of the
+								// night streak) to the dawn edge (the start of the day streak that ends it). Both
+								// edges see the same threshold, so the middle of the night is solar midnight,
+								// whatever the season and without the bias of a cloudy morning in the day ticks.
+								// The light then switches off at MIDNIGHT_SWITCH_OFF_OFFSET from the estimate in
+								// stead of at TICK_CONSTANT minus the day ticks. The first night after power-up
+								// has no estimate yet, and uses the day ticks.
+#define		MIDNIGHT_SWITCH_OFF_OFFSET	-68 // Night ticks from solar midnight to the start of the switch-off,
+											 // negative is before. -68 switches off where TICK_CONSTANT does on
+											 // average: 23:15 to 0:20 in the middle of the Netherlands, where
+											 // solar midnight is near 0:40 (winter time). Solar midnight moves
+											 // 4 minutes per degree of longitude, move the offset with it.
+#define		MIDNIGHT_FILTER_SHIFT		1 // A new night weighs 1/2^SHIFT in the estimate, 0 takes the last night
+										 // as is. More filtering is steadier under changing cloud, but lags
+										 // behind the season by about 2^SHIFT - 1 nights.
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Pre-dawn light (optional, needs the solar midnight estimator)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+//#define		USE_PREDAWN_LIGHT		// Setting this define switches the light on again in the morning, for early
+								// commuters: PREDAWN_LEAD_MINUTES before the dawn the estimator expects from the
+								// length of recent nights. It goes off at daylight (PREDAWN_LIGHT_STREAK light
+								// samples) or after PREDAWN_MAXIMUM_MINUTES, whichever comes first. The unit stays
+								// in day mode throughout, so the day ticks count as they always do. When the
+								// evening light is still on at the start of the window, there is no morning light.
+#define		PREDAWN_LEAD_MINUTES	60 // Night ticks before the expected dawn edge to switch on
+#define		PREDAWN_MAXIMUM_MINUTES	90 // Night ticks after switching on to switch off at the latest
+#define		PREDAWN_LIGHT_STREAK	3 // Light samples (day samples, 2 minutes) since switching on that end it
+#define		PREDAWN_PWM				170 // PWM value of the morning light
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Lifetime statistics (optional)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+//#define		USE_LIFETIME_STATS		// Setting this define keeps a block of saturating counters in SRAM: nights lit,
+								// the last day lengths and afterglow, day streaks from light at night reset by
+								// MINIMUM_NIGHT_TO_RESET_DAY, dusks that didn't make it to night mode and warm resets. It sits at
+								// the top of the SRAM (STATS_ADDRESS, 0x57 on the ATtiny10 with the settings below) with the
+								// stack below it, is never cleared, so it survives anything but a power cycle, and starts
+								// with a magic and a version byte. Read the SRAM over TPI (the part is held in reset, that
+								// counts as a warm reset afterwards), or from a simulator, and decode it with SolarStats.c.
+#define		LIFETIME_STATS_COMPACT	// 8 bit counters, and day lengths and afterglow in units of 4 ticks: 9 bytes
+								// with one day length in stead of 13. Needed on the ATtiny10, where the block
+								// may take at most a third of the SRAM.
+#define		LIFETIME_STATS_DAYS		1 // Day lengths kept, newest first: 1 to 7
+#define		STATS_STACK_RESERVE		12 // Bytes of stack kept free between the globals and the block: the return
+								// addresses of main and an interrupt, SREG and the two fixed registers, and the
+								// working registers the interrupt saves. An estimate, check it against the .su
+								// files of an avr-gcc -fstack-usage build. On the ATtiny10 the default options
+								// leave 13, the fade engine, drift, motion and midnight options don't fit with it.
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Per-unit configuration block (optional)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+//#define		USE_UNIT_CONFIG_BLOCK	// Setting this define makes the firmware read TICK_CONSTANT, the thresholds, the
+								// TICKS_BEFORE_SAMPLE values and the afterglow limits from a 20 byte block at the
+								// end of the flash in stead of folding them in. The values above become the block
+								// defaults, SolarUnitConfig.c stamps a unit ID and other values per unit into the
+								// release HEX file. The linker needs:
+								//   -Wl,--section-start=.unitconfig=0x3ec -Wl,--undefined=UnitConfigDefaults
+								// where 0x3ec is UNIT_CONFIG_ADDRESS, the flash size minus 20, and the second
+								// flag keeps the block through --gc-sections. The ReleaseUnitConfig configuration
+								// of the ATtiny10 project sets both and defines this and UNIT_CONFIG_LINKED, the
+								// other configurations leave .unitconfig alone. Outside the project, define
+								// UNIT_CONFIG_LINKED next to the two flags to confirm they are there.
+								// The program then has 1004 bytes: past that the linker stops on overlapping
+								// sections, SolarUnitConfig.c prints how much of it a release HEX file uses.
+								// The firmware trusts the block, SolarUnitConfig.c checks the version and check
+								// byte before and after stamping. With USE_WDT_DRIFT the tick counts in the block
+								// are not used, and USE_DUSK_RAMP can't be combined with it.
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *
+ *  Telemetry (testing builds only)
+ *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+//#define		USE_TELEMETRY			// Setting this define makes a DEBUG build (USE_PRODUCTION not set) send a
+								// record of every sample over a bit-banged UART transmit, see SolarTelemetry.c
+								// on the host side for decoding. Production builds never contain any of it.
+#define		PORTB_TELEMETRY_PIN		(1<<PORTB3) // PB3 is the RESET pin: needs the RSTDISBL fuse, after which
+											 // the chip can only be reprogrammed with 12V on it.
+											 // Or share PORTB_ENABLEBOOST_PIN, with TELEMETRY_INVERTED set;
+											 // records are then only sent in day mode, and the boost enable
+											 // pulses along with the data.
+//#define		TELEMETRY_INVERTED		// Idle low, start bit high (set this when sharing the boost enable)
+#define		TELEMETRY_BAUD			9600 // 8N1. At 500kHz that is 52 cycles a bit, higher rates are possible
+											 // but need a good TELEMETRY_LOOP_CYCLES, check the frame on a scope.
+#define		TELEMETRY_LOOP_CYCLES	10 // Cycles per bit spent outside the delay loop, depends on the compiler
+#define		EXTERNAL_CLOCK_HZ		8000000 // Only used with SYSTEM_CLOCK set to external (2), for the bit timing
+
 
 
 
-#endif // __SOLAR_COUNTER_H__
\ No newline at end of file
+#endif // __SOLAR_CONFIG_H__
\ No newline at end of file
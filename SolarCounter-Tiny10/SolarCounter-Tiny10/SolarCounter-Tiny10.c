@@ -54,8 +54,7 @@
  * The following defined constants will be useful to discover the pinning for your own hardware design (inside SolarConfig.h):
  *   PORTB_LEDPWM_PIN  -- LED PWM Output (Slowly decreases brightness once the time-out is reached)
  *   PORTB_ENABLEBOOST_PIN  -- LED Boost Enable (switches hard on when PWM > 0%, hard off when PWM == 0%)
- *   PORTB_SENSOR_PIN  -- Sensor input (Analog Sensor pin)
- *   ADC_DIDR_SENSOR_PIN  -- ADC Sensor Channel Disable bit - Don't forget to change this when changing the sensor input.
+ *   PORTB_SENSOR_PIN  -- Sensor input (Analog Sensor pin, the ADC channel and input disable bit follow from it)
  * 
  * The following values will be useful to you when making a design with a different sensor or
  * supply voltage:
@@ -111,6 +110,20 @@
 #include "SolarConfig.h"
 #include "SolarCounter.h"
 
+#if defined(TELEMETRY_ENABLED) || defined(COLD_START_ENABLED)
+#include <util/delay_basic.h>
+#endif
+#ifdef		EEPROM_HISTORY_ENABLED
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#endif
+#ifdef		UNIT_CONFIG_ENABLED
+#include <stddef.h>
+#ifndef		TARGET_FLASH_MAPPED
+#include <avr/pgmspace.h>
+#endif
+#endif
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * 
  *  Local inline helper functions (see end of file):
@@ -120,6 +133,49 @@
 inline static void SwitchToDayMode();
 inline static void SwitchToNightMode();
 inline static bool IsSetToDayMode();
+#ifdef		FADE_ENGINE_ENABLED
+inline static void StartFade(uint8_t Target);
+#endif
+#ifdef		DUSK_RAMP_ENABLED
+inline static uint8_t NightDuty(uint16_t Count, uint8_t Sample);
+inline static void SetNightDuty(uint8_t Duty);
+#endif
+#ifdef		FULL_DUTY_LOAD_ENABLED
+inline static void SetFullDuty();
+#endif
+#ifdef		WDT_DRIFT_ENABLED
+inline static bool DriftIsRunning();
+inline static void RunDriftMeasurement();
+inline static uint8_t DriftCountDown(bool Day);
+#endif
+#ifdef		MOTION_SENSOR_ENABLED
+inline static bool IsMotionDetected();
+inline static uint8_t ScheduledDuty();
+inline static void EndMotionHold();
+#endif
+#ifdef		EEPROM_HISTORY_ENABLED
+inline static void RecallHistory();
+inline static void UpdateHistory();
+inline static void StoreHistory();
+#endif
+#ifdef		COLD_START_ENABLED
+inline static void ClassifyColdStart();
+#endif
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+inline static void RunMidnightClock();
+inline static void UpdateMidnightEstimate();
+inline static uint16_t MidnightDayTicks();
+#endif
+#ifdef		PREDAWN_LIGHT_ENABLED
+inline static void RunMorningLight();
+#endif
+#ifdef		LIFETIME_STATS_ENABLED
+inline static void StartStats();
+inline static void CountNight(uint16_t DayTicks);
+#endif
+#ifdef		TELEMETRY_ENABLED
+inline static void SendTelemetry(uint8_t Sample);
+#endif
 
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -137,12 +193,124 @@ uint8_t		OperationalFlags; // Flag Register
 uint16_t	TicksLimitPWM1;	// Flexible Limit Counter for the first threshold
 uint16_t	TicksLimitPWM2;	// Flexible Limit Counter for the second threshold
 
+#ifdef		FADE_ENGINE_ENABLED
+uint8_t		LightTarget;	// PWM value the fade engine is ramping towards
+uint16_t	FadeCountDown;	// Timer0 overflows left until the next PWM step (post-scaler)
+#endif
+
+#ifdef		WDT_DRIFT_ENABLED
+uint16_t	DriftOverflows;	// Timer0 overflows counted so far plus one, or WDT_DRIFT_OFF/ARMED
+uint16_t	DriftPeriod;	// Filtered Timer0 overflows in a night WDT period
+uint16_t	DriftCarry;		// Overflows the last sample came late, taken off the next interval
+#endif
+
+#ifdef		MOTION_SENSOR_ENABLED
+uint16_t	MotionHold;		// Night WDT periods left at full brightness after the last detection
+#endif
+
+#ifdef		EEPROM_HISTORY_ENABLED
+typedef struct
+{
+	uint8_t		Sequence;		// Counts up with every write, the highest (modulo 256) is the newest
+	uint16_t	DayTicks;		// Ticks at the switch to night mode after a full day
+	uint8_t		Crc;			// CRC-8 of the three bytes above
+} HistoryRecord;
+
+HistoryRecord	EEMEM History[EEPROM_HISTORY_SLOTS];
+
+uint16_t	RecalledDayTicks;	// Newest day length in the history at power-up, 0 if there was none
+uint8_t		HistorySlot;		// Slot the next record goes into
+uint8_t		HistorySequence;	// And its sequence number
+uint16_t	HistoryPending;		// Day length the ADC interrupt left for the main loop to store, 0 when none
+#endif
+
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+uint16_t	DarkTicks;			// Time since the dusk edge in night samples, 0 when not measuring a night
+uint16_t	MidnightPhase;		// Time since the estimated solar midnight in night samples, modulo a day
+#endif
+#ifdef		PREDAWN_LIGHT_ENABLED
+uint16_t	HalfNight;			// Filtered half of the dark interval, expected dawn is this long after solar midnight
+#endif
+
+#ifdef		LIFETIME_STATS_ENABLED
+#if (STATS_COUNTER_BYTES == 1)
+typedef uint8_t		StatsCounter;
+#else
+typedef uint16_t	StatsCounter;
+#endif
+// All counters saturate, the tick values are shifted down by STATS_TICKS_SHIFT and saturate as well:
+typedef struct
+{
+	uint8_t			Magic;			// STATS_MAGIC, anything else means the SRAM lost power
+	uint8_t			Version;		// STATS_VERSION, another one is the block of another build
+	uint16_t		NightsLit;		// Switches to night mode
+	StatsCounter	DayResets;		// Day streaks from light samples at night, reset by MINIMUM_NIGHT_TO_RESET_DAY dark ones
+	StatsCounter	AbortedDusks;	// Night streaks in day mode that a light sample ended
+	StatsCounter	Afterglow;		// Night ticks the last night started with
+	StatsCounter	DayTicks[LIFETIME_STATS_DAYS];	// Day ticks seen before the last nights, newest first
+	uint8_t			WarmResets;		// Start-ups that found the block intact (last, so no field needs padding on a host)
+} LifetimeStatsBlock;
+
+// Not a linker placed variable: it sits at STATS_ADDRESS, so readers find it without a map file, and is not
+// cleared at start-up, see StartStats() and StackBelowStats():
+#define		LifetimeStats		DATA_AT(LifetimeStatsBlock, STATS_ADDRESS)
+#endif
+
+#ifdef		UNIT_CONFIG_ENABLED
+// Fixed layout, no padding on any compiler: SolarUnitConfig.c on the host uses the same struct.
+typedef struct
+{
+	uint8_t		Magic;					// UNIT_CONFIG_MAGIC, the low nibble is the layout version
+	uint8_t		TicksBeforeSampleDay;
+	uint16_t	UnitId;					// 0 in the release build, stamped per unit
+	uint16_t	TickConstant;
+	uint16_t	MinimumAfterglow;
+	uint16_t	MaximumAfterglow;
+	uint16_t	LimitationThreshold1;	// Already swapped, 1 is the lower one
+	uint16_t	LimitationThreshold2;
+	uint8_t		TicksBeforeSampleNight;
+	uint8_t		DarkThreshold;
+	uint8_t		LightThreshold;
+	uint8_t		LimitationPwm1;
+	uint8_t		LimitationPwm2;
+	uint8_t		Check;					// Makes the byte sum of the whole block 0 (modulo 256)
+} UnitConfigBlock;
+
+STATIC_ASSERT(sizeof(UnitConfigBlock) == UNIT_CONFIG_BYTES, "UnitConfigBlock layout changed, update UNIT_CONFIG_BYTES and SolarUnitConfig.c");
+
+#define		UNIT_CONFIG_SUM2(Word)		(((Word) & 0xFF) + (((Word) >> 8) & 0xFF))
+
+// The release defaults, the linker puts these at UNIT_CONFIG_ADDRESS. Nothing refers to the object
+// itself (all reads go through the address), the code can't fold them in by accident:
+const UnitConfigBlock	UnitConfigDefaults __attribute__((section(".unitconfig"), used)) =
+{
+	UNIT_CONFIG_MAGIC,
+	TICKS_BEFORE_SAMPLE_DAY,
+	0,
+	TICK_CONSTANT,
+	MINIMUM_AFTERGLOW_MINUTES,
+	MAXIMUM_AFTERGLOW_MINUTES,
+	AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL,
+	AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL,
+	TICKS_BEFORE_SAMPLE_NIGHT,
+	DARK_THRESHOLD,
+	LIGHT_THRESHOLD,
+	AFTERGLOW_LIMITATION_PWM1_INTERNAL,
+	AFTERGLOW_LIMITATION_PWM2_INTERNAL,
+	(uint8_t)(0 - (UNIT_CONFIG_MAGIC + TICKS_BEFORE_SAMPLE_DAY + TICKS_BEFORE_SAMPLE_NIGHT
+		+ UNIT_CONFIG_SUM2(TICK_CONSTANT) + UNIT_CONFIG_SUM2(MINIMUM_AFTERGLOW_MINUTES) + UNIT_CONFIG_SUM2(MAXIMUM_AFTERGLOW_MINUTES)
+		+ UNIT_CONFIG_SUM2(AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL) + UNIT_CONFIG_SUM2(AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL)
+		+ DARK_THRESHOLD + LIGHT_THRESHOLD + AFTERGLOW_LIMITATION_PWM1_INTERNAL + AFTERGLOW_LIMITATION_PWM2_INTERNAL))
+};
+#endif
+
 int main(void)
 {
 	// Disable the power to the Analog Comparator:
 	ACSR = ACSR_INTERNAL;
 	
 	// Set protected registers, if required:
+#ifdef		TARGET_CLOCK_BY_SOFTWARE
 #if (SYSTEM_CLOCK_INTERNAL != 0) // If not the default
 #warning "Reconfiguring the system clock source. Please make sure this is intended."
 	// Set Clock System
@@ -158,31 +326,66 @@ int main(void)
 	// Set Prescaler
 	CLKPSR = CLOCK_PRESCALER_INTERNAL;
 #endif
+#else // TARGET_CLOCK_BY_SOFTWARE
+	// The 8 pin parts: source from the fuses, the start-up prescaler depends on the CKDIV8 fuse, so always set it.
+	// A watchdog reset flag forces WDE on, so clear it before the WDT gets configured:
+	MCUSR = 0x00;
+	CLKPR = (1<<CLKPCE);
+	CLKPR = CLOCK_PRESCALER_INTERNAL;
+#endif // TARGET_CLOCK_BY_SOFTWARE
 	
 	PORTB = INITIAL_PORTB;
 	DDRB = INITIAL_DDRB;
 	DIDR0 = INITIAL_DIDR0;
 	ADMUX = ADC_ADMUX;
+#ifdef		MOTION_SENSOR_ENABLED
+	PCMSK = PCMSK_MOTION_PIN; // Only enabled in night mode, see SwitchToNightMode()
+#endif
+#ifdef		LIFETIME_STATS_ENABLED
+	StartStats();
+#endif
 	
 	NightStreak = 0;
 	DayStreak = 0;
 	
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+	DarkTicks = 0;
+	MidnightPhase = MIDNIGHT_PHASE_UNKNOWN; // No clock until the first full night has been seen
+#endif
+#ifdef		PREDAWN_LIGHT_ENABLED
+	HalfNight = 0;
+#endif
+	
 	TicksLimitPWM1 = 0;
 	TicksLimitPWM2 = 0;
 	
+#ifdef		WDT_DRIFT_ENABLED
+	DriftPeriod = WDT_DRIFT_NOMINAL; // Until the first night says otherwise
+	DriftCarry = 0;
+#endif
+	
+#ifdef		EEPROM_HISTORY_ENABLED
+	RecallHistory();
+	HistoryPending = 0;
+	OperationalFlags |= FLAG_FIRST_DAY; // Whatever we count today, it started at power-up
+#endif
+	
 #ifdef	NIGHT_INSTALL
-	SMCR = SMCR_INTERNAL_AT_PWM;
+	SLEEP_CONTROL_REGISTER = SMCR_INTERNAL_AT_PWM;
 	
 	SwitchToNightMode();
 	OperationalFlags &= ~FLAG_LASTMODE_WAS_DAY;
 	Ticks = NIGHT_INSTALL_TIMEOUT_MINUTES;
-	WDT_CountDown = TICKS_BEFORE_SAMPLE_NIGHT; // Counting down in the WDT interrupt: Pre-load!
+	WDT_CountDown = CFG_TICKS_BEFORE_SAMPLE_NIGHT; // Counting down in the WDT interrupt: Pre-load!
 #else	
-	SMCR = SMCR_INTERNAL_LOWEST_ALLOWED;
+	SLEEP_CONTROL_REGISTER = SMCR_INTERNAL_LOWEST_ALLOWED;
 	
 	SwitchToDayMode();
 	Ticks = 0; // Make sure we start at 0 ticks, since that's safest.
-	WDT_CountDown = TICKS_BEFORE_SAMPLE_DAY; // Counting down in the WDT interrupt: Pre-load!
+	WDT_CountDown = CFG_TICKS_BEFORE_SAMPLE_DAY; // Counting down in the WDT interrupt: Pre-load!
+#ifdef		COLD_START_ENABLED
+	ClassifyColdStart(); // Day, dusk or night: seeds the streaks, flags and first sample from what the sensor sees
+#endif
 #endif
 	
 	sei(); // Enable interrupts (very important!)
@@ -195,13 +398,18 @@ int main(void)
 			// We have to enter sleep here, to avoid interrupt collisions when waking up
 			OperationalFlags &= ~FLAG_SET_SLEEP;
 			
+#ifdef		EEPROM_HISTORY_ENABLED
+			if( HistoryPending != 0 )
+				StoreHistory(); // Out here the interrupts keep running while the EEPROM writes
+#endif
+			
 #ifndef		SMCR_UNDIFFERENTIATED
 			// This block is only compiled when the two sleep modes are different, as predicated by the 
 			//    "SMCR_UNDIFFERENTIATED" flag, conditionally defined in SolarCounter.h
 			if( (OperationalFlags & FLAG_PWM_OPERATONAL) != FLAG_PWM_OPERATONAL ) // If we are not lighting, we can go to any sleep mode:
-				SMCR = SMCR_INTERNAL_LOWEST_ALLOWED;
+				SLEEP_CONTROL_REGISTER = SMCR_INTERNAL_LOWEST_ALLOWED;
 			else // Else we need to go to a PWM safe mode:
-				SMCR = SMCR_INTERNAL_AT_PWM;
+				SLEEP_CONTROL_REGISTER = SMCR_INTERNAL_AT_PWM;
 #endif
 			
 			sleep_cpu();
@@ -220,13 +428,16 @@ int main(void)
 */
 ISR(WDT_vect)
 {
+#ifndef		FADE_ENGINE_ENABLED
 	uint8_t	Temp;
+#endif
 	
 	/* Count a tick. If tick limit is reached, trigger ADC. Use ticks by decrement
 	   to create more efficient code */
 	/* if night mode end flag is set, decrease OCR0 output, when 0 switch to day
 	   count mode */
 	
+#ifndef		FADE_ENGINE_ENABLED // With the fade engine the slow turn-off runs in the Timer0 overflow
 	if( (OperationalFlags & FLAG_SLOWTURNOFF) == FLAG_SLOWTURNOFF )
 	{
 		//TODO: Make compatible with higher resolution PWM
@@ -243,22 +454,48 @@ ISR(WDT_vect)
 		else
 		{ // If we haven't reached the end of dimming yet; decrease the PWM value by 1 defined step size:
 			Temp -= OCR0_DECREASE_STEPSIZE; 
-			OCR0OUT_REGISTER_HIGH = 0; //TODO: Make compatible with higher resolution PWM
-			OCR0OUT_REGISTER_LOW = Temp;
+			SET_OCR0OUT(Temp);
 		}
 	}
+#endif // FADE_ENGINE_ENABLED
+	
+#ifdef		MOTION_SENSOR_ENABLED
+	if( MotionHold != 0 )
+	{
+		if( IsMotionDetected() )
+			MotionHold = MOTION_HOLD_PERIODS; // Still someone there, keep the hold going
+#ifdef		FADE_ENGINE_ENABLED
+		else if( --MotionHold == 0 )
+			EndMotionHold();
+	}
+#else
+		else
+			MotionHold--;
+	}
+	else
+		EndMotionHold(); // A step per WDT period back to the schedule, like the slow turn-off
+#endif
+#endif
+	
+#ifdef		WDT_DRIFT_ENABLED
+	RunDriftMeasurement();
+#endif
 	
 	// We don't care about WDT Reset Safety (see datasheet), so we can just re-enable here:
-	WDTCSR |= (1<<WDIE);
+	WDT_CONTROL_REGISTER |= (1<<WDT_INTERRUPT_ENABLE);
 	
 	// In all cases: continue running the ADC module to sample day or night to determine further action
 	WDT_CountDown--;
 	if(WDT_CountDown == 0)
 	{ // This little bit is a small post-scaler of course, allowing a 1 or 2 minute interval.
+#ifdef		WDT_DRIFT_ENABLED
+		WDT_CountDown = DriftCountDown(IsSetToDayMode());
+#else
 		if( IsSetToDayMode() )
-			WDT_CountDown = TICKS_BEFORE_SAMPLE_DAY;
+			WDT_CountDown = CFG_TICKS_BEFORE_SAMPLE_DAY;
 		else
-			WDT_CountDown = TICKS_BEFORE_SAMPLE_NIGHT;
+			WDT_CountDown = CFG_TICKS_BEFORE_SAMPLE_NIGHT;
+#endif
 		
 		ADCSRA = ADCSRA_START;
 	}
@@ -302,16 +539,28 @@ ISR(ADC_vect)
 							if( tick == 0 )
 								set decrease flag
 	*/						
-	Temp = ADCL;
+	Temp = ADC_RESULT_REGISTER;
 	
-	if( Temp > LIGHT_THRESHOLD )
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+	RunMidnightClock(); // Before anything below switches modes, it needs the mode this sample was taken in
+#endif
+	
+	if( Temp > CFG_LIGHT_THRESHOLD )
 	{ // When Day:
 		Ticks++; // count a tick
+#ifdef		LIFETIME_STATS_ENABLED
+		if( (NightStreak != 0) && ((OperationalFlags & (FLAG_LIGHTISON | FLAG_LASTMODE_WAS_DAY)) == FLAG_LASTMODE_WAS_DAY) )
+			STATS_INCREMENT(LifetimeStats.AbortedDusks); // A dusk that turned out to be a cloud
+#endif
 		NightStreak = 0; // reset night streak
 		
 		DayStreak++; // add day streak
 		if( DayStreak >= MINIMUM_DAY_STREAK )
 		{
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+			if( DarkTicks != 0 )
+				UpdateMidnightEstimate(); // The day streak confirmed the dawn edge, the night is complete
+#endif
 			// switch to day mode
 			SwitchToDayMode();
 			OperationalFlags |= FLAG_LASTMODE_WAS_DAY; // Set previous mode to day, so night mode can be triggered
@@ -320,7 +569,7 @@ ISR(ADC_vect)
 		}
 		
 	}
-	else if( Temp < DARK_THRESHOLD )
+	else if( Temp < CFG_DARK_THRESHOLD )
 	{ // When night:
 		//DayStreak = 0; // reset day streak
 		if( (OperationalFlags & FLAG_LIGHTISON) != FLAG_LIGHTISON )
@@ -331,38 +580,81 @@ ISR(ADC_vect)
 			if( (OperationalFlags & FLAG_LASTMODE_WAS_DAY) == FLAG_LASTMODE_WAS_DAY)
 			{
 				NightStreak++; 
+#if defined(EEPROM_HISTORY_ENABLED) && !defined(COLD_START_ENABLED)
+				// After power-up the history vouches for the day length, so don't wait for plenty Ticks:
+				if( (NightStreak >= MINIMUM_NIGHT_STREAK) && ((Ticks >= MINIMUM_DAY_BEFORE_NIGHT_INTERNAL) || (RecalledDayTicks != 0)) )
+#else // The cold start seeded Ticks for the first day, see ClassifyColdStart()
 				if( (NightStreak >= MINIMUM_NIGHT_STREAK) && (Ticks >= MINIMUM_DAY_BEFORE_NIGHT_INTERNAL) )
+#endif
 				{ // If the nightstreak is long enough and there were plenty Ticks:
-										
-					if(Ticks >= TICK_CONSTANT)
+					
+#ifdef		COLD_START_ENABLED
+					if( (OperationalFlags & FLAG_FIRST_DAY) == FLAG_FIRST_DAY )
+					{ // Take the seed off, so what the first day counted is left, see ClassifyColdStart()
+						if( Ticks >= COLD_START_GATE_OPEN )
+							Ticks -= COLD_START_GATE_OPEN;
+						else
+							Ticks -= MINIMUM_DAY_BEFORE_NIGHT_INTERNAL - COLD_START_GUARD_TICKS;
+					}
+#endif
+#ifdef		LIFETIME_STATS_ENABLED
+					CountNight(Ticks); // What the day measured, before anything below replaces it
+#endif
+#ifdef		EEPROM_HISTORY_ENABLED
+					UpdateHistory(); // Store a full day, or put the recalled one in Ticks on the first day
+#elif defined(COLD_START_ENABLED)
+					if( (OperationalFlags & FLAG_FIRST_DAY) == FLAG_FIRST_DAY )
+					{ // Only part of the first day was counted, make it up to at least the assumed one
+						OperationalFlags &= ~FLAG_FIRST_DAY;
+						if( Ticks < COLD_START_DAY_TICKS )
+							Ticks = COLD_START_DAY_TICKS;
+					}
+#endif
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+					if( MidnightPhase != MIDNIGHT_PHASE_UNKNOWN )
+						Ticks = MidnightDayTicks(); // The day ticks that make the count-down below end where the estimate says
+					DarkTicks = MIDNIGHT_DUSK_TICKS; // Start measuring this night, from the start of the night streak
+#endif
+					
+					if(Ticks >= CFG_TICK_CONSTANT)
 					{
-						Ticks = MINIMUM_AFTERGLOW_MINUTES; // Cap the calculation to prevent overruns
+						Ticks = CFG_MINIMUM_AFTERGLOW; // Cap the calculation to prevent overruns
 					}
 					else
 					{
-						Ticks = TICK_CONSTANT - Ticks; // Calculate the night-ticks.
+						Ticks = CFG_TICK_CONSTANT - Ticks; // Calculate the night-ticks.
 						
-						if(Ticks < MINIMUM_AFTERGLOW_MINUTES)
+						if(Ticks < CFG_MINIMUM_AFTERGLOW)
 						{
-							Ticks = MINIMUM_AFTERGLOW_MINUTES; // Again cap to minimum
+							Ticks = CFG_MINIMUM_AFTERGLOW; // Again cap to minimum
 						}
-						else if(Ticks > MAXIMUM_AFTERGLOW_MINUTES)
+						else if(Ticks > CFG_MAXIMUM_AFTERGLOW)
 						{
-							Ticks = MAXIMUM_AFTERGLOW_MINUTES; // And cap to a maximum
+							Ticks = CFG_MAXIMUM_AFTERGLOW; // And cap to a maximum
 						}
 						
-						if(Ticks > AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL)
-							TicksLimitPWM1 = Ticks - AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL;
+#ifdef		AFTERGLOW_STEP1_ENABLED
+						if(Ticks > CFG_LIMITATION_THRESHOLD1)
+							TicksLimitPWM1 = Ticks - CFG_LIMITATION_THRESHOLD1;
 						else
 							TicksLimitPWM1 = 0;
+#endif
 							
-						if(Ticks > AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL)
-							TicksLimitPWM2 = Ticks - AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL;
+#ifdef		AFTERGLOW_STEP2_ENABLED
+						if(Ticks > CFG_LIMITATION_THRESHOLD2)
+							TicksLimitPWM2 = Ticks - CFG_LIMITATION_THRESHOLD2;
 						else
 							TicksLimitPWM2 = 0;
+#endif
 					}
 					
+#ifdef		LIFETIME_STATS_ENABLED
+					LifetimeStats.Afterglow = STATS_TICKS(Ticks);
+#endif
 					SwitchToNightMode();
+#ifdef		DUSK_RAMP_ENABLED
+					SetNightDuty(NightDuty(Ticks, Temp)); // Start at what the twilight calls for
+#endif
 					OperationalFlags &= ~FLAG_LASTMODE_WAS_DAY; // make sure we don't re-trigger.
 					NightStreak = 0;
 				}
@@ -379,47 +671,196 @@ ISR(ADC_vect)
 				{
 					NightStreak = 0;
 					DayStreak = 0;
+#ifdef		LIFETIME_STATS_ENABLED
+					// The first one, right after dusk, is the streak left over from the afternoon: routine
+					if( STATS_TICKS(Ticks + MINIMUM_NIGHT_TO_RESET_DAY) != LifetimeStats.Afterglow )
+						STATS_INCREMENT(LifetimeStats.DayResets);
+#endif
 				}
 			}
 			
-			if( Ticks < TicksLimitPWM2 )
+#ifdef		MOTION_SENSOR_ENABLED
+			if( MotionHold != 0 )
+			{
+				// Someone passed by: stay at full brightness, the WDT interrupt goes back to the steps below
+			}
+#ifndef		FADE_ENGINE_ENABLED
+			else if( OCR0OUT_REGISTER_LOW > ScheduledDuty() )
+			{
+				// Back from a hold, or down to the next step: EndMotionHold() ramps it in the WDT interrupt
+			}
+#endif
+			else
+#endif
+#ifdef		DUSK_RAMP_ENABLED
+			SetNightDuty(NightDuty(Ticks, Temp)); // The step the night is at, or less while there's twilight
+#else
+			if( AFTERGLOW_STEP2_REACHED(Ticks) )
 			{ // This one will trigger last (because of processing in SolarCounter.h it will be the longest time-out)
+#ifdef		FADE_ENGINE_ENABLED
+				StartFade(CFG_LIMITATION_PWM2); // ramp to decreased intensity.
+#else
 				OperationalFlags |= FLAG_PWM_OPERATONAL; // enable PWM decreased intensity.
-				OCR0OUT_REGISTER_HIGH = 0; //TODO: Make compatible with higher resolution PWM
-				OCR0OUT_REGISTER_LOW = AFTERGLOW_LIMITATION_PWM2_INTERNAL;
+				SET_OCR0OUT(CFG_LIMITATION_PWM2);
+#endif
 			}
-			else if( Ticks < TicksLimitPWM1 )
+			else if( AFTERGLOW_STEP1_REACHED(Ticks) )
 			{
+#ifdef		FADE_ENGINE_ENABLED
+				StartFade(CFG_LIMITATION_PWM1);
+#else
 				OperationalFlags |= FLAG_PWM_OPERATONAL; // enable PWM decreased intensity.
-				OCR0OUT_REGISTER_HIGH = 0; //TODO: Make compatible with higher resolution PWM
-				OCR0OUT_REGISTER_LOW = AFTERGLOW_LIMITATION_PWM1_INTERNAL;
+				SET_OCR0OUT(CFG_LIMITATION_PWM1);
+#endif
 			}
+#endif // DUSK_RAMP_ENABLED
 			
 			if( Ticks == 0 )
 			{
 				OperationalFlags &= ~FLAG_LIGHTISON; // prevent "light on" events from triggering
 				OperationalFlags |= (FLAG_SLOWTURNOFF | FLAG_PWM_OPERATONAL); // enable PWM slow decrease.
+#ifdef		MOTION_SENSOR_ENABLED
+				MotionHold = 0; // The fade-out starts from wherever the light is
+#endif
+#ifdef		FADE_ENGINE_ENABLED
+				StartFade(0); // Fade out, the overflow interrupt switches to day mode at 0
+#endif
 			}
 		}
 	}
 	
+#ifdef		PREDAWN_LIGHT_ENABLED
+	RunMorningLight(); // After the day streak has seen this sample
+#endif
+	
+#ifdef		TELEMETRY_ENABLED
+	SendTelemetry(Temp);
+#endif
+	
 	// When the ADC is done, go into sleep (since the WDT will interrupt it again:
 	OperationalFlags |= FLAG_SET_SLEEP;
 }
 
+#if defined(FADE_ENGINE_ENABLED) || defined(WDT_DRIFT_ENABLED) || defined(FULL_DUTY_LOAD_ENABLED)
+/*
+  Timer0 overflow interrupt: the fade engine. Only enabled while a ramp is running, which means
+  the core is in Idle for the PWM anyway. FadeCountDown post-scales the overflow rate (the PWM frequency) down
+  to one PWM count per step, so a ramp takes the same real time whatever the WDT period is.
+  The WDT drift measurement counts the overflows of one WDT period here, never along with a ramp.
+  Without the fade engine one overflow tells SetFullDuty() the new duty is loaded.
+*/
+ISR(TIM0_OVF_vect)
+{
+#ifdef		FADE_ENGINE_ENABLED
+	uint8_t	Temp;
+#endif
+	
+#ifdef		WDT_DRIFT_ENABLED
+	if( DriftIsRunning() )
+		DriftOverflows++;
+#ifdef		FADE_ENGINE_ENABLED
+	else
+#endif
+#endif
+#ifdef		FADE_ENGINE_ENABLED
+	if( --FadeCountDown == 0 )
+	{
+		Temp = OCR0OUT_REGISTER_LOW;
+		if( Temp != LightTarget )
+		{
+			if( Temp < LightTarget )
+				Temp++;
+			else
+				Temp--;
+			SET_OCR0OUT(Temp);
+			
+			if( Temp == LightTarget )
+				FadeCountDown = 1; // One more overflow, by then Timer0 has loaded the last step
+			else if( (OperationalFlags & FLAG_SLOWTURNOFF) == FLAG_SLOWTURNOFF )
+				FadeCountDown = FADE_OFF_OVERFLOWS;
+			else
+				FadeCountDown = FADE_STEP_OVERFLOWS;
+		}
+		else
+		{ // Ramp done, stop waking up on every overflow:
+			TIMER0_INT_MASK_REGISTER = 0x00;
+			if( (OperationalFlags & FLAG_SLOWTURNOFF) == FLAG_SLOWTURNOFF )
+			{ // End of the fade-out, same as the end of the slow turn-off without the fade engine
+				SwitchToDayMode();
+				Ticks = 0;
+			}
+			else if( Temp == MAXIMUM_OCR0L_INTERNAL )
+			{ // Full brightness is a constant high output, the timer doesn't need to keep running
+				OperationalFlags &= ~FLAG_PWM_OPERATONAL;
+			}
+		}
+	}
+#endif // FADE_ENGINE_ENABLED
+	
+#ifdef		FULL_DUTY_LOAD_ENABLED
+	// The period has ended, so Timer0 has loaded OCR0x. At full brightness that's a constant high
+	// output, which Power-Down can't freeze halfway (the slow turn-off starts from full, it keeps Idle):
+#ifdef		WDT_DRIFT_ENABLED
+	if( !DriftIsRunning() )
+#endif
+		TIMER0_INT_MASK_REGISTER = 0x00;
+	if( (OCR0OUT_REGISTER_LOW == MAXIMUM_OCR0L_INTERNAL) && ((OperationalFlags & FLAG_SLOWTURNOFF) == 0) )
+		OperationalFlags &= ~FLAG_PWM_OPERATONAL;
+#endif
+	
+	// Back to sleep through the main routine, unless an ADC conversion is running that the
+	// deeper sleep modes would stop (the ADC interrupt will set the flag when it's done):
+	if( (ADCSRA & (1<<ADSC)) == 0 )
+		OperationalFlags |= FLAG_SET_SLEEP;
+}
+#endif // FADE_ENGINE_ENABLED || WDT_DRIFT_ENABLED || FULL_DUTY_LOAD_ENABLED
+
+#ifdef		MOTION_SENSOR_ENABLED
+/*
+  Pin change interrupt: the motion sensor, only enabled in night mode. It wakes the core from
+  any sleep mode, but leaves Ticks and WDT_CountDown alone, so the sampling runs on undisturbed.
+  Once the light is counting down to off (LIGHTISON cleared) detections are ignored.
+*/
+ISR(PCINT0_vect)
+{
+	if( IsMotionDetected() && ((OperationalFlags & FLAG_LIGHTISON) == FLAG_LIGHTISON) )
+	{
+		MotionHold = MOTION_HOLD_PERIODS;
+#ifdef		FADE_ENGINE_ENABLED
+		StartFade(MAXIMUM_OCR0L_INTERNAL);
+#else
+		SetFullDuty();
+#endif
+	}
+	
+	// Back to sleep, unless this came in while the ADC is converting (see TIM0_OVF_vect):
+	if( (ADCSRA & (1<<ADSC)) == 0 )
+		OperationalFlags |= FLAG_SET_SLEEP;
+}
+#endif // MOTION_SENSOR_ENABLED
+
 // helper function: Switch to day mode: Turn off lights, set timer to power saving, set WDT sampling to day interval
 inline static void SwitchToDayMode()
 {
 	TCCR0B = 0x00; // turn timer off
 	TCCR0A = 0x00; // turn timer off
-	OCR0OUT_REGISTER_HIGH = INITIAL_OCR0H_INTERNAL;
-	OCR0OUT_REGISTER_LOW = INITIAL_OCR0L_INTERNAL;
+#if defined(FADE_ENGINE_ENABLED) || defined(WDT_DRIFT_ENABLED) || defined(FULL_DUTY_LOAD_ENABLED)
+	TIMER0_INT_MASK_REGISTER = 0x00; // and stop any ramp or measurement that was running
+#endif
+#ifdef		WDT_DRIFT_ENABLED
+	DriftOverflows = WDT_DRIFT_OFF;
+#endif
+	SET_OCR0OUT(INITIAL_OCR0L_INTERNAL);
 	PORTB &= ~PORTB_ENABLEBOOST_PIN; // turn off the booster 
-	WDTCSR = WDTCR_VALUE_DAY; // switch to day interval
+	WDT_WRITE(WDTCR_VALUE_DAY); // switch to day interval
 	PRR |= PRR_TIMEROFF; // Turn off the timer module to save energy when in day mode.
 	// Switching off all lighting operations, means setting the flags to false as well:
-	OperationalFlags &= ~(FLAG_SLOWTURNOFF | FLAG_LIGHTISON | FLAG_PWM_OPERATONAL);
+	OperationalFlags &= ~(FLAG_SLOWTURNOFF | FLAG_LIGHTISON | FLAG_PWM_OPERATONAL | FLAG_MORNING_LIGHT);
 	OperationalFlags |= FLAG_RUNNING_DAY;
+#ifdef		MOTION_SENSOR_ENABLED
+	PIN_CHANGE_CONTROL_REGISTER &= ~PIN_CHANGE_ENABLE; // No wake-ups from passers-by during the day
+	MotionHold = 0;
+#endif
 }
 
 // helper function: Switch to night mode: Turn on lights, enable timer, set WDT sampling to night interval
@@ -427,13 +868,27 @@ inline static void SwitchToNightMode()
 {
 	PRR &= ~PRR_TIMEROFF; // Turn on the timer module to enable PWM.
 	PORTB |= PORTB_ENABLEBOOST_PIN; // turn on LED boost
-	WDTCSR = WDTCR_VALUE_NIGHT; // switch to night interval
-	OCR0OUT_REGISTER_HIGH = MAXIMUM_OCR0H_INTERNAL;
-	OCR0OUT_REGISTER_LOW = MAXIMUM_OCR0L_INTERNAL;
+	WDT_WRITE(WDTCR_VALUE_NIGHT); // switch to night interval
+#ifdef		FADE_ENGINE_ENABLED
+	SET_OCR0OUT(0); // Start dark, the fade engine ramps up to full
+#else
+	SET_OCR0OUT(MAXIMUM_OCR0L_INTERNAL);
+#endif
+	SET_PWM_TOP(); // Only when PWM_FREQUENCY_HZ needs a TOP other than 0xFF
 	TCCR0B = TCCR0B_INTERNAL; // Enable timer functionality
 	TCCR0A = TCCR0A_INTERNAL;
 	OperationalFlags &= ~(FLAG_SLOWTURNOFF | FLAG_RUNNING_DAY); // No slow turn off, since we just started night mode
 	OperationalFlags |= FLAG_LIGHTISON; // Set light on flag in the flagbyte
+#ifdef		WDT_DRIFT_ENABLED
+	DriftOverflows = WDT_DRIFT_ARMED; // Measure once tonight
+#endif
+#ifdef		MOTION_SENSOR_ENABLED
+	PIN_CHANGE_FLAG_REGISTER = PIN_CHANGE_FLAG; // Forget about anything that moved during the day
+	PIN_CHANGE_CONTROL_REGISTER |= PIN_CHANGE_ENABLE;
+#endif
+#ifdef		FADE_ENGINE_ENABLED
+	StartFade(MAXIMUM_OCR0L_INTERNAL);
+#endif
 }
 
 
@@ -441,4 +896,604 @@ inline static void SwitchToNightMode()
 inline static bool IsSetToDayMode()
 {
 	return (OperationalFlags & FLAG_RUNNING_DAY) == FLAG_RUNNING_DAY;
-}
\ No newline at end of file
+}
+
+#ifdef		FADE_ENGINE_ENABLED
+// helper function: Ramp the PWM to Target, a ramp that is already running just changes direction
+inline static void StartFade(uint8_t Target)
+{
+	LightTarget = Target;
+#ifdef		WDT_DRIFT_ENABLED
+	if( (OCR0OUT_REGISTER_LOW != Target) && DriftIsRunning() )
+	{ // The ramp needs the overflow interrupt, measure again when it's done
+		TIMER0_INT_MASK_REGISTER = 0x00;
+		DriftOverflows = WDT_DRIFT_ARMED;
+	}
+#endif
+	if( (OCR0OUT_REGISTER_LOW != Target) && ((TIMER0_INT_MASK_REGISTER & TIMSK0_FADE) == 0) )
+	{
+		FadeCountDown = 1; // First step on the next overflow, the interrupt loads the step time
+		OperationalFlags |= FLAG_PWM_OPERATONAL; // Timer must keep running, so Idle sleep only
+		TIMER0_INT_FLAG_REGISTER = (1<<TOV0); // Clear a stale overflow flag
+		TIMER0_INT_MASK_REGISTER = TIMSK0_FADE;
+	}
+}
+#endif
+
+#ifdef		DUSK_RAMP_ENABLED
+/*
+  helper function: The duty for a dark sample with the light on. That is the limitation step Count
+  is at, but no more than the twilight allows: from DUSK_START_PWM at DARK_THRESHOLD up to full at
+  DUSK_DARK_LEVEL, in a straight line. Darker than that the step is all there is.
+*/
+inline static uint8_t NightDuty(uint16_t Count, uint8_t Sample)
+{
+	uint8_t	Duty = MAXIMUM_OCR0L_INTERNAL;
+	uint8_t	Twilight;
+	
+	if( AFTERGLOW_STEP2_REACHED(Count) )
+		Duty = CFG_LIMITATION_PWM2;
+	else if( AFTERGLOW_STEP1_REACHED(Count) )
+		Duty = CFG_LIMITATION_PWM1;
+	
+	if( Sample > DUSK_DARK_LEVEL )
+	{
+		Twilight = MAXIMUM_OCR0L_INTERNAL - (uint8_t)(((uint16_t)(Sample - DUSK_DARK_LEVEL) * DUSK_PWM_STEP_Q8) >> 8);
+		if( Twilight < Duty )
+			Duty = Twilight;
+	}
+	return Duty;
+}
+
+// helper function: Go to Duty, full brightness is a constant high output that doesn't need Idle sleep
+inline static void SetNightDuty(uint8_t Duty)
+{
+#ifdef		FADE_ENGINE_ENABLED
+	StartFade(Duty);
+#else
+	if( Duty != MAXIMUM_OCR0L_INTERNAL )
+	{
+		OperationalFlags |= FLAG_PWM_OPERATONAL;
+		SET_OCR0OUT(Duty);
+	}
+	else
+		SetFullDuty();
+#endif
+}
+#endif // DUSK_RAMP_ENABLED
+
+#ifdef		FULL_DUTY_LOAD_ENABLED
+/*
+  helper function: Go to full brightness without the fade engine. Timer0 only loads OCR0x at the end
+  of the PWM period, Power-Down before that stops the timer with the dimmed duty on the pin. So from
+  a dimmed duty the core stays in Idle, the overflow interrupt clears FLAG_PWM_OPERATONAL.
+*/
+inline static void SetFullDuty()
+{
+	SET_OCR0OUT(MAXIMUM_OCR0L_INTERNAL);
+	if( (OperationalFlags & FLAG_PWM_OPERATONAL) == FLAG_PWM_OPERATONAL )
+	{
+#ifdef		WDT_DRIFT_ENABLED
+		if( !DriftIsRunning() ) // Else the overflow interrupt is on already
+#endif
+		{
+			TIMER0_INT_FLAG_REGISTER = (1<<TOV0); // Clear a stale overflow flag
+			TIMER0_INT_MASK_REGISTER = (1<<TOIE0);
+		}
+	}
+}
+#endif // FULL_DUTY_LOAD_ENABLED
+
+#ifdef		WDT_DRIFT_ENABLED
+// Simple check to see if the Timer0 overflows are being counted:
+inline static bool DriftIsRunning()
+{
+	return (DriftOverflows != WDT_DRIFT_OFF) && (DriftOverflows != WDT_DRIFT_ARMED);
+}
+
+/*
+  helper function: Called on every WDT interrupt. Starts the measurement when the light is on and
+  dimmed, so the core stays in Idle with the timer running, and the overflow interrupt is free.
+  One WDT interrupt later it's done. Sleeping in Power-Down halfway (back to full brightness)
+  loses overflows, which the limits catch.
+*/
+inline static void RunDriftMeasurement()
+{
+	uint16_t	Measured;
+	
+	if( DriftIsRunning() )
+	{
+		TIMER0_INT_MASK_REGISTER = 0x00;
+		Measured = DriftOverflows - 1;
+		DriftOverflows = WDT_DRIFT_OFF; // Once a night is plenty, it changes with the seasons
+		if( (Measured > WDT_DRIFT_MINIMUM) && (Measured < WDT_DRIFT_MAXIMUM) )
+			DriftPeriod += (int16_t)(Measured - DriftPeriod) >> WDT_DRIFT_FILTER_SHIFT;
+	}
+	else if( (DriftOverflows == WDT_DRIFT_ARMED) && (TIMER0_INT_MASK_REGISTER == 0x00)
+		&& ((OperationalFlags & (FLAG_LIGHTISON | FLAG_PWM_OPERATONAL | FLAG_SLOWTURNOFF)) == (FLAG_LIGHTISON | FLAG_PWM_OPERATONAL)) )
+	{
+		DriftOverflows = 1;
+		TIMER0_INT_FLAG_REGISTER = (1<<TOV0); // Clear a stale overflow flag
+		TIMER0_INT_MASK_REGISTER = (1<<TOIE0);
+	}
+}
+
+/*
+  helper function: The number of WDT ticks to the next sample. Counts whole WDT periods of
+  DriftPeriod overflows up to the nominal sample interval, the overshoot is carried over, so
+  on average the interval is exact, without a division.
+*/
+inline static uint8_t DriftCountDown(bool Day)
+{
+	uint32_t	Time = DriftCarry;
+	uint32_t	Interval = WDT_DRIFT_SAMPLE_NIGHT;
+	uint16_t	Period = DriftPeriod;
+	uint8_t		Count = 0;
+	
+	if( Day )
+	{
+		Interval = WDT_DRIFT_SAMPLE_DAY;
+		Period <<= WDT_DRIFT_DAY_SHIFT;
+	}
+	
+	do
+	{
+		Time += Period;
+		Count++;
+	} while( Time < Interval );
+	
+	DriftCarry = (uint16_t)(Time - Interval);
+	return Count;
+}
+#endif // WDT_DRIFT_ENABLED
+
+#ifdef		MOTION_SENSOR_ENABLED
+// Simple check to see if the motion sensor sees someone:
+inline static bool IsMotionDetected()
+{
+#ifdef		MOTION_ACTIVE_LOW
+	return (PINB & PORTB_MOTION_PIN) == 0;
+#else
+	return (PINB & PORTB_MOTION_PIN) != 0;
+#endif
+}
+
+// helper function: The duty the night is at without passers-by, with the dusk ramp for the last sample
+inline static uint8_t ScheduledDuty()
+{
+#ifdef		DUSK_RAMP_ENABLED
+	return NightDuty(Ticks, ADC_RESULT_REGISTER);
+#else
+	uint8_t	Duty = MAXIMUM_OCR0L_INTERNAL;
+	
+	if( AFTERGLOW_STEP2_REACHED(Ticks) )
+		Duty = CFG_LIMITATION_PWM2;
+	else if( AFTERGLOW_STEP1_REACHED(Ticks) )
+		Duty = CFG_LIMITATION_PWM1;
+	return Duty;
+#endif
+}
+
+/*
+  helper function: Go back to the schedule after a hold. The fade engine ramps there in one go. Without
+  it this is called on every WDT interrupt outside a hold, and steps OCR0_DECREASE_STEPSIZE down until the
+  light is at the schedule, which the steps of the schedule itself go through as well.
+*/
+inline static void EndMotionHold()
+{
+#ifdef		FADE_ENGINE_ENABLED
+	StartFade(ScheduledDuty()); // ramp back
+#else
+	uint8_t	Duty = ScheduledDuty();
+	uint8_t	Temp = OCR0OUT_REGISTER_LOW;
+	
+	if( ((OperationalFlags & FLAG_LIGHTISON) == FLAG_LIGHTISON) && (Temp > Duty) )
+	{
+		if( (uint8_t)(Temp - Duty) > OCR0_DECREASE_STEPSIZE )
+			Duty = Temp - OCR0_DECREASE_STEPSIZE;
+		OperationalFlags |= FLAG_PWM_OPERATONAL;
+		SET_OCR0OUT(Duty);
+	}
+#endif
+}
+#endif // MOTION_SENSOR_ENABLED
+
+#ifdef		EEPROM_HISTORY_ENABLED
+// CRC-8 (polynomial 0x07) over the sequence and day length of a record:
+static uint8_t HistoryCrc(const HistoryRecord *Record)
+{
+	uint8_t	Crc;
+	
+	Crc = _crc8_ccitt_update(0, Record->Sequence);
+	Crc = _crc8_ccitt_update(Crc, (uint8_t)Record->DayTicks);
+	return _crc8_ccitt_update(Crc, (uint8_t)(Record->DayTicks >> 8));
+}
+
+/*
+  helper function: Find the newest valid record in the history. Records are written one slot
+  further every time, so all valid sequence numbers lie within EEPROM_HISTORY_SLOTS of each other
+  and a signed 8 bit difference tells which one is newer, wrap-around included. Erased (0xFF) and
+  never written (0x00) slots, or a record cut short by a power failure, fail the CRC or the day
+  length check and are skipped.
+*/
+inline static void RecallHistory()
+{
+	HistoryRecord	Record;
+	uint8_t			Slot;
+	
+	RecalledDayTicks = 0;
+	HistorySlot = 0;
+	HistorySequence = 0;
+	
+	for(Slot = 0; Slot < EEPROM_HISTORY_SLOTS; Slot++)
+	{
+		eeprom_read_block(&Record, &History[Slot], sizeof(Record));
+		if( (Record.Crc != HistoryCrc(&Record)) || (Record.DayTicks == 0) || (Record.DayTicks == 0xFFFF) )
+			continue;
+		
+		if( (RecalledDayTicks == 0) || ((int8_t)(Record.Sequence - HistorySequence) >= 0) )
+		{ // First valid one, or newer than what we found so far: the next write goes after it
+			RecalledDayTicks = Record.DayTicks;
+			HistorySequence = Record.Sequence + 1;
+			HistorySlot = Slot + 1;
+			if( HistorySlot >= EEPROM_HISTORY_SLOTS )
+				HistorySlot = 0;
+		}
+	}
+}
+
+/*
+  helper function: Called at the switch to night mode, before Ticks is turned into night ticks.
+  The first day after power-up was only partly counted, so it is not stored and the recalled
+  day length stands in for it if that is longer. Every day after that is handed to the main
+  loop, StoreHistory() writes it: this runs in the ADC interrupt, and a write takes milliseconds.
+*/
+inline static void UpdateHistory()
+{
+	if( (OperationalFlags & FLAG_FIRST_DAY) == FLAG_FIRST_DAY )
+	{
+		OperationalFlags &= ~FLAG_FIRST_DAY;
+		if( Ticks < RecalledDayTicks )
+			Ticks = RecalledDayTicks;
+		RecalledDayTicks = 0; // From now on count on our own Ticks again
+		return;
+	}
+	
+	HistoryPending = Ticks; // Never 0 here, the night trigger wants plenty Ticks
+}
+
+/*
+  helper function: Called from the main loop with a day length pending. The ADC interrupt may
+  hand over the next one while this runs, so the pending one is taken with interrupts off.
+  eeprom_update_block() only keeps them off for the two instructions that start each byte.
+*/
+inline static void StoreHistory()
+{
+	HistoryRecord	Record;
+	
+	cli();
+	Record.DayTicks = HistoryPending;
+	HistoryPending = 0;
+	sei();
+	
+	Record.Sequence = HistorySequence;
+	Record.Crc = HistoryCrc(&Record);
+	eeprom_update_block(&Record, &History[HistorySlot], sizeof(Record)); // About 14ms
+	
+	HistorySequence++;
+	HistorySlot++;
+	if( HistorySlot >= EEPROM_HISTORY_SLOTS )
+		HistorySlot = 0;
+}
+#endif // EEPROM_HISTORY_ENABLED
+
+#ifdef		COLD_START_ENABLED
+/*
+  helper function: Called once at power-up, in day mode with nothing counted yet. The ADC is
+  polled COLD_START_SAMPLES times, with interrupts still off. What the readings agree on:
+    -- Night, all of them dark: a dusk that is already confirmed, so the night streak is one
+       short and the first sample comes after one WDT period. That one switches the light on.
+    -- Day, all of them light: the day streak is one short, the next light sample confirms the
+       day the way a morning does.
+    -- Anything else is twilight, dusk or dawn: the day is taken as seen, so a night streak
+       from the next sample on switches the light on.
+  Night and twilight seed Ticks with COLD_START_GATE_OPEN, past MINIMUM_DAY_BEFORE_NIGHT, so the
+  first night streak switches the light on. Day seeds it COLD_START_GUARD_TICKS short of
+  MINIMUM_DAY_BEFORE_NIGHT, so a cloud soon after power-up doesn't. The seed comes off again when
+  the first night starts, then that night gets at least COLD_START_DAY_TICKS of day, or the
+  recalled day length with the EEPROM history.
+*/
+inline static void ClassifyColdStart()
+{
+	uint8_t	Count;
+	uint8_t	Reading;
+	uint8_t	Lowest = 0xFF;
+	uint8_t	Highest = 0x00;
+	
+	for(Count = COLD_START_SAMPLES; Count != 0; Count--)
+	{
+		ADCSRA = ADCSRA_POLL;
+		while( (ADCSRA & (1<<ADSC)) != 0 )
+			; // About 25 ADC clocks for the first one, 13 after that
+		Reading = ADC_RESULT_REGISTER;
+		if( Reading < Lowest )
+			Lowest = Reading;
+		if( Reading > Highest )
+			Highest = Reading;
+		_delay_loop_2(COLD_START_SPACING_LOOPS);
+	}
+	ADCSRA = (1<<ADIF); // Clear the flag of the last one, or the ADC interrupt runs as soon as the WDT enables it
+	
+	Ticks = COLD_START_GATE_OPEN;
+	if( Highest < CFG_DARK_THRESHOLD )
+	{ // Night:
+		OperationalFlags |= FLAG_LASTMODE_WAS_DAY;
+		NightStreak = MINIMUM_NIGHT_STREAK - 1;
+		WDT_CountDown = 1;
+	}
+	else if( Lowest > CFG_LIGHT_THRESHOLD )
+	{ // Day:
+		DayStreak = MINIMUM_DAY_STREAK - 1;
+		Ticks = MINIMUM_DAY_BEFORE_NIGHT_INTERNAL - COLD_START_GUARD_TICKS;
+	}
+	else
+	{ // Twilight:
+		OperationalFlags |= FLAG_LASTMODE_WAS_DAY;
+	}
+	
+#ifdef		EEPROM_HISTORY_ENABLED
+	if( RecalledDayTicks == 0 )
+		RecalledDayTicks = COLD_START_DAY_TICKS; // No history yet, UpdateHistory() makes up the first day with this
+#else
+	OperationalFlags |= FLAG_FIRST_DAY;
+#endif
+}
+#endif // COLD_START_ENABLED
+
+#ifdef		MIDNIGHT_ESTIMATOR_ENABLED
+/*
+  helper function: Called for every sample. Keeps the time since the dusk edge while a night
+  is being measured, and the time since the estimated solar midnight once there is one. A day
+  sample is DAY_SAMPLE_DARK_TICKS night samples long, light or dark doesn't matter here.
+*/
+inline static void RunMidnightClock()
+{
+	uint8_t	Step = 1;
+	
+	if( IsSetToDayMode() )
+		Step = DAY_SAMPLE_DARK_TICKS;
+	
+	if( (DarkTicks != 0) && (DarkTicks <= MIDNIGHT_DARK_MAXIMUM + MIDNIGHT_DAWN_TICKS) )
+		DarkTicks += Step; // Stops counting on a sensor that stays covered, which fails the check at dawn
+	
+	if( MidnightPhase != MIDNIGHT_PHASE_UNKNOWN )
+	{
+		MidnightPhase += Step;
+		if( MidnightPhase >= MIDNIGHT_DAY_TICKS )
+			MidnightPhase -= MIDNIGHT_DAY_TICKS;
+	}
+}
+
+/*
+  helper function: Called when the day streak confirms the dawn, before the switch to day mode.
+  The dawn edge was at the start of that streak, so the dark interval is DarkTicks minus the
+  streak, and the middle of it lies half the interval before the dawn edge. The time since that
+  middle pulls the estimate along through a first order filter, the first night sets it as is.
+  Dusk and dawn errors each weigh half, and the filter spreads them over a few nights.
+*/
+inline static void UpdateMidnightEstimate()
+{
+	uint16_t	Dark;
+	uint16_t	SinceMiddle;
+	int16_t		Error;
+	
+	if( IsSetToDayMode() )
+		Dark = DarkTicks - (uint16_t)DayStreak * DAY_SAMPLE_DARK_TICKS;
+	else
+		Dark = DarkTicks - DayStreak; // Light still on at dawn, the streak was in night samples
+	
+	if( (Dark >= MIDNIGHT_DARK_MINIMUM) && (Dark <= MIDNIGHT_DARK_MAXIMUM) )
+	{ // A believable night (not a flooded or a covered sensor):
+		SinceMiddle = DarkTicks - (Dark >> 1);
+#ifdef		PREDAWN_LIGHT_ENABLED
+		if( HalfNight == 0 )
+			HalfNight = Dark >> 1;
+		else
+			HalfNight += (int16_t)((Dark >> 1) - HalfNight) >> MIDNIGHT_FILTER_SHIFT;
+#endif
+		if( MidnightPhase == MIDNIGHT_PHASE_UNKNOWN )
+			MidnightPhase = SinceMiddle;
+		else
+		{
+			Error = (int16_t)(SinceMiddle - MidnightPhase);
+			if( Error >= (int16_t)(MIDNIGHT_DAY_TICKS / 2) ) // Around the wrap, take the short way
+				Error -= MIDNIGHT_DAY_TICKS;
+			else if( Error < -(int16_t)(MIDNIGHT_DAY_TICKS / 2) )
+				Error += MIDNIGHT_DAY_TICKS;
+			MidnightPhase += Error >> MIDNIGHT_FILTER_SHIFT;
+			if( (int16_t)MidnightPhase < 0 )
+				MidnightPhase += MIDNIGHT_DAY_TICKS;
+			else if( MidnightPhase >= MIDNIGHT_DAY_TICKS )
+				MidnightPhase -= MIDNIGHT_DAY_TICKS;
+		}
+	}
+	DarkTicks = 0; // Done measuring until the next dusk
+}
+
+/*
+  helper function: The night count-down runs from the end of the night streak to
+  MIDNIGHT_SWITCH_OFF_OFFSET from the next solar midnight. Returned as the day ticks that give
+  that count-down, so the afterglow limits and caps work on it the same as on a counted day.
+*/
+inline static uint16_t MidnightDayTicks()
+{
+	int16_t	CountDown;
+	
+	CountDown = (int16_t)(MIDNIGHT_DAY_TICKS - MidnightPhase) + MIDNIGHT_SWITCH_OFF_OFFSET;
+	if( CountDown < 1 )
+		CountDown = 1;
+	else if( CountDown > CFG_TICK_CONSTANT )
+		CountDown = CFG_TICK_CONSTANT;
+	
+	return CFG_TICK_CONSTANT - CountDown;
+}
+#endif // MIDNIGHT_ESTIMATOR_ENABLED
+
+#ifdef		PREDAWN_LIGHT_ENABLED
+/*
+  helper function: Called for every sample. The window opens when the midnight clock passes
+  PREDAWN_LEAD_MINUTES before the expected dawn, in day mode, during a night that is still being
+  measured. Only at that sample: when the evening light was still on, there is no window tonight.
+  The light is switched on like in SwitchToNightMode(), but the unit stays in day mode, without
+  FLAG_LIGHTISON, so the ADC interrupt keeps counting day ticks and doesn't count down. Ending it
+  is SwitchToDayMode(), which leaves Ticks alone.
+*/
+inline static void RunMorningLight()
+{
+	int16_t	Since;
+	
+	if( HalfNight == 0 )
+		return; // No night learned yet
+	
+	Since = (int16_t)MidnightPhase - ((int16_t)HalfNight - PREDAWN_LEAD_MINUTES);
+	if( Since < 0 )
+		Since += MIDNIGHT_DAY_TICKS;
+	
+	if( (OperationalFlags & FLAG_MORNING_LIGHT) == FLAG_MORNING_LIGHT )
+	{
+		if( (DayStreak >= PREDAWN_LIGHT_STREAK) || (Since >= PREDAWN_MAXIMUM_MINUTES) )
+			SwitchToDayMode(); // Daylight, or the cap: lights out, the day carries on
+	}
+	else if( IsSetToDayMode() && (DarkTicks != 0) && (Since < (int16_t)DAY_SAMPLE_DARK_TICKS) )
+	{
+		DayStreak = 0; // Count the light samples from here, for the end of the window
+		PRR &= ~PRR_TIMEROFF;
+		PORTB |= PORTB_ENABLEBOOST_PIN;
+#ifdef		FADE_ENGINE_ENABLED
+		SET_OCR0OUT(0);
+#else
+		SET_OCR0OUT(PREDAWN_PWM_INTERNAL);
+		if( PREDAWN_PWM_INTERNAL != MAXIMUM_OCR0L_INTERNAL )
+			OperationalFlags |= FLAG_PWM_OPERATONAL;
+#endif
+		SET_PWM_TOP();
+		TCCR0B = TCCR0B_INTERNAL;
+		TCCR0A = TCCR0A_INTERNAL;
+		OperationalFlags |= FLAG_MORNING_LIGHT;
+#ifdef		FADE_ENGINE_ENABLED
+		StartFade(PREDAWN_PWM_INTERNAL);
+#endif
+	}
+}
+#endif // PREDAWN_LIGHT_ENABLED
+
+
+#ifdef		LIFETIME_STATS_ENABLED
+extern uint8_t	__bss_end;
+
+/*
+  Start-up code, .init3 runs after the C runtime pointed SP at RAMEND and before anything is
+  pushed or .data and .bss are set up. The statistics block takes the top of the SRAM, so the
+  stack has to start below it. If the globals reach into STATS_STACK_RESERVE under it, the stack
+  would run into them: stop here, dark, so a build like that doesn't get past the bench.
+*/
+void StackBelowStats(void) __attribute__((naked, used, section(".init3")));
+void StackBelowStats(void)
+{
+	SP = STATS_ADDRESS - 1;
+	if( BSS_END_ADDRESS > STATS_ADDRESS - STATS_STACK_RESERVE )
+		while(1)
+			;
+}
+
+/*
+  helper function: Called once at start-up. Nothing clears the block, so after a reset that kept
+  the SRAM powered (watchdog, reset pin, TPI, brown-out that didn't go all the way) it is still
+  there and only counts the reset. Without the magic and version it is random power-up content,
+  or the block of another build, and is started over.
+*/
+inline static void StartStats()
+{
+	uint8_t	*Byte;
+	
+	if( (LifetimeStats.Magic == STATS_MAGIC) && (LifetimeStats.Version == STATS_VERSION) )
+	{
+		STATS_INCREMENT(LifetimeStats.WarmResets);
+		return;
+	}
+	
+	for(Byte = (uint8_t *)&LifetimeStats; Byte < (uint8_t *)&LifetimeStats + STATS_BYTES; Byte++)
+		*Byte = 0;
+	LifetimeStats.Magic = STATS_MAGIC;
+	LifetimeStats.Version = STATS_VERSION;
+}
+
+// helper function: Called at the switch to night mode, with the day ticks as the day counted them
+inline static void CountNight(uint16_t DayTicks)
+{
+	uint8_t	Day;
+	
+	STATS_INCREMENT(LifetimeStats.NightsLit);
+	for(Day = LIFETIME_STATS_DAYS - 1; Day != 0; Day--)
+		LifetimeStats.DayTicks[Day] = LifetimeStats.DayTicks[Day - 1]; // Once a day, a few bytes: just move them up
+	LifetimeStats.DayTicks[0] = STATS_TICKS(DayTicks);
+}
+#endif // LIFETIME_STATS_ENABLED
+
+
+#ifdef		TELEMETRY_ENABLED
+/*
+  Bit-banged UART transmit, 8N1, LSB first. Only called from inside the ADC interrupt, so with
+  interrupts off and nothing to stretch the bits.
+*/
+static void SendTelemetryByte(uint8_t Byte)
+{
+	uint16_t	Frame = ((uint16_t)Byte << 1) | 0x200; // Start bit (0) below the data, stop bit (1) above it
+	uint8_t		Bits = 10;
+	
+	do
+	{
+#ifdef		TELEMETRY_INVERTED
+		if( Frame & 0x01 )
+			PORTB &= ~PORTB_TELEMETRY_PIN;
+		else
+			PORTB |= PORTB_TELEMETRY_PIN;
+#else
+		if( Frame & 0x01 )
+			PORTB |= PORTB_TELEMETRY_PIN;
+		else
+			PORTB &= ~PORTB_TELEMETRY_PIN;
+#endif
+		Frame >>= 1;
+		_delay_loop_1(TELEMETRY_BIT_DELAY);
+	} while( --Bits != 0 );
+}
+
+// Sends a byte and adds it to the record checksum:
+static uint8_t SendTelemetryChecked(uint8_t Check, uint8_t Byte)
+{
+	SendTelemetryByte(Byte);
+	return Check ^ Byte;
+}
+
+// helper function: Send the record of this sample, see TELEMETRY_SYNC in SolarCounter.h for the layout
+inline static void SendTelemetry(uint8_t Sample)
+{
+	uint8_t	Check;
+	
+#ifdef		TELEMETRY_SHARES_BOOST
+	if( !IsSetToDayMode() )
+		return; // The pin is the boost enable at night
+#endif
+	
+	SendTelemetryByte(TELEMETRY_SYNC);
+	Check = SendTelemetryChecked(0, Sample);
+	Check = SendTelemetryChecked(Check, (uint8_t)Ticks);
+	Check = SendTelemetryChecked(Check, (uint8_t)(Ticks >> 8));
+	Check = SendTelemetryChecked(Check, DayStreak);
+	Check = SendTelemetryChecked(Check, NightStreak);
+	Check = SendTelemetryChecked(Check, OperationalFlags);
+	Check = SendTelemetryChecked(Check, OCR0OUT_REGISTER_LOW);
+	SendTelemetryByte(Check);
+}
+#endif // TELEMETRY_ENABLED
\ No newline at end of file
@@ -44,6 +44,7 @@
 #define __SOLAR_COUNTER_H__
 
 #include "SolarConfig.h" // Get the configuration defines in here to be able to do the calculations below;
+#include "SolarTarget.h" // And the registers of the part we're building for
 
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -69,10 +70,11 @@
 #endif		//DEBUG
 #endif //USE_PRODUCTION
 
-#define		WDTCR_VALUE_DAY					((1<<WDIE)|(WDT_PRESCALER_DAY   & 0b00100111)) // Mask out any non-prescaler bits to prevent mistakes
-#define		WDTCR_VALUE_NIGHT				((1<<WDIE)|(WDT_PRESCALER_NIGHT & 0b00100111))
+#define		WDTCR_VALUE_DAY					((1<<WDT_INTERRUPT_ENABLE)|(WDT_PRESCALER_DAY   & 0b00100111)) // Mask out any non-prescaler bits to prevent mistakes
+#define		WDTCR_VALUE_NIGHT				((1<<WDT_INTERRUPT_ENABLE)|(WDT_PRESCALER_NIGHT & 0b00100111))
 
 #define		ADCSRA_START					(0b11001000 | (ADC_PRESCALER & 0b00000111))
+#define		ADCSRA_POLL						(0b11010000 | (ADC_PRESCALER & 0b00000111)) // No interrupt, clears ADIF of the one before
 
 #define		CCP_SIGNATURE					0xD8 // Page 12 of the Datasheets
 
@@ -91,26 +93,301 @@
 	#define CLOCK_PRESCALER_INTERNAL 3 // if reserved mode chosen, default back to Source / 8
 #endif
 
-#define		INITIAL_OCR0L_INTERNAL		(INITIAL_OCR0 & 0x0FF)
+// The resulting system clock, for anything that needs to know real time:
+#if (SYSTEM_CLOCK_INTERNAL == 0)
+#define		SYSTEM_CLOCK_SOURCE_HZ		TARGET_RC_OSCILLATOR_HZ
+#elif (SYSTEM_CLOCK_INTERNAL == 1)
+#define		SYSTEM_CLOCK_SOURCE_HZ		128000UL
+#else
+#define		SYSTEM_CLOCK_SOURCE_HZ		(EXTERNAL_CLOCK_HZ * 1UL) // No cast, the preprocessor has to be able to use it
+#endif
+#define		SYSTEM_CLOCK_HZ				(SYSTEM_CLOCK_SOURCE_HZ >> CLOCK_PRESCALER_INTERNAL)
+#ifndef		F_CPU
+#define		F_CPU						SYSTEM_CLOCK_HZ // For avr-libc's delay headers
+#endif
+
+// LED PWM: the smallest Timer0 prescaler that gets PWM_FREQUENCY_HZ with a TOP of 255 or below. When
+// that TOP would be below 63 (the frequency falls between two prescalers, like the default 1953Hz on
+// the ATtiny13A's 600kHz) the prescaler below it with a TOP of 255 is used, a bit above the frequency:
+#ifdef PWM_PHASE_CORRECT
+#define		PWM_PHASE_CORRECT_ENABLED
+#define		PWM_TOP_FOR(Divider)		(SYSTEM_CLOCK_HZ / ((Divider) * 2UL * PWM_FREQUENCY_HZ)) // Counts up and down
+#else
+#define		PWM_TOP_FOR(Divider)		(SYSTEM_CLOCK_HZ / ((Divider) * PWM_FREQUENCY_HZ) - 1)
+#endif
+#define		PWM_TOP_USABLE(Divider)		(PWM_TOP_FOR(Divider) >= 63)
+#if (PWM_FREQUENCY_HZ < 1) || (PWM_TOP_FOR(1UL) + 1 < 64)
+#error "PWM_FREQUENCY_HZ is too high for the system clock, TOP would be below 63"
+#elif (PWM_TOP_FOR(1UL) <= 255)
+	#define		TIMER0_PRESCALER_BITS	1
+	#define		TIMER0_DIVIDER			1UL
+#elif (PWM_TOP_FOR(8UL) <= 255) && PWM_TOP_USABLE(8UL)
+	#define		TIMER0_PRESCALER_BITS	2
+	#define		TIMER0_DIVIDER			8UL
+#elif (PWM_TOP_FOR(8UL) <= 255)
+	#define		TIMER0_PRESCALER_BITS	1
+	#define		TIMER0_DIVIDER			1UL
+	#define		PWM_TOP_ROUNDED_UP
+#elif (PWM_TOP_FOR(64UL) <= 255) && PWM_TOP_USABLE(64UL)
+	#define		TIMER0_PRESCALER_BITS	3
+	#define		TIMER0_DIVIDER			64UL
+#elif (PWM_TOP_FOR(64UL) <= 255)
+	#define		TIMER0_PRESCALER_BITS	2
+	#define		TIMER0_DIVIDER			8UL
+	#define		PWM_TOP_ROUNDED_UP
+#elif (PWM_TOP_FOR(256UL) <= 255) && PWM_TOP_USABLE(256UL)
+	#define		TIMER0_PRESCALER_BITS	4
+	#define		TIMER0_DIVIDER			256UL
+#elif (PWM_TOP_FOR(256UL) <= 255)
+	#define		TIMER0_PRESCALER_BITS	3
+	#define		TIMER0_DIVIDER			64UL
+	#define		PWM_TOP_ROUNDED_UP
+#elif (PWM_TOP_FOR(1024UL) <= 255) && PWM_TOP_USABLE(1024UL)
+	#define		TIMER0_PRESCALER_BITS	5
+	#define		TIMER0_DIVIDER			1024UL
+#elif (PWM_TOP_FOR(1024UL) <= 255)
+	#define		TIMER0_PRESCALER_BITS	4
+	#define		TIMER0_DIVIDER			256UL
+	#define		PWM_TOP_ROUNDED_UP
+#else
+#error "PWM_FREQUENCY_HZ is too low for the system clock, even with the largest Timer0 prescaler"
+#endif
+#ifdef PWM_TOP_ROUNDED_UP
+#define		PWM_TOP						0xFF
+#else
+#define		PWM_TOP						PWM_TOP_FOR(TIMER0_DIVIDER)
+#endif
+#ifdef PWM_PHASE_CORRECT_ENABLED
+#define		PWM_PERIOD_COUNTS			(2 * PWM_TOP)
+#else
+#define		PWM_PERIOD_COUNTS			(PWM_TOP + 1)
+#endif
+#if (PWM_TOP == 0xFF) // The timer's own 8 bit mode, nothing to scale
+#define		PWM_LEVEL(Value)			(Value)
+#define		SET_PWM_TOP()
+#else
+// A PWM value out of 255 in timer counts, 0 stays 0 and 255 becomes TOP (always on):
+#define		PWM_LEVEL(Value)			((((Value) * (PWM_TOP + 1UL)) + PWM_TOP) >> 8)
+#define		SET_PWM_TOP()				PWM_TOP_WRITE(PWM_TOP)
+#if defined(TARGET_PWM_TOP_IS_OCR0A) && (PORTB_LEDPWM_PIN != (1<<PORTB1))
+#error "On this part OCR0A holds TOP when PWM_FREQUENCY_HZ isn't a TOP of 255, the LED has to be on OC0B (PB1)"
+#endif
+#endif
+
+#define		INITIAL_OCR0L_INTERNAL		PWM_LEVEL(INITIAL_OCR0 & 0x0FF)
 #define		INITIAL_OCR0H_INTERNAL		(INITIAL_OCR0 & 0xFF00)
 
-#define		MAXIMUM_OCR0L_INTERNAL		(MAXIMUM_OCR0 & 0x0FF)
+#define		MAXIMUM_OCR0L_INTERNAL		PWM_LEVEL(MAXIMUM_OCR0 & 0x0FF)
 #define		MAXIMUM_OCR0H_INTERNAL		(MAXIMUM_OCR0 & 0xFF00)
 
+// Checks on values the preprocessor can't calculate (anything from a mV setting is floating point),
+// done by the compiler instead. The source also builds as C++, which spells it differently.
+// The settings stay macros rather than a C++ constexpr configuration object. Whether that object
+// would make the firmware any larger or slower was never measured (no avr-g++ build exists):
+#ifdef		__cplusplus
+#define		STATIC_ASSERT(Condition, Message)	static_assert(Condition, Message)
+#else
+#define		STATIC_ASSERT(Condition, Message)	_Static_assert(Condition, Message)
+#endif
+
 // Calculate the dark and light thresholds from the values set above:
 #define		DARK_THRESHOLD		(uint8_t)(((DARK_THRESHOLD_MV - DARK_HYSTERESIS_MV)*255.0)/SUPPLY_VOLTAGE_MV)
 #define		LIGHT_THRESHOLD		(uint8_t)(((DARK_THRESHOLD_MV + DARK_HYSTERESIS_MV)*255.0)/SUPPLY_VOLTAGE_MV)
+STATIC_ASSERT((DARK_THRESHOLD_MV + DARK_HYSTERESIS_MV) < SUPPLY_VOLTAGE_MV, "LIGHT_THRESHOLD is above the ADC range at this supply voltage");
+STATIC_ASSERT(DARK_THRESHOLD > 0, "DARK_THRESHOLD rounds down to 0, nothing would ever read as dark");
+STATIC_ASSERT(DARK_THRESHOLD < LIGHT_THRESHOLD, "DARK_HYSTERESIS_MV is less than one ADC count at this supply voltage");
 
 #define		MINIMUM_DAY_BEFORE_NIGHT_INTERNAL	(MINIMUM_DAY_BEFORE_NIGHT >> 1) // divide by two
 													// TODO: Make the above shift more flexible toward
 													// different WDT interrupt distances
 
+// Power-up classification, NIGHT_INSTALL asks for the lit run in stead:
+#if defined(USE_COLD_START) && !defined(NIGHT_INSTALL)
+#define		COLD_START_ENABLED
+#define		COLD_START_DAY_TICKS		(COLD_START_DAY_MINUTES >> 1) // Like MINIMUM_DAY_BEFORE_NIGHT_INTERNAL
+#define		COLD_START_GUARD_TICKS		(COLD_START_GUARD_MINUTES >> 1)
+#define		COLD_START_GATE_OPEN		0x8000 // Ticks of a power-up at night or dusk, no day counts that far
+#define		COLD_START_SPACING_LOOPS	((SYSTEM_CLOCK_HZ * COLD_START_SPACING_MS) / 4000UL) // _delay_loop_2() takes 4 cycles a count
+#if (COLD_START_SAMPLES < 1) || (COLD_START_SAMPLES > 255)
+#error "COLD_START_SAMPLES has to be 1 to 255"
+#elif (COLD_START_SPACING_LOOPS > 65535)
+#error "COLD_START_SPACING_MS is too long for one delay loop at this system clock"
+#elif (MINIMUM_NIGHT_STREAK < 1) || (MINIMUM_DAY_STREAK < 1)
+#error "The cold start seeds the streaks one short of MINIMUM_NIGHT_STREAK and MINIMUM_DAY_STREAK"
+#elif (COLD_START_GUARD_MINUTES > MINIMUM_DAY_BEFORE_NIGHT)
+#error "COLD_START_GUARD_MINUTES can't be longer than MINIMUM_DAY_BEFORE_NIGHT"
+#endif
+#endif
+
+// WDT period of a prescaler setting, WDP3 sits apart from WDP2..0:
+#define		WDT_PERIOD_INDEX(Prescaler)	((((Prescaler) >> 2) & 0x08) | ((Prescaler) & 0x07))
+#define		WDT_PERIOD_MS(Prescaler)	(16UL << WDT_PERIOD_INDEX(Prescaler))
+#define		WDT_NIGHT_PERIOD_MS			WDT_PERIOD_MS(WDT_PRESCALER_NIGHT)
+#define		WDT_DAY_PERIOD_MS			WDT_PERIOD_MS(WDT_PRESCALER_DAY)
+
+// Motion sensor input, the hold time counted in night WDT periods:
+#ifdef USE_MOTION_SENSOR
+#define		MOTION_SENSOR_ENABLED
+#if (PORTB_MOTION_PIN == PORTB_SENSOR_PIN) || (PORTB_MOTION_PIN == PORTB_LEDPWM_PIN) || (PORTB_MOTION_PIN == PORTB_ENABLEBOOST_PIN)
+#error "The motion sensor needs a pin of its own"
+#endif
+#if defined(USE_TELEMETRY) && defined(DEBUG) && (PORTB_MOTION_PIN == PORTB_TELEMETRY_PIN)
+#error "The motion sensor and telemetry can't share a pin"
+#endif
+#define		MOTION_HOLD_PERIODS		((MOTION_HOLD_SECONDS * 1000UL + WDT_NIGHT_PERIOD_MS - 1) / WDT_NIGHT_PERIOD_MS)
+#if (MOTION_HOLD_PERIODS < 1) || (MOTION_HOLD_PERIODS > 65535)
+#error "MOTION_HOLD_SECONDS doesn't fit the 16 bit hold counter at this night WDT period"
+#endif
+#define		LIMITATION_PWM1_SELECTED	MOTION_LIMITATION_PWM1
+#define		LIMITATION_PWM2_SELECTED	MOTION_LIMITATION_PWM2
+#else
+#define		LIMITATION_PWM1_SELECTED	AFTERGLOW_LIMITATION_PWM1
+#define		LIMITATION_PWM2_SELECTED	AFTERGLOW_LIMITATION_PWM2
+#endif // USE_MOTION_SENSOR
+
+// Day length history, only on parts with EEPROM:
+#if defined(USE_EEPROM_HISTORY) && (TARGET_EEPROM_BYTES > 0)
+#define		EEPROM_HISTORY_ENABLED
+#define		EEPROM_RECORD_BYTES			4 // Sequence, day ticks low and high, CRC-8
+#if (EEPROM_HISTORY_SLOTS < 2) || (EEPROM_HISTORY_SLOTS > 64)
+#error "EEPROM_HISTORY_SLOTS has to be 2 to 64, the newest record is found with 8 bit sequence numbers"
+#elif ((EEPROM_HISTORY_SLOTS * EEPROM_RECORD_BYTES) > TARGET_EEPROM_BYTES)
+#error "EEPROM_HISTORY_SLOTS doesn't fit in the EEPROM of this part"
+#endif
+#endif
+
+// Solar midnight estimator, all times counted in night samples:
+#ifdef USE_MIDNIGHT_ESTIMATOR
+#define		MIDNIGHT_ESTIMATOR_ENABLED
+#define		DAY_SAMPLE_DARK_TICKS		((TICKS_BEFORE_SAMPLE_DAY * WDT_DAY_PERIOD_MS) / (TICKS_BEFORE_SAMPLE_NIGHT * WDT_NIGHT_PERIOD_MS))
+#define		MIDNIGHT_DUSK_TICKS			(MINIMUM_NIGHT_STREAK * DAY_SAMPLE_DARK_TICKS) // Night mode starts this long after the dusk edge
+#define		MIDNIGHT_DAWN_TICKS			(MINIMUM_DAY_STREAK * DAY_SAMPLE_DARK_TICKS) // Day mode this long after the dawn edge, at most
+// A day in night samples, from the production timing: the testing builds run the same numbers on a shorter time base.
+#define		MIDNIGHT_DAY_TICKS			((24UL * 3600000UL) / (TICKS_BEFORE_SAMPLE_NIGHT_PRODUCTION * WDT_PERIOD_MS(WDT_PRESC_NIGHT_PRODUCTION)))
+#define		MIDNIGHT_PHASE_UNKNOWN		0xFFFF
+#define		MIDNIGHT_DARK_MINIMUM		240 // Shorter or longer dark intervals are a flooded or covered sensor,
+#define		MIDNIGHT_DARK_MAXIMUM		1200 // not a night, and leave the estimate alone
+#if (DAY_SAMPLE_DARK_TICKS < 1) || (DAY_SAMPLE_DARK_TICKS > 255)
+#error "The solar midnight estimator needs day samples 1 to 255 times as long as night samples"
+#endif
+#if (MIDNIGHT_FILTER_SHIFT < 0) || (MIDNIGHT_FILTER_SHIFT > 4)
+#error "MIDNIGHT_FILTER_SHIFT has to be 0 to 4"
+#endif
+#if (MIDNIGHT_DAY_TICKS > 16383) || (MIDNIGHT_DARK_MAXIMUM >= MIDNIGHT_DAY_TICKS)
+#error "The solar midnight estimator doesn't fit its 16 bit counters at this night WDT period"
+#endif
+#endif // USE_MIDNIGHT_ESTIMATOR
+
+// Pre-dawn light, timed by the solar midnight estimator:
+#ifdef USE_PREDAWN_LIGHT
+#ifndef		MIDNIGHT_ESTIMATOR_ENABLED
+#error "USE_PREDAWN_LIGHT needs USE_MIDNIGHT_ESTIMATOR for the expected dawn"
+#else
+#define		PREDAWN_LIGHT_ENABLED
+#if (PREDAWN_LIGHT_STREAK < 1) || (PREDAWN_LIGHT_STREAK >= MINIMUM_DAY_STREAK)
+#error "PREDAWN_LIGHT_STREAK has to be 1 up to MINIMUM_DAY_STREAK, the day streak ends the night after it"
+#endif
+#if (PREDAWN_LEAD_MINUTES >= MIDNIGHT_DARK_MINIMUM / 2) || (PREDAWN_MAXIMUM_MINUTES < 1)
+#error "PREDAWN_LEAD_MINUTES has to stay within the shortest half night, and PREDAWN_MAXIMUM_MINUTES above 0"
+#endif
+#if (PREDAWN_PWM < 1) || (PREDAWN_PWM > (MAXIMUM_OCR0 & 0x0FF))
+#error "PREDAWN_PWM out of range"
+#endif
+#define		PREDAWN_PWM_INTERNAL		PWM_LEVEL(PREDAWN_PWM)
+#if defined(USE_TELEMETRY) && defined(DEBUG) && (PORTB_TELEMETRY_PIN == PORTB_ENABLEBOOST_PIN)
+#error "Telemetry on the boost enable pin sends in day mode, which is when the pre-dawn light is on"
+#endif
+#endif // MIDNIGHT_ESTIMATOR_ENABLED
+#endif // USE_PREDAWN_LIGHT
+
+// Dusk ramp: the duty for a reading between DUSK_DARK_LEVEL and DARK_THRESHOLD, see NightDuty()
+#ifdef USE_DUSK_RAMP
+#define		DUSK_RAMP_ENABLED
+#define		DUSK_DARK_LEVEL				(uint8_t)((DUSK_DARK_MV*255.0)/SUPPLY_VOLTAGE_MV)
+// PWM counts per ADC count above DUSK_DARK_LEVEL, times 256, so the ramp takes a multiply and no division:
+#define		DUSK_START_PWM_INTERNAL		PWM_LEVEL(DUSK_START_PWM)
+#define		DUSK_PWM_STEP_Q8			(uint16_t)(((MAXIMUM_OCR0L_INTERNAL - DUSK_START_PWM_INTERNAL) * 256UL) / (DARK_THRESHOLD - DUSK_DARK_LEVEL))
+#if (DUSK_START_PWM < 1) || (DUSK_START_PWM > (MAXIMUM_OCR0 & 0x0FF))
+#error "DUSK_START_PWM out of range"
+#endif
+STATIC_ASSERT(DUSK_DARK_LEVEL < DARK_THRESHOLD, "DUSK_DARK_MV has to be below DARK_THRESHOLD_MV minus DARK_HYSTERESIS_MV");
+#endif // USE_DUSK_RAMP
+
+// Lifetime statistics block, see LifetimeStatsBlock in SolarCounter-Tiny10.c for the layout:
+#ifdef USE_LIFETIME_STATS
+#define		LIFETIME_STATS_ENABLED
+#ifdef		LIFETIME_STATS_COMPACT
+#define		STATS_COUNTER_BYTES			1
+#define		STATS_TICKS_SHIFT			2
+#define		STATS_FORMAT_COMPACT		0x08
+#else
+#define		STATS_COUNTER_BYTES			2
+#define		STATS_TICKS_SHIFT			0
+#define		STATS_FORMAT_COMPACT		0x00
+#endif
+#define		STATS_MAGIC					0xA5
+// The version byte tells the decoder the layout: revision in the top nibble, plus 0x08 for compact, plus the number of day lengths
+#define		STATS_LAYOUT_REVISION		1
+#define		STATS_VERSION				((STATS_LAYOUT_REVISION << 4) | STATS_FORMAT_COMPACT | LIFETIME_STATS_DAYS)
+#define		STATS_BYTES					(5 + (3 + LIFETIME_STATS_DAYS) * STATS_COUNTER_BYTES)
+#define		STATS_ADDRESS				(RAMEND + 1 - STATS_BYTES) // Data space address: the top of the SRAM, the stack starts below it
+#define		STATS_INCREMENT(Counter)	do { if( ++(Counter) == 0 ) (Counter)--; } while(0) // Saturating
+#if (STATS_TICKS_SHIFT == 0)
+#define		STATS_TICKS(Value)			(Value)
+#else
+#define		STATS_TICKS(Value)			(((Value) >= (0x100 << STATS_TICKS_SHIFT)) ? 0xFF : ((Value) >> STATS_TICKS_SHIFT))
+#endif
+#if (LIFETIME_STATS_DAYS < 1) || (LIFETIME_STATS_DAYS > 7)
+#error "LIFETIME_STATS_DAYS has to be 1 to 7"
+#elif (STATS_BYTES * 3 > TARGET_RAM_BYTES)
+#error "The lifetime statistics block takes over a third of the SRAM, set LIFETIME_STATS_COMPACT or keep fewer days"
+#elif (TARGET_RAM_BYTES <= 32) && (defined(USE_FADE_ENGINE) || defined(USE_WDT_DRIFT) || defined(USE_MOTION_SENSOR) || defined(USE_MIDNIGHT_ESTIMATOR) || defined(USE_PREDAWN_LIGHT))
+#error "On the ATtiny10 the globals of USE_FADE_ENGINE, USE_WDT_DRIFT, USE_MOTION_SENSOR, USE_MIDNIGHT_ESTIMATOR or USE_PREDAWN_LIGHT leave less than STATS_STACK_RESERVE under the lifetime statistics"
+#endif
+#endif // USE_LIFETIME_STATS
+
+// Telemetry, only ever in DEBUG builds:
+#if defined(USE_TELEMETRY) && defined(DEBUG)
+#define		TELEMETRY_ENABLED
+#define		TELEMETRY_BIT_CYCLES		(SYSTEM_CLOCK_HZ / TELEMETRY_BAUD)
+#define		TELEMETRY_BIT_DELAY			((TELEMETRY_BIT_CYCLES - TELEMETRY_LOOP_CYCLES) / 3) // _delay_loop_1() takes 3 cycles a count
+#if (TELEMETRY_BIT_CYCLES < TELEMETRY_LOOP_CYCLES + 3)
+#error "TELEMETRY_BAUD is too high for the system clock"
+#elif (TELEMETRY_BIT_DELAY > 255)
+#error "TELEMETRY_BAUD is too low for the system clock, the delay loop only counts to 255"
+#endif
+#if (PORTB_TELEMETRY_PIN == PORTB_SENSOR_PIN) || (PORTB_TELEMETRY_PIN == PORTB_LEDPWM_PIN)
+#error "Telemetry can't share the sensor or the LED PWM pin"
+#endif
+#if (PORTB_TELEMETRY_PIN == PORTB_ENABLEBOOST_PIN)
+	#define		TELEMETRY_SHARES_BOOST
+	#ifndef		TELEMETRY_INVERTED
+	#error "Telemetry on the boost enable pin needs TELEMETRY_INVERTED, or the boost is on whenever the line idles"
+	#endif
+#endif
+#ifdef		TELEMETRY_INVERTED
+#define		TELEMETRY_IDLE_PORTB		0x00
+#else
+#define		TELEMETRY_IDLE_PORTB		PORTB_TELEMETRY_PIN
+#endif
+#define		TELEMETRY_DDRB				PORTB_TELEMETRY_PIN
+/*
+Record, sent at the end of every ADC interrupt:
+  TELEMETRY_SYNC, ADC reading, Ticks low, Ticks high, DayStreak, NightStreak, OperationalFlags,
+  OCR0OUT_REGISTER_LOW, XOR of the 7 bytes after the sync
+*/
+#define		TELEMETRY_SYNC				0xA5
+#else
+#define		TELEMETRY_IDLE_PORTB		0x00
+#define		TELEMETRY_DDRB				0x00
+#endif
 
 // Define PORTB and DDRB from defined pins:
-#define		INITIAL_PORTB		0x00					// PORTB at startup
-#define		INITIAL_DDRB		(PORTB_LEDPWM_PIN | PORTB_ENABLEBOOST_PIN)
+#define		INITIAL_PORTB		TELEMETRY_IDLE_PORTB	// PORTB at startup (all low, but for an idle telemetry line)
+#define		INITIAL_DDRB		(PORTB_LEDPWM_PIN | PORTB_ENABLEBOOST_PIN | TELEMETRY_DDRB)
 														// DDRB: LEDEnable & LEDPWM output
 #define		INITIAL_DIDR0		ADC_DIDR_SENSOR_PIN		// Disable input circuitry on SENSOR
+#define		ADC_ADMUX			(ADMUX_ADJUST | ADC_SENSOR_CHANNEL) // Sensor channel, see SolarTarget.h
 
 #if OCR0B_RESOLUTION == 10
 #warning "PWM Resolution set to 10 bits, please check if this is intended"
@@ -126,28 +403,104 @@
 // supportes, only the error needs to be removed.
 #define		TCCR0A_PRE_INTERNAL		0b00000010
 // TODO: WDT interrupt needs to be made compatible with 10 and 9 bit PWM before the above error is removed!
-#else // OCR0B_RESOLUTION is not 10 or 9
-#define		TCCR0A_PRE_INTERNAL		0b00000001
+#elif defined(PWM_PHASE_CORRECT_ENABLED) && (PWM_TOP == 0xFF)
+#define		TCCR0A_PRE_INTERNAL		TCCR0A_PHASE_PWM8
+#define		TCCR0B_PWM_MODE			TCCR0B_PHASE_PWM8
+#elif defined(PWM_PHASE_CORRECT_ENABLED)
+#define		TCCR0A_PRE_INTERNAL		TCCR0A_PHASE_PWM_TOP
+#define		TCCR0B_PWM_MODE			TCCR0B_PHASE_PWM_TOP
+#elif (PWM_TOP == 0xFF)
+#define		TCCR0A_PRE_INTERNAL		TCCR0A_FAST_PWM8
+#define		TCCR0B_PWM_MODE			TCCR0B_FAST_PWM8
+#else
+#define		TCCR0A_PRE_INTERNAL		TCCR0A_FAST_PWM_TOP
+#define		TCCR0B_PWM_MODE			TCCR0B_FAST_PWM_TOP
+#endif
+#define		TCCR0B_INTERNAL		(TCCR0B_PWM_MODE | TIMER0_PRESCALER_BITS)
+
+// Timer0 overflow rate, for the fade engine and the WDT drift measurement (once per PWM period):
+#define		TIMER0_OVERFLOW_HZ		(SYSTEM_CLOCK_HZ / TIMER0_DIVIDER / PWM_PERIOD_COUNTS)
+
+// Fade engine: the number of Timer0 overflows between two PWM counts of a ramp
+#ifdef USE_FADE_ENGINE
+#define		FADE_ENGINE_ENABLED
+#define		FADE_STEP_OVERFLOWS		((TIMER0_OVERFLOW_HZ * FADE_STEP_MS) / (1000UL * MAXIMUM_OCR0L_INTERNAL))
+#define		FADE_OFF_OVERFLOWS		((TIMER0_OVERFLOW_HZ * FADE_OFF_SECONDS) / MAXIMUM_OCR0L_INTERNAL)
+#if (FADE_STEP_OVERFLOWS < 1) || (FADE_OFF_OVERFLOWS < 1)
+#error "FADE_STEP_MS or FADE_OFF_SECONDS is too short for the Timer0 overflow rate"
+#elif (FADE_STEP_OVERFLOWS > 65535) || (FADE_OFF_OVERFLOWS > 65535)
+#error "FADE_STEP_MS or FADE_OFF_SECONDS is too long for the 16 bit post-scaler"
+#endif
+#define		TIMSK0_FADE				(1<<TOIE0)
+#endif // USE_FADE_ENGINE
+
+// WDT drift measurement: all in Timer0 overflows, a night WDT period is WDT_DRIFT_NOMINAL of them
+#ifdef USE_WDT_DRIFT
+#define		WDT_DRIFT_ENABLED
+#define		WDT_DRIFT_NOMINAL		((WDT_NIGHT_PERIOD_MS * SYSTEM_CLOCK_HZ) / (1000UL * TIMER0_DIVIDER * PWM_PERIOD_COUNTS))
+#define		WDT_DRIFT_MINIMUM		((WDT_DRIFT_NOMINAL * (100 - WDT_DRIFT_LIMIT_PERCENT)) / 100)
+#define		WDT_DRIFT_MAXIMUM		((WDT_DRIFT_NOMINAL * (100 + WDT_DRIFT_LIMIT_PERCENT)) / 100)
+#define		WDT_DRIFT_DAY_SHIFT		(WDT_PERIOD_INDEX(WDT_PRESCALER_DAY) - WDT_PERIOD_INDEX(WDT_PRESCALER_NIGHT))
+#define		WDT_DRIFT_SAMPLE_NIGHT	((uint32_t)TICKS_BEFORE_SAMPLE_NIGHT * WDT_DRIFT_NOMINAL) // Sample intervals
+#define		WDT_DRIFT_SAMPLE_DAY	((uint32_t)TICKS_BEFORE_SAMPLE_DAY * (WDT_DRIFT_NOMINAL << WDT_DRIFT_DAY_SHIFT))
+#define		WDT_DRIFT_OFF			0x0000 // Not measuring: day mode, or done for tonight
+#define		WDT_DRIFT_ARMED			0xFFFF // Not measuring yet tonight, anything in between is a measurement running
+#if (SYSTEM_CLOCK_INTERNAL == 1)
+#error "The WDT drift measurement needs the system clock from another oscillator than the WDT's"
+#endif
+#if (WDT_DRIFT_DAY_SHIFT < 0)
+#error "The WDT drift measurement needs the day WDT period as long as the night one, or longer"
+#endif
+#if (WDT_DRIFT_LIMIT_PERCENT < 1) || (WDT_DRIFT_LIMIT_PERCENT > 50) || (WDT_DRIFT_FILTER_SHIFT > 4)
+#error "WDT_DRIFT_LIMIT_PERCENT has to be 1 to 50, WDT_DRIFT_FILTER_SHIFT 0 to 4"
+#endif
+#if (WDT_DRIFT_MINIMUM < 16) || ((WDT_DRIFT_MAXIMUM << WDT_DRIFT_DAY_SHIFT) > 65534)
+#error "The WDT periods don't fit the 16 bit drift measurement at this Timer0 overflow rate"
+#endif
+#endif // USE_WDT_DRIFT
+
+// Full brightness without the fade engine (a passer-by, the dusk ramp): OCR0x is double buffered, so
+// from a dimmed duty the core stays in Idle until the Timer0 overflow interrupt has seen it loaded.
+// In fast PWM the load is one timer clock after the overflow, the interrupt response has to cover it:
+#if !defined(FADE_ENGINE_ENABLED) && (defined(MOTION_SENSOR_ENABLED) || defined(DUSK_RAMP_ENABLED))
+#define		FULL_DUTY_LOAD_ENABLED
+#if !defined(PWM_PHASE_CORRECT_ENABLED) && (TIMER0_DIVIDER > 8)
+#error "Without the fade engine, full brightness needs a Timer0 prescaler of 8 or less in fast PWM, raise PWM_FREQUENCY_HZ"
+#endif
 #endif
-#define		TCCR0B_INTERNAL		(0x08|(TIMER_PRESCALER & 0x07))
 
 #if	(PORTB_LEDPWM_PIN == (1<<PORTB1))
+#ifdef		TARGET_TIMER0_16BIT
 	#define		OCR0OUT_REGISTER_LOW	OCR0BL
 	#define		OCR0OUT_REGISTER_HIGH	OCR0BH
+#else
+	#define		OCR0OUT_REGISTER_LOW	OCR0B
+#endif
 	#define		TCCR0A_OCR_BITS			0b00100000
 #elif (PORTB_LEDPWM_PIN == (1<<PORTB0))
+#ifdef		TARGET_TIMER0_16BIT
 	#define		OCR0OUT_REGISTER_LOW	OCR0AL
 	#define		OCR0OUT_REGISTER_HIGH	OCR0AH
+#else
+	#define		OCR0OUT_REGISTER_LOW	OCR0A
+#endif
 	#define		TCCR0A_OCR_BITS			0b10000000
 #else
 #error "Configured LEDPWM output pin is not a Timer0 PWM enabled pin."
 #endif
 
+// Write an 8 bit PWM value, the high byte only exists on the ATtiny10:
+#ifdef		TARGET_TIMER0_16BIT
+#define		SET_OCR0OUT(Value)		do { OCR0OUT_REGISTER_HIGH = 0; OCR0OUT_REGISTER_LOW = (Value); } while(0) //TODO: Make compatible with higher resolution PWM
+#else
+#define		SET_OCR0OUT(Value)		OCR0OUT_REGISTER_LOW = (Value)
+#endif
+
 // Build up the TCCR0A value using previously made conditional defines:
 #define		TCCR0A_INTERNAL			(TCCR0A_PRE_INTERNAL | TCCR0A_OCR_BITS)
 
 #define		ACSR_INTERNAL				0x80 // Power disable to the Analog Comparator.
-#define		PRR_TIMEROFF				0x01 // PRR value to disable the Timer
+#define		PRR_TIMEROFF				(1<<PRTIM0) // PRR value to disable the Timer
 
 #if (SLEEP_MODE == 3)
 #warning "Reserved Sleep Mode selected, reverting to Idle mode (0)."
@@ -157,37 +510,108 @@
 #warning "Reserved Sleep Mode selected, reverting to Idle mode (0)."
 	#undef SLEEP_MODE
 	#define SLEEP_MODE	0
+#elif (SLEEP_MODE == 4) && !defined(TARGET_HAS_STANDBY)
+#warning "This part has no Standby mode, reverting to Power-Down mode (2)."
+	#undef SLEEP_MODE
+	#define SLEEP_MODE	2
 #endif
 
 
-#define		SMCR_INTERNAL_LOWEST_ALLOWED	((SLEEP_MODE << 1)|0x01) // Shift up sleep mode and add enable bit by logic or
+#define		SMCR_INTERNAL_LOWEST_ALLOWED	((SLEEP_MODE << SLEEP_MODE_SHIFT)|SLEEP_ENABLE) // Shift up sleep mode and add enable bit by logic or
 
 #if (SLEEP_MODE == 0) // If the sleep mode is set to idle, with ClkIO enabled, set the undifferentiated flag:
 #define		SMCR_UNDIFFERENTIATED
 #endif
 
 // For PWM state, enable sleep mode, with IDLE forced to keep ClkIO running for PWM:
-#define		SMCR_INTERNAL_AT_PWM			0x01 // Enable sleep, with Idle mode forced.
+#define		SMCR_INTERNAL_AT_PWM			SLEEP_ENABLE // Enable sleep, with Idle mode forced.
 
 // If the wrong threshold is higher (if 1 is higher than 2), swap all the limitation values: 
 #if (AFTERGLOW_LIMITATION_THRESHOLD1 > AFTERGLOW_LIMITATION_THRESHOLD2) 
 #define		AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL	AFTERGLOW_LIMITATION_THRESHOLD2
 #define		AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL	AFTERGLOW_LIMITATION_THRESHOLD1
-#define		AFTERGLOW_LIMITATION_PWM1_INTERNAL			AFTERGLOW_LIMITATION_PWM2
-#define		AFTERGLOW_LIMITATION_PWM2_INTERNAL			AFTERGLOW_LIMITATION_PWM1
+#define		AFTERGLOW_LIMITATION_PWM1_INTERNAL			PWM_LEVEL(LIMITATION_PWM2_SELECTED)
+#define		AFTERGLOW_LIMITATION_PWM2_INTERNAL			PWM_LEVEL(LIMITATION_PWM1_SELECTED)
 #warning "AFTERGLOW_LIMITATION_THRESHOLD1 larger than THRESHOLD2, swapping 1 and 2 values."
 #else
 #define		AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL	AFTERGLOW_LIMITATION_THRESHOLD1
 #define		AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL	AFTERGLOW_LIMITATION_THRESHOLD2
-#define		AFTERGLOW_LIMITATION_PWM1_INTERNAL			AFTERGLOW_LIMITATION_PWM1
-#define		AFTERGLOW_LIMITATION_PWM2_INTERNAL			AFTERGLOW_LIMITATION_PWM2
+#define		AFTERGLOW_LIMITATION_PWM1_INTERNAL			PWM_LEVEL(LIMITATION_PWM1_SELECTED)
+#define		AFTERGLOW_LIMITATION_PWM2_INTERNAL			PWM_LEVEL(LIMITATION_PWM2_SELECTED)
+#endif
+
+#if (MINIMUM_AFTERGLOW_MINUTES > MAXIMUM_AFTERGLOW_MINUTES)
+#error "MINIMUM_AFTERGLOW_MINUTES is larger than MAXIMUM_AFTERGLOW_MINUTES"
+#endif
+
+// A limitation step that doesn't dim, or that starts after the longest afterglow, can never trigger:
+// its TicksLimitPWM stays 0, and the code that calculates and checks it is left out. Values from the
+// unit configuration block are only known at run time, both steps are kept then.
+#if defined(USE_UNIT_CONFIG_BLOCK) || ((AFTERGLOW_LIMITATION_PWM1_INTERNAL < MAXIMUM_OCR0L_INTERNAL) && (AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL < MAXIMUM_AFTERGLOW_MINUTES))
+#define		AFTERGLOW_STEP1_ENABLED
+#define		AFTERGLOW_STEP1_REACHED(Count)		((Count) < TicksLimitPWM1)
+#else
+#define		AFTERGLOW_STEP1_REACHED(Count)		0
+#endif
+#if defined(USE_UNIT_CONFIG_BLOCK) || ((AFTERGLOW_LIMITATION_PWM2_INTERNAL < MAXIMUM_OCR0L_INTERNAL) && (AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL < MAXIMUM_AFTERGLOW_MINUTES))
+#define		AFTERGLOW_STEP2_ENABLED
+#define		AFTERGLOW_STEP2_REACHED(Count)		((Count) < TicksLimitPWM2)
+#else
+#define		AFTERGLOW_STEP2_REACHED(Count)		0
 #endif
 
+// Run-time values, from the unit configuration block (see UnitConfigBlock in the main C file) or folded in:
+#ifdef USE_UNIT_CONFIG_BLOCK
+#define		UNIT_CONFIG_ENABLED
+#define		UNIT_CONFIG_VERSION			1
+#define		UNIT_CONFIG_MAGIC			(0xC0 | UNIT_CONFIG_VERSION)
+#define		UNIT_CONFIG_BYTES			20
+#define		UNIT_CONFIG_ADDRESS			(TARGET_FLASH_BYTES - UNIT_CONFIG_BYTES) // Has to match .unitconfig for the linker
+#define		UNIT_CONFIG_BYTE(Field)		FLASH_READ_BYTE(UNIT_CONFIG_ADDRESS + offsetof(UnitConfigBlock, Field))
+#define		UNIT_CONFIG_WORD(Field)		FLASH_READ_WORD(UNIT_CONFIG_ADDRESS + offsetof(UnitConfigBlock, Field))
+
+#define		CFG_TICK_CONSTANT				UNIT_CONFIG_WORD(TickConstant)
+#define		CFG_TICKS_BEFORE_SAMPLE_DAY		UNIT_CONFIG_BYTE(TicksBeforeSampleDay)
+#define		CFG_TICKS_BEFORE_SAMPLE_NIGHT	UNIT_CONFIG_BYTE(TicksBeforeSampleNight)
+#define		CFG_DARK_THRESHOLD				UNIT_CONFIG_BYTE(DarkThreshold)
+#define		CFG_LIGHT_THRESHOLD				UNIT_CONFIG_BYTE(LightThreshold)
+#define		CFG_MINIMUM_AFTERGLOW			UNIT_CONFIG_WORD(MinimumAfterglow)
+#define		CFG_MAXIMUM_AFTERGLOW			UNIT_CONFIG_WORD(MaximumAfterglow)
+#define		CFG_LIMITATION_THRESHOLD1		UNIT_CONFIG_WORD(LimitationThreshold1)
+#define		CFG_LIMITATION_THRESHOLD2		UNIT_CONFIG_WORD(LimitationThreshold2)
+#define		CFG_LIMITATION_PWM1				UNIT_CONFIG_BYTE(LimitationPwm1)
+#define		CFG_LIMITATION_PWM2				UNIT_CONFIG_BYTE(LimitationPwm2)
+
+#if (TICKS_BEFORE_SAMPLE_DAY > 255) || (TICKS_BEFORE_SAMPLE_NIGHT > 255)
+#error "The unit configuration block holds TICKS_BEFORE_SAMPLE_DAY and _NIGHT in a byte each"
+#endif
+#ifdef USE_DUSK_RAMP
+#error "USE_DUSK_RAMP folds DARK_THRESHOLD into its slope at compile time, it can't be used with USE_UNIT_CONFIG_BLOCK"
+#endif
+#ifndef UNIT_CONFIG_LINKED
+#error "USE_UNIT_CONFIG_BLOCK needs .unitconfig placed at UNIT_CONFIG_ADDRESS, build the ReleaseUnitConfig configuration or see SolarConfig.h"
+#endif
+#else
+#define		CFG_TICK_CONSTANT				TICK_CONSTANT
+#define		CFG_TICKS_BEFORE_SAMPLE_DAY		TICKS_BEFORE_SAMPLE_DAY
+#define		CFG_TICKS_BEFORE_SAMPLE_NIGHT	TICKS_BEFORE_SAMPLE_NIGHT
+#define		CFG_DARK_THRESHOLD				DARK_THRESHOLD
+#define		CFG_LIGHT_THRESHOLD				LIGHT_THRESHOLD
+#define		CFG_MINIMUM_AFTERGLOW			MINIMUM_AFTERGLOW_MINUTES
+#define		CFG_MAXIMUM_AFTERGLOW			MAXIMUM_AFTERGLOW_MINUTES
+#define		CFG_LIMITATION_THRESHOLD1		AFTERGLOW_LIMITATION_THRESHOLD1_INTERNAL
+#define		CFG_LIMITATION_THRESHOLD2		AFTERGLOW_LIMITATION_THRESHOLD2_INTERNAL
+#define		CFG_LIMITATION_PWM1				AFTERGLOW_LIMITATION_PWM1_INTERNAL
+#define		CFG_LIMITATION_PWM2				AFTERGLOW_LIMITATION_PWM2_INTERNAL
+#endif // USE_UNIT_CONFIG_BLOCK
+
 #define		FLAG_SLOWTURNOFF			0x01
 #define		FLAG_LASTMODE_WAS_DAY		0x02
 #define		FLAG_LIGHTISON				0x04
 #define		FLAG_SET_SLEEP				0x08
 #define		FLAG_RUNNING_DAY			0x10
 #define		FLAG_PWM_OPERATONAL			0x20
+#define		FLAG_FIRST_DAY				0x40 // Set from power-up until the first switch to night mode (EEPROM history or cold start only)
+#define		FLAG_MORNING_LIGHT			0x80 // The pre-dawn light is on, in day mode
 
 #endif // __SOLAR_COUNTER_H__
\ No newline at end of file
@@ -0,0 +1,195 @@
+/*
+ * SolarTarget.h
+ *
+ * Created: 18-10-2026 09:12:10
+ *  Author: agent
+ *  (c) 2026, building on SolarCounter by Robert van Leeuwen, (c) 2014 Asmyldof, the Netherlands (see notice below)
+ *
+ * This code is made available under MIT license (see copyright notice below). 
+ *
+ * Register mapping for the parts the firmware can be built for. The code is written against the
+ * ATtiny10, this file maps the few registers and bits that differ on the 8 pin ATtiny13A and
+ * ATtiny25/45/85 onto names SolarCounter.h and the main C file use. The part is picked up from
+ * the compiler (-mmcu), so the same source builds for all of them, for example:
+ *   avr-gcc -mmcu=attiny85 -Os -o SolarCounter.elf SolarCounter-Tiny10.c
+ *
+ * Things to keep in mind when moving to one of the 8 pin parts:
+ *   - PB0 and PB1 have no ADC there, so the sensor has to move (see PORTB_SENSOR_PIN in
+ *     SolarConfig.h). The ADC channel and digital input disable bit follow from the pin.
+ *   - The clock source is set with the CKSEL fuses. SYSTEM_CLOCK only tells the code what the
+ *     fuses select, the prescaler is still set at start-up from CLOCK_PRESCALER.
+ *   - Standby sleep does not exist, SLEEP_MODE 4 falls back to Power-Down.
+ *   - The ADC is 10 bit, it is left adjusted so ADCH holds the same 8 bit reading the ATtiny10
+ *     gives in ADCL.
+ *   - They have EEPROM, see USE_EEPROM_HISTORY in SolarConfig.h.
+ *
+ * CHANGING THE DEFINES AND SET-UPs IN THIS FILE IS NOT PART OF GENERAL CONFIGURATION!
+ *       ANY CHANGE MADE HERE SHOULD BE PART OF A DESIGN CONSIDERATION!
+ */ 
+
+/* Copyright Notice:
+ *
+ * You are free to use this code in any of your own designs, whether free-ware or not. You are allowed
+ * to use it to make buckets and buckets of money. While I would appreciate you pay me a bucket or
+ * two if you do, you are in no way obligated. But you might end up with a great help-desk if you do ;-).
+ *
+ *  ---> But, there's rules! (All rules carry the "Without prior written consent" label, there's always exceptions possible)
+ * One: You MUST include this entire notice in the source files that include ANY of my work.
+ * Two: Your end-product must contain a reference/dedication to me and preferably my website.
+ * Three: Any assistance with any or all of this code may be subject to billing, contact me to find out.
+ * Four: You realise that NONE of this code comes with any guarantee when used in your own application
+ * Five: You do not use me, my site or my work to promote your own projects using, or not using, this code.
+ * Six: You get at least some manner of joy out of using this. Or at least try to.
+ *
+ *  COPYRIGHT: Robert van Leeuwen, Asmyldof, 2014.
+ *                      http://www.asmyldof.com
+ *                      git-open@asmyldof.com
+ */
+
+
+#ifndef __SOLAR_TARGET_H__
+#define __SOLAR_TARGET_H__
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ *  Per part registers
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#if defined(__AVR_ATtiny10__)
+#define		TARGET_CLOCK_BY_SOFTWARE			// CCP protected CLKMSR/CLKPSR, source can be switched at run time
+#define		TARGET_TIMER0_16BIT					// OCR0x are high/low pairs, 8 bit fast PWM is WGM 0101
+#define		TARGET_HAS_STANDBY
+#define		TARGET_RC_OSCILLATOR_HZ		8000000UL
+#define		TARGET_EEPROM_BYTES			0
+#define		TARGET_RAM_BYTES			32
+#define		TARGET_FLASH_MAPPED					// The flash shows up in the data space, read with LD in stead of LPM
+
+#define		WDT_CONTROL_REGISTER		WDTCSR
+#define		WDT_INTERRUPT_ENABLE		WDIE
+#define		WDT_WRITE(Value)			WDTCSR = (Value)
+
+#define		SLEEP_CONTROL_REGISTER		SMCR
+#define		SLEEP_MODE_SHIFT			1	// SM2..0 in bits 3..1
+#define		SLEEP_ENABLE				(1<<SE)
+
+#define		TIMER0_INT_MASK_REGISTER	TIMSK0
+#define		TIMER0_INT_FLAG_REGISTER	TIFR0
+#define		PIN_CHANGE_CONTROL_REGISTER	PCICR
+#define		PIN_CHANGE_ENABLE			(1<<PCIE0)
+#define		PIN_CHANGE_FLAG_REGISTER	PCIFR
+#define		PIN_CHANGE_FLAG				(1<<PCIF0)
+#define		TCCR0A_FAST_PWM8			0b00000001 // WGM00, with WGM02 in TCCR0B
+#define		TCCR0B_FAST_PWM8			0b00001000
+#define		TCCR0A_FAST_PWM_TOP			0b00000010 // WGM 1110: WGM01, with WGM03 and WGM02 in TCCR0B, TOP in ICR0
+#define		TCCR0B_FAST_PWM_TOP			0b00011000
+#define		TCCR0A_PHASE_PWM8			0b00000001 // WGM 0001: WGM00
+#define		TCCR0B_PHASE_PWM8			0b00000000
+#define		TCCR0A_PHASE_PWM_TOP		0b00000010 // WGM 1010: WGM01, with WGM03 in TCCR0B, TOP in ICR0
+#define		TCCR0B_PHASE_PWM_TOP		0b00010000
+#define		PWM_TOP_WRITE(Value)		do { ICR0H = 0; ICR0L = (Value); } while(0)
+
+#define		ADC_RESULT_REGISTER			ADCL
+#define		ADMUX_ADJUST				0x00	// 8 bit ADC, nothing to adjust
+
+// ADCn is on PBn:
+#if (PORTB_SENSOR_PIN == (1<<PORTB0))
+	#define		ADC_SENSOR_CHANNEL		0
+#elif (PORTB_SENSOR_PIN == (1<<PORTB1))
+	#define		ADC_SENSOR_CHANNEL		1
+#elif (PORTB_SENSOR_PIN == (1<<PORTB2))
+	#define		ADC_SENSOR_CHANNEL		2
+#elif (PORTB_SENSOR_PIN == (1<<PORTB3))
+	#define		ADC_SENSOR_CHANNEL		3
+#else
+#error "Configured sensor pin is not an ADC input."
+#endif
+
+#elif defined(__AVR_ATtiny13A__) || defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
+#if defined(__AVR_ATtiny13A__)
+#define		TARGET_RC_OSCILLATOR_HZ		9600000UL // With CKSEL at 10, the default. 4.8MHz (01) is set with SYSTEM_CLOCK 2 and EXTERNAL_CLOCK_HZ
+#define		TIMER0_INT_MASK_REGISTER	TIMSK0
+#define		TIMER0_INT_FLAG_REGISTER	TIFR0
+#define		WDT_INTERRUPT_ENABLE		WDTIE
+#else
+#define		TARGET_RC_OSCILLATOR_HZ		8000000UL
+#define		TIMER0_INT_MASK_REGISTER	TIMSK	// Shared with Timer1, which is not used
+#define		TIMER0_INT_FLAG_REGISTER	TIFR
+#define		WDT_INTERRUPT_ENABLE		WDIE
+#endif
+#define		TARGET_EEPROM_BYTES			(E2END + 1)
+#define		TARGET_RAM_BYTES			(RAMEND - RAMSTART + 1)
+
+#define		WDT_CONTROL_REGISTER		WDTCR
+// Prescaler changes need the timed sequence, with WDE set in the first write (Value has to be a constant):
+#define		WDT_WRITE(Value)			do { WDTCR = (1<<WDCE)|(1<<WDE); WDTCR = (Value); } while(0)
+
+#define		SLEEP_CONTROL_REGISTER		MCUCR	// Also holds PUD and ISC0x, neither is used
+#define		SLEEP_MODE_SHIFT			3	// SM1..0 in bits 4..3
+#define		SLEEP_ENABLE				(1<<SE)
+
+#define		PIN_CHANGE_CONTROL_REGISTER	GIMSK
+#define		PIN_CHANGE_ENABLE			(1<<PCIE)
+#define		PIN_CHANGE_FLAG_REGISTER	GIFR
+#define		PIN_CHANGE_FLAG				(1<<PCIF)
+
+#define		TCCR0A_FAST_PWM8			0b00000011 // WGM01 and WGM00, WGM02 stays 0
+#define		TCCR0B_FAST_PWM8			0b00000000
+#define		TCCR0A_FAST_PWM_TOP			0b00000011 // WGM 111: with WGM02 in TCCR0B, TOP in OCR0A
+#define		TCCR0B_FAST_PWM_TOP			0b00001000
+#define		TCCR0A_PHASE_PWM8			0b00000001 // WGM 001: WGM00
+#define		TCCR0B_PHASE_PWM8			0b00000000
+#define		TCCR0A_PHASE_PWM_TOP		0b00000001 // WGM 101: with WGM02 in TCCR0B, TOP in OCR0A
+#define		TCCR0B_PHASE_PWM_TOP		0b00001000
+#define		TARGET_PWM_TOP_IS_OCR0A				// So with a TOP other than 0xFF only OC0B is left for the LED
+#define		PWM_TOP_WRITE(Value)		OCR0A = (Value)
+
+#define		ADC_RESULT_REGISTER			ADCH
+#define		ADMUX_ADJUST				(1<<ADLAR) // Left adjust, the top 8 bits in ADCH. VCC reference.
+
+// ADC0 is on PB5 (reset), ADC1 on PB2, ADC2 on PB4 and ADC3 on PB3:
+#if (PORTB_SENSOR_PIN == (1<<PORTB5))
+	#define		ADC_SENSOR_CHANNEL		0
+#elif (PORTB_SENSOR_PIN == (1<<PORTB2))
+	#define		ADC_SENSOR_CHANNEL		1
+#elif (PORTB_SENSOR_PIN == (1<<PORTB4))
+	#define		ADC_SENSOR_CHANNEL		2
+#elif (PORTB_SENSOR_PIN == (1<<PORTB3))
+	#define		ADC_SENSOR_CHANNEL		3
+#else
+#error "Configured sensor pin is not an ADC input. On this part PB0 and PB1 have no ADC, try PB4."
+#endif
+
+#else
+#error "Unsupported part, the firmware builds for the ATtiny10, ATtiny13A and ATtiny25/45/85"
+#endif
+
+// On all parts the ADCnD bit in DIDR0 sits at the position of the pin it belongs to:
+#define		ADC_DIDR_SENSOR_PIN			PORTB_SENSOR_PIN
+// And so does PCINTn in PCMSK:
+#define		PCMSK_MOTION_PIN			PORTB_MOTION_PIN
+
+// Reading constants at a fixed flash address (byte address, from 0):
+#define		TARGET_FLASH_BYTES			(FLASHEND + 1)
+#ifdef		TARGET_FLASH_MAPPED
+#ifndef		MAPPED_FLASH_START
+#define		MAPPED_FLASH_START			0x4000
+#endif
+#define		FLASH_READ_BYTE(Address)	(*(const uint8_t *)(MAPPED_FLASH_START + (Address)))
+#define		FLASH_READ_WORD(Address)	(*(const uint16_t *)(MAPPED_FLASH_START + (Address)))
+#else
+#define		FLASH_READ_BYTE(Address)	pgm_read_byte(Address)	// LPM, needs <avr/pgmspace.h>
+#define		FLASH_READ_WORD(Address)	pgm_read_word(Address)
+#endif
+
+// Variables at a fixed data space address, outside of what the linker places:
+#ifndef		DATA_SPACE_START
+#define		DATA_SPACE_START			0
+#endif
+#define		DATA_AT(Type, Address)		(*(Type *)(DATA_SPACE_START + (Address)))
+
+// Data space address of the end of .data and .bss, the linker's __bss_end:
+#ifndef		BSS_END_ADDRESS
+#define		BSS_END_ADDRESS				((uint16_t)(uintptr_t)&__bss_end)
+#endif
+
+#endif // __SOLAR_TARGET_H__